@@ -0,0 +1,70 @@
+//
+//  ActiveNodes.cxx
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 18/07/16.
+//
+//
+
+#include "ActiveNodes.h"
+#include <assert.h>
+#include <cstddef>
+#include "Internal/Node.h"
+#include "Internal/Nodes.h"
+
+
+ActiveNodes::ActiveNodes(Nodes* nodes) {
+    _nodes = nodes;
+    _first = NODE_NONE;
+    _last = NODE_NONE;
+}
+
+
+ActiveNodes::~ActiveNodes() {
+    _nodes = NULL;
+}
+
+
+void ActiveNodes::Push(NodeIndex index) {
+    Node node = _nodes->GetNode(index);
+    if (node.active) {
+        return;
+    }
+    node.active = true;
+    node.nextActive = NODE_NONE;
+    if (_last == NODE_NONE) {
+        _first = index;
+    } else {
+        _nodes->GetNode(_last).nextActive = index;
+    }
+    _last = index;
+}
+
+
+NodeIndex ActiveNodes::GetFront() {
+    return _first;
+}
+
+
+void ActiveNodes::Pop() {
+    assert(_first != NODE_NONE);
+    Node node = _nodes->GetNode(_first);
+    _first = node.nextActive;
+    if (_first == NODE_NONE) {
+        _last = NODE_NONE;
+    }
+    node.active = false;
+    node.nextActive = NODE_NONE;
+}
+
+
+bool ActiveNodes::IsEmpty() {
+    return _first == NODE_NONE;
+}
+
+
+void ActiveNodes::Clear() {
+    while (!IsEmpty()) {
+        Pop();
+    }
+}
@@ -0,0 +1,64 @@
+//
+//  ActiveNodes.h
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 18/07/16.
+//
+//
+
+#ifndef ActiveNodes_h
+#define ActiveNodes_h
+
+#include "vtkGraphCutDataTypes.h"
+
+
+class Nodes;
+
+
+/**
+ * ActiveNodes is a first-in first-out list of the active nodes of
+ * a tree. The list is intrusive: the link to the next node is stored
+ * in the nextActive property of each node, and the active property
+ * tells whether a node is in a list. A node is therefore never in
+ * the list more than once, and pushing and popping take constant time
+ * and never allocate.
+ */
+class ActiveNodes {
+public:
+    ActiveNodes(Nodes* nodes);
+    ~ActiveNodes();
+    
+    /**
+     * Appends the node at @p index to the end of the list, unless
+     * it is already active.
+     */
+    void Push(NodeIndex index);
+    
+    /**
+     * Returns the first node of the list or NODE_NONE if the
+     * list is empty.
+     */
+    NodeIndex GetFront();
+    
+    /**
+     * Removes the first node from the list and marks it inactive.
+     */
+    void Pop();
+    
+    /**
+     * Returns true iff there are no nodes in the list.
+     */
+    bool IsEmpty();
+    
+    /**
+     * Removes all nodes from the list.
+     */
+    void Clear();
+    
+protected:
+    Nodes* _nodes;
+    NodeIndex _first;
+    NodeIndex _last;
+};
+
+#endif /* ActiveNodes_h */
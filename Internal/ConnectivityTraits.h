@@ -0,0 +1,62 @@
+//
+//  ConnectivityTraits.h
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 18/07/16.
+//
+//
+
+#ifndef ConnectivityTraits_h
+#define ConnectivityTraits_h
+
+#include "vtkGraphCutDefinitions.h"
+
+
+/**
+ * ConnectivityTraits describes a connectivity at compile time so
+ * that the solver kernels can be instantiated for each connectivity
+ * without runtime switches in their neighbour loops.
+ *
+ * NumberOfNeighbours is the number of neighbours of a node that does
+ * not lie on the border of the volume. IsConnected returns true iff a
+ * node at offset (x, y, z) is a neighbour; x, y and z should be
+ * either -1, 0 or 1.
+ */
+template <vtkConnectivity Connectivity>
+struct ConnectivityTraits;
+
+
+template <>
+struct ConnectivityTraits<SIX>
+{
+    enum { NumberOfNeighbours = 6 };
+
+    static bool IsConnected(int x, int y, int z) {
+        return (x != 0) + (y != 0) + (z != 0) == 1;
+    }
+};
+
+
+template <>
+struct ConnectivityTraits<EIGHTEEN>
+{
+    enum { NumberOfNeighbours = 18 };
+
+    static bool IsConnected(int x, int y, int z) {
+        int distance = (x != 0) + (y != 0) + (z != 0);
+        return distance == 1 || distance == 2;
+    }
+};
+
+
+template <>
+struct ConnectivityTraits<TWENTYSIX>
+{
+    enum { NumberOfNeighbours = 26 };
+
+    static bool IsConnected(int x, int y, int z) {
+        return x != 0 || y != 0 || z != 0;
+    }
+};
+
+#endif /* ConnectivityTraits_h */
@@ -10,6 +10,7 @@
 #define Edge_h
 
 #include <stdio.h>
+#include <assert.h>
 #include "vtkGraphCutDataTypes.h"
 
 
@@ -22,87 +23,150 @@
  * The capacity and flow are dependent on the direction,
  * so use the methods *fromNode to manipulate these
  * values.
+ *
+ * Edge is a lightweight accessor: it does not own any
+ * storage but points to the two residual capacities of
+ * the edge in the arc array of Edges. The first residual
+ * is the arc from node1 to node2 and the second one is
+ * the reverse arc. The flow is not stored, but follows from
+ * the difference between both residuals.
  */
 class Edge
 {
 public:
-    Edge(NodeIndex firstNode, NodeIndex secondNode);
+    /**
+     * Creates an invalid edge.
+     */
+    Edge() {
+        _node1 = NODE_NONE;
+        _node2 = NODE_NONE;
+        _residuals = NULL;
+    }
+    
+    /**
+     * Creates an edge between two nodes of which the
+     * residual capacities are stored in the two ints
+     * at @p residuals.
+     */
+    Edge(NodeIndex firstNode, NodeIndex secondNode, int* residuals) {
+        _node1 = firstNode;
+        _node2 = secondNode;
+        _residuals = residuals;
+    }
     
     /**
      * Returns node1 as an index.
      */
-    NodeIndex node1();
+    NodeIndex node1() {
+        return _node1;
+    }
     
     /**
      * Returns node2 as an index.
      */
-    NodeIndex node2();
+    NodeIndex node2() {
+        return _node2;
+    }
     
     /**
      * Returns the non-root node when this edge
      * is a terminal node. Otherwise returns INVALID.
      */
-    NodeIndex nonRootNode();
+    NodeIndex nonRootNode() {
+        assert(isTerminal());
+        assert(isValid());
+        return _node1 < 0 ? _node2 : _node1;
+    }
     
     /**
      * Returns the root node when this edge is a
      * terminal node. Otherwise returns INVALID.
      */
-    NodeIndex rootNode();
+    NodeIndex rootNode() {
+        assert(isTerminal());
+        assert(isValid());
+        return _node1 < 0 ? _node1 : _node2;
+    }
     
     /**
      * Returns the node that is not equal to @p node.
      * When neither node is equal, then NODE_NONE is returned.
      */
-    NodeIndex otherNode(NodeIndex node);
+    NodeIndex otherNode(NodeIndex node) {
+        if (_node1 == node) {
+            return _node2;
+        }
+        if (_node2 == node) {
+            return _node1;
+        }
+        return NODE_NONE;
+    }
     
     /**
      * Returns whether this edge is connected to eiter a
      * SOURCE or a SINK node.
      */
-    bool isTerminal();
+    bool isTerminal() {
+        return _node1 == NODE_SINK || _node1 == NODE_SOURCE || _node2 == NODE_SINK || _node2 == NODE_SOURCE;
+    }
     
     /**
      * Returns true iff both nodes are not NODE_NONE.
      */
-    bool isValid();
+    bool isValid() {
+        return _node1 != NODE_NONE && _node2 != NODE_NONE && _residuals != NULL;
+    }
     
     /**
      * Set the total capacity that this edge can hold.
      * This capacity is the max capacity in both directions.
      */
-    void setCapacity(int capacity);
+    void setCapacity(int capacity) {
+        int flow = flowFromNode(_node1);
+        _residuals[0] = capacity - flow;
+        _residuals[1] = capacity + flow;
+    }
     
     /**
      * Adds the given amount of flow to the current flow
      * from the direction of the given node.
      */
-    void addFlowFromNode(NodeIndex node, int addedFlow);
+    void addFlowFromNode(NodeIndex node, int addedFlow) {
+        assert(node == _node1 || node == _node2);
+        assert(capacityFromNode(node) >= addedFlow);
+        int forward = node == _node1 ? 0 : 1;
+        _residuals[forward] -= addedFlow;
+        _residuals[1 - forward] += addedFlow;
+    }
     
     /**
      * Returns whether the edge is saturated as seen from
      * the given node.
      */
-    bool isSaturatedFromNode(NodeIndex node);
+    bool isSaturatedFromNode(NodeIndex node) {
+        return capacityFromNode(node) == 0;
+    }
     
     /**
      * Returns the current flow from a give node.
      */
-    int flowFromNode(NodeIndex node);
+    int flowFromNode(NodeIndex node) {
+        int flow = (_residuals[1] - _residuals[0]) / 2;
+        return node == _node1 ? flow : -flow;
+    }
     
     /**
      * Returns the capacity of the edge that is left
      * in the given direction.
      */
-    int capacityFromNode(NodeIndex node);
+    int capacityFromNode(NodeIndex node) {
+        return _residuals[node == _node1 ? 0 : 1];
+    }
     
 protected:
-    // Current flow through edge
-    // Positive means from node1 to node2, negative from node2 to node1
     NodeIndex _node1;
     NodeIndex _node2;
-    int _capacity;
-    int _flow;
+    int* _residuals;
 };
 
 
@@ -11,11 +11,29 @@
 #include "Nodes.h"
 #include <assert.h>
 #include <iostream>
+#include <algorithm>
+
+
+/**
+ * Returns the number of bits that are set in @p bits.
+ */
+static inline int CountBits(unsigned int bits) {
+    bits = bits - ((bits >> 1) & 0x55555555);
+    bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+    return (int)((((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+}
 
 
 Edges::Edges() {
     _nodes = NULL;
-    _edges = NULL;
+    _residuals = NULL;
+    _indicesForVoxels = NULL;
+    _voxelsForIndices = NULL;
+    _size = 0;
+    _numberOfForwardOffsets = 0;
+    _dimensions[0] = 0;
+    _dimensions[1] = 0;
+    _dimensions[2] = 0;
     _dirty = true;
 }
 
@@ -47,50 +65,76 @@ void Edges::Update() {
         return;
     }
 
-    _edges = CreateEdgesForNodes(_nodes);
+    CreateEdgesForNodes(_nodes);
     _dirty = false;
 }
 
 
 void Edges::Reset() {
     _nodes = NULL;
-    if (_edges) {
-        for (std::vector<Edge*>::iterator i = _edges->begin(); i != _edges->end(); ++i) {
-            delete *i;
-        }
-        delete _edges;
-    }
-    _edges = NULL;
+    DeleteEdges();
     _dirty = true;
 }
 
 
-Edge* Edges::GetEdge(EdgeIndex index) {
-    if (!_edges || index >= _edges->size() || index < 0) {
-        return NULL;
+Edge Edges::GetEdge(EdgeIndex index) {
+    if (!_residuals || index >= _size || index < 0) {
+        return Edge();
     }
-    return _edges->at(index);
-}
-
-
-int Edges::GetSize() {
-    return _edges->size();
-}
-
-
-std::vector<Edge*>::iterator Edges::GetBegin() {
-    return _edges->begin();
+    
+    // Find the node that owns the edge: the last node of which
+    // the first edge does not come after the requested edge
+    int first = 0;
+    int last = NumberOfNodes() - 1;
+    while (first < last) {
+        int middle = first + (last - first + 1) / 2;
+        if (FirstEdgeIndexForNode((NodeIndex)middle) <= index) {
+            first = middle;
+        } else {
+            last = middle - 1;
+        }
+    }
+    
+    NodeIndex node = (NodeIndex)first;
+    int* residuals = _residuals + 2 * (size_t)index;
+    int slot = (int)(index - FirstEdgeIndexForNode(node));
+    if (slot == 0) {
+        return Edge(NODE_SOURCE, node, residuals);
+    }
+    if (slot == 1) {
+        return Edge(node, NODE_SINK, residuals);
+    }
+    
+    int voxel = VoxelForIndex(node);
+    int coordinate[3];
+    CoordinateForIndex(voxel, coordinate);
+    for (int i = 0; i < _numberOfForwardOffsets; ++i) {
+        if (SlotForForwardOffset(node, coordinate, i) == slot) {
+            int* offset = _forwardOffsets[i];
+            int neighbour = voxel + offset[0]
+                + offset[1] * _dimensions[0]
+                + offset[2] * _dimensions[0] * _dimensions[1];
+            if (_indicesForVoxels) {
+                return Edge(node, _indicesForVoxels[neighbour], residuals);
+            }
+            return Edge(node, (NodeIndex)neighbour, residuals);
+        }
+    }
+    
+    assert(false);
+    return Edge();
 }
 
 
-std::vector<Edge*>::iterator Edges::GetEnd() {
-    return _edges->end();
+EdgeIndex Edges::GetSize() {
+    return _size;
 }
 
 
 EdgeIndex Edges::IndexForEdgeFromNodeToNode(NodeIndex sourceIndex, NodeIndex targetIndex) {
     assert(sourceIndex != NODE_NONE);
     assert(targetIndex != NODE_NONE);
+    assert(_residuals);
     
     int from;
     int to;
@@ -105,84 +149,112 @@ EdgeIndex Edges::IndexForEdgeFromNodeToNode(NodeIndex sourceIndex, NodeIndex tar
         to = std::max(sourceIndex, targetIndex);
     }
     
-    int* dimensions = _nodes->GetDimensions();
+    int numberOfNodes = NumberOfNodes();
     assert(from >= 0);
-    assert(from < dimensions[0] * dimensions[1] * dimensions[2]);
+    assert(from < numberOfNodes);
+    
+    int fromCoordinate[3];
+    CoordinateForIndex(VoxelForIndex((NodeIndex)from), fromCoordinate);
     
-    int index = 0;
+    // The edges of a node are ordered as: source, sink and then
+    // the edges to the neighbours with a higher index
+    if (to == NODE_SOURCE) {
+        return FirstEdgeIndexForNode((NodeIndex)from);
+    }
+    if (to == NODE_SINK) {
+        return (EdgeIndex)(FirstEdgeIndexForNode((NodeIndex)from) + 1);
+    }
     
-    Edge* edge = _edges->at(index);
-    while (!((edge->node1() == from && edge->node2() == to) || (edge->node1() == to && edge->node2() == from))) {
-        ++index;
-        if (index >= _edges->size()) {
-            break;
+    if (to >= numberOfNodes) {
+        return EDGE_NONE;
+    }
+    int toCoordinate[3];
+    CoordinateForIndex(VoxelForIndex((NodeIndex)to), toCoordinate);
+    
+    int lookup = 0;
+    int factor = 1;
+    for (int i = 0; i < 3; ++i) {
+        int offset = toCoordinate[i] - fromCoordinate[i];
+        if (offset < -1 || offset > 1) {
+            return EDGE_NONE;
         }
-        edge = _edges->at(index);
+        lookup += (offset + 1) * factor;
+        factor *= 3;
     }
     
-    if ((edge->node1() == from && edge->node2() == to) || (edge->node2() == from && edge->node1() == to)) {
-        return (EdgeIndex)index;
+    int forwardOffset = _forwardOffsetLookup[lookup];
+    if (forwardOffset < 0) {
+        return EDGE_NONE;
     }
-
-    return EDGE_NONE;
+    
+    int slot = SlotForForwardOffset((NodeIndex)from, fromCoordinate, forwardOffset);
+    assert(slot >= 0);
+    
+    return (EdgeIndex)(FirstEdgeIndexForNode((NodeIndex)from) + slot);
 }
 
 
-Edge* Edges::EdgeFromNodeToNode(NodeIndex sourceIndex, NodeIndex targetIndex) {
+Edge Edges::EdgeFromNodeToNode(NodeIndex sourceIndex, NodeIndex targetIndex) {
     assert(sourceIndex != NODE_NONE);
     assert(targetIndex != NODE_NONE);
-    int index = IndexForEdgeFromNodeToNode(sourceIndex, targetIndex);
-    if (index >= 0) {
-        assert(_edges->at(index)->isValid());
-        return _edges->at(index);
-    }
-
-    return NULL;
-}
-
-
-std::vector<Edge*>* Edges::CreateEdgesForNodes(Nodes* nodes) {
-    std::vector<Edge*>* result = new std::vector<Edge*>();
-    
-    int numberOfNodes = nodes->GetSize();
-    int numberOfEdges = numberOfNodes * 2 + numberOfNodes * NumberOfEdgesForConnectivity(nodes->GetConnectivity());
-
-    assert(numberOfEdges >= 0);
-    result->reserve(numberOfEdges);
-    
-    for (int index = 0; index < numberOfNodes; ++index) {
-        Edge* sourceEdge = new Edge(NODE_SOURCE, (NodeIndex)index);
-        result->push_back(sourceEdge);
-        
-        Edge* sinkEdge = new Edge((NodeIndex)index, NODE_SINK);
-        result->push_back(sinkEdge);
-        
-        int coordinate[3] = {0, 0, 0};
-        nodes->GetCoordinateForIndex((NodeIndex)index, coordinate);
-        int coord[3] = {0, 0, 0};
-        for (int z = -1; z <= 1; ++z) {
-            for (int y = -1; y <= 1; ++y) {
-                for (int x = -1; x <= 1; ++x) {
-                    coord[0] = coordinate[0]+x;
-                    coord[1] = coordinate[1]+y;
-                    coord[2] = coordinate[2]+z;
-                    if (nodes->IsNodeAtOffsetConnected(x, y, z)) {
-                        NodeIndex neighbour_index = nodes->IsValidCoordinate(coord) ? nodes->GetIndexForCoordinate(coord) : NODE_NONE;
-                        if (neighbour_index < index) {
-                            neighbour_index = NODE_NONE;
-                        }
-                        
-                        if (neighbour_index != NODE_NONE) {
-                            Edge* nodeEdge = new Edge((NodeIndex)index, neighbour_index);
-                            result->push_back(nodeEdge);
-                        }
-                    }
-                }
-            }
-        }
+    EdgeIndex index = IndexForEdgeFromNodeToNode(sourceIndex, targetIndex);
+    if (index < 0) {
+        return Edge();
+    }
+    
+    int* residuals = _residuals + 2 * (size_t)index;
+    if (sourceIndex == NODE_SOURCE || targetIndex == NODE_SOURCE) {
+        return Edge(NODE_SOURCE, (NodeIndex)std::max(sourceIndex, targetIndex), residuals);
+    }
+    if (sourceIndex == NODE_SINK || targetIndex == NODE_SINK) {
+        return Edge((NodeIndex)std::max(sourceIndex, targetIndex), NODE_SINK, residuals);
+    }
+    return Edge((NodeIndex)std::min(sourceIndex, targetIndex),
+                (NodeIndex)std::max(sourceIndex, targetIndex),
+                residuals);
+}
+
+
+ArcIndex Edges::ArcFromNodeToNode(NodeIndex fromIndex, NodeIndex toIndex) {
+    EdgeIndex index = IndexForEdgeFromNodeToNode(fromIndex, toIndex);
+    if (index < 0) {
+        return ARC_NONE;
+    }
+    
+    // The first arc of an edge starts at the source, ends at
+    // the sink or runs from the lowest to the highest index
+    bool forward = fromIndex == NODE_SOURCE
+        || toIndex == NODE_SINK
+        || (fromIndex >= 0 && toIndex >= 0 && fromIndex < toIndex);
+    return (ArcIndex)(2 * index + (forward ? 0 : 1));
+}
+
+
+void Edges::CreateEdgesForNodes(Nodes* nodes) {
+    DeleteEdges();
+    CreateAddressingTables(nodes);
+    
+    if (nodes->HasBand()) {
+        CreateBandAddressingTables(nodes);
+        _size = _firstEdges.back();
+    } else {
+        _size = _edgesBeforeSlice[_dimensions[2]];
     }
+    assert(_size >= 0);
     
-    return result;
+    _residuals = new int[2 * (size_t)_size];
+    std::fill(_residuals, _residuals + 2 * (size_t)_size, 0);
+}
+
+
+void Edges::ResetFlow() {
+    // The capacity of an edge is the mean of the residual
+    // capacities of its arcs, whatever the flow is
+    for (size_t arc = 0; arc < 2 * (size_t)_size; arc += 2) {
+        int capacity = (_residuals[arc] + _residuals[arc + 1]) / 2;
+        _residuals[arc] = capacity;
+        _residuals[arc + 1] = capacity;
+    }
 }
 
 
@@ -198,3 +270,216 @@ int Edges::NumberOfEdgesForConnectivity(vtkConnectivity connectivity) {
             return 0;
     }
 }
+
+
+EdgeIndex Edges::FirstEdgeIndexForNode(NodeIndex index) {
+    if (!_firstEdges.empty()) {
+        return _firstEdges[index];
+    }
+    assert(!_edgesBeforeSlice.empty());
+    int coordinate[3];
+    CoordinateForIndex(index, coordinate);
+    int* dimensions = _dimensions;
+    
+    int lastSlice = coordinate[2] == dimensions[2] - 1 ? 1 : 0;
+    int rowClass = (coordinate[1] == 0 ? 1 : 0)
+        | (coordinate[1] == dimensions[1] - 1 ? 2 : 0)
+        | lastSlice << 2;
+    
+    return (EdgeIndex)(_edgesBeforeSlice[coordinate[2]]
+                       + _edgesBeforeRow[lastSlice][coordinate[1]]
+                       + _edgesBeforeColumn[rowClass][coordinate[0]]);
+}
+
+
+void Edges::CreateAddressingTables(Nodes* nodes) {
+    int* dimensions = _dimensions;
+    for (int i = 0; i < 3; ++i) {
+        dimensions[i] = nodes->GetDimensions()[i];
+    }
+    
+    // Collect the connected offsets that point to a node with a
+    // higher index, ordered by their index
+    _numberOfForwardOffsets = 0;
+    for (int z = -1; z <= 1; ++z) {
+        for (int y = -1; y <= 1; ++y) {
+            for (int x = -1; x <= 1; ++x) {
+                int lookup = (x + 1) + 3 * (y + 1) + 9 * (z + 1);
+                _forwardOffsetLookup[lookup] = -1;
+                bool isForward = z > 0 || (z == 0 && y > 0) || (z == 0 && y == 0 && x > 0);
+                if (isForward && nodes->IsNodeAtOffsetConnected(x, y, z)) {
+                    _forwardOffsets[_numberOfForwardOffsets][0] = x;
+                    _forwardOffsets[_numberOfForwardOffsets][1] = y;
+                    _forwardOffsets[_numberOfForwardOffsets][2] = z;
+                    _forwardOffsetLookup[lookup] = _numberOfForwardOffsets;
+                    ++_numberOfForwardOffsets;
+                }
+            }
+        }
+    }
+    
+    // Slots of the forward edges for every combination of borders:
+    // bit 0 and 1 for the first and last column, bit 2 and 3 for the
+    // first and last row and bit 4 for the last slice
+    int edgesForKey[32];
+    _edgeSlots.assign(32 * 13, -1);
+    for (int key = 0; key < 32; ++key) {
+        int slot = 2;
+        for (int i = 0; i < _numberOfForwardOffsets; ++i) {
+            int* offset = _forwardOffsets[i];
+            bool valid = !(offset[0] < 0 && (key & 1))
+                && !(offset[0] > 0 && (key & 2))
+                && !(offset[1] < 0 && (key & 4))
+                && !(offset[1] > 0 && (key & 8))
+                && !(offset[2] > 0 && (key & 16));
+            if (valid) {
+                _edgeSlots[key * 13 + i] = slot;
+                ++slot;
+            }
+        }
+        edgesForKey[key] = slot;
+    }
+    
+    // Cumulative number of edges within a row, for every combination
+    // of first row, last row and last slice
+    for (int rowClass = 0; rowClass < 8; ++rowClass) {
+        std::vector<EdgeIndex>& columns = _edgesBeforeColumn[rowClass];
+        columns.resize(dimensions[0] + 1);
+        EdgeIndex count = 0;
+        for (int x = 0; x < dimensions[0]; ++x) {
+            columns[x] = count;
+            int coordinate[3] = {x, 0, 0};
+            int key = SlotKeyForCoordinate(coordinate) & 3;
+            key |= (rowClass & 3) << 2 | (rowClass & 4) << 2;
+            count += edgesForKey[key];
+        }
+        columns[dimensions[0]] = count;
+    }
+    
+    // Cumulative number of edges within a slice
+    for (int lastSlice = 0; lastSlice < 2; ++lastSlice) {
+        std::vector<EdgeIndex>& rows = _edgesBeforeRow[lastSlice];
+        rows.resize(dimensions[1] + 1);
+        EdgeIndex count = 0;
+        for (int y = 0; y < dimensions[1]; ++y) {
+            rows[y] = count;
+            int rowClass = (y == 0 ? 1 : 0) | (y == dimensions[1] - 1 ? 2 : 0) | lastSlice << 2;
+            count += _edgesBeforeColumn[rowClass][dimensions[0]];
+        }
+        rows[dimensions[1]] = count;
+    }
+    
+    // Cumulative number of edges in the volume
+    _edgesBeforeSlice.resize(dimensions[2] + 1);
+    EdgeIndex count = 0;
+    for (int z = 0; z < dimensions[2]; ++z) {
+        _edgesBeforeSlice[z] = count;
+        count += _edgesBeforeRow[z == dimensions[2] - 1 ? 1 : 0][dimensions[1]];
+    }
+    _edgesBeforeSlice[dimensions[2]] = count;
+}
+
+
+void Edges::CreateBandAddressingTables(Nodes* nodes) {
+    _indicesForVoxels = nodes->GetIndicesForVoxels();
+    _voxelsForIndices = nodes->GetVoxelsForIndices();
+    int* dimensions = _dimensions;
+    
+    int numberOfVoxels = dimensions[0] * dimensions[1] * dimensions[2];
+    int numberOfNodes = numberOfVoxels - (int)std::count(_indicesForVoxels, _indicesForVoxels + numberOfVoxels, NODE_NONE);
+    _firstEdges.reserve(numberOfNodes + 1);
+    _forwardNeighbours.reserve(numberOfNodes);
+    
+    // The nodes are numbered in the order of their voxels
+    EdgeIndex count = 0;
+    int voxel = 0;
+    for (int z = 0; z < dimensions[2]; ++z) {
+        for (int y = 0; y < dimensions[1]; ++y) {
+            for (int x = 0; x < dimensions[0]; ++x, ++voxel) {
+                if (_indicesForVoxels[voxel] == NODE_NONE) {
+                    continue;
+                }
+                int coordinate[3] = {x, y, z};
+                unsigned short neighbours = 0;
+                for (int i = 0; i < _numberOfForwardOffsets; ++i) {
+                    int* offset = _forwardOffsets[i];
+                    bool valid = true;
+                    for (int d = 0; d < 3; ++d) {
+                        int neighbourCoordinate = coordinate[d] + offset[d];
+                        valid = valid && neighbourCoordinate >= 0 && neighbourCoordinate < dimensions[d];
+                    }
+                    int neighbour = voxel + offset[0]
+                        + offset[1] * dimensions[0]
+                        + offset[2] * dimensions[0] * dimensions[1];
+                    if (valid && _indicesForVoxels[neighbour] != NODE_NONE) {
+                        neighbours |= 1 << i;
+                    }
+                }
+                _firstEdges.push_back(count);
+                _forwardNeighbours.push_back(neighbours);
+                count += 2 + CountBits(neighbours);
+            }
+        }
+    }
+    _firstEdges.push_back(count);
+}
+
+
+int Edges::SlotKeyForCoordinate(int* coordinate) {
+    int* dimensions = _dimensions;
+    return (coordinate[0] == 0 ? 1 : 0)
+        | (coordinate[0] == dimensions[0] - 1 ? 2 : 0)
+        | (coordinate[1] == 0 ? 4 : 0)
+        | (coordinate[1] == dimensions[1] - 1 ? 8 : 0)
+        | (coordinate[2] == dimensions[2] - 1 ? 16 : 0);
+}
+
+
+int Edges::SlotForForwardOffset(NodeIndex index, int* coordinate, int forwardOffset) {
+    if (_forwardNeighbours.empty()) {
+        return _edgeSlots[SlotKeyForCoordinate(coordinate) * 13 + forwardOffset];
+    }
+    // The edges to the neighbours that have a node follow each other
+    unsigned int neighbours = _forwardNeighbours[index];
+    if (!((neighbours >> forwardOffset) & 1)) {
+        return -1;
+    }
+    return 2 + CountBits(neighbours & ((1u << forwardOffset) - 1));
+}
+
+
+void Edges::CoordinateForIndex(int index, int* coordinate) {
+    int sliceSize = _dimensions[0] * _dimensions[1];
+    coordinate[2] = index / sliceSize;
+    int rest = index - coordinate[2] * sliceSize;
+    coordinate[1] = rest / _dimensions[0];
+    coordinate[0] = rest - coordinate[1] * _dimensions[0];
+}
+
+
+int Edges::NumberOfNodes() {
+    if (!_firstEdges.empty()) {
+        return (int)_firstEdges.size() - 1;
+    }
+    return _dimensions[0] * _dimensions[1] * _dimensions[2];
+}
+
+
+void Edges::DeleteEdges() {
+    delete [] _residuals;
+    _residuals = NULL;
+    _size = 0;
+    _numberOfForwardOffsets = 0;
+    _edgesBeforeSlice.clear();
+    for (int i = 0; i < 2; ++i) {
+        _edgesBeforeRow[i].clear();
+    }
+    for (int i = 0; i < 8; ++i) {
+        _edgesBeforeColumn[i].clear();
+    }
+    _edgeSlots.clear();
+    _indicesForVoxels = NULL;
+    _voxelsForIndices = NULL;
+    std::vector<EdgeIndex>().swap(_firstEdges);
+    std::vector<unsigned short>().swap(_forwardNeighbours);
+}
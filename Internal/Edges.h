@@ -10,15 +10,29 @@
 #define Edges_h
 
 
-class Edge;
 class Nodes;
 
 
 #include <vector>
+#include <assert.h>
+#include "Internal/Edge.h"
 #include "vtkGraphCutDefinitions.h"
 #include "vtkGraphCutDataTypes.h"
 
 
+/**
+ * Edges holds the edges of the graph that is defined by a Nodes
+ * object. Every edge consists of two directed arcs of which only the
+ * residual capacity is stored, in one flat array: the arc from node1
+ * to node2 of edge e is found at 2 * e and the reverse arc at
+ * 2 * e + 1. The nodes of an edge are implicit in the grid, so they
+ * are not stored at all. Edge objects are lightweight accessors to
+ * these arcs.
+ *
+ * When the nodes only cover a band, the first edge of every node is
+ * stored together with a bit for every neighbour with a higher index
+ * that has a node, instead of the tables for the whole grid.
+ */
 class Edges {
 public:
     // Constructors
@@ -44,57 +58,169 @@ public:
     void Reset();
     
     /**
-     * Returns edge object at the specified index or
-     * NULL if it doesn't exist.
+     * Returns edge object at the specified index or an
+     * invalid edge if it doesn't exist.
+     * The nodes of the edge are looked up with a binary search,
+     * so prefer EdgeFromNodeToNode when the nodes are known.
      */
-    Edge* GetEdge(EdgeIndex index);
+    Edge GetEdge(EdgeIndex index);
     
     /**
      * Returns the number of edges.
      */
-    int GetSize();
-    
-    /**
-     * Returns the begin iterator of the internal vector.
-     */
-    std::vector<Edge*>::iterator GetBegin();
-    
-    /**
-     * Returns the end iterator of the internal vector.
-     */
-    std::vector<Edge*>::iterator GetEnd();
+    EdgeIndex GetSize();
     
     /**
      * Returns the index for the edge that connect the node
      * at sourceIndex to the node at targetIndex. When there
      * is no valid index, returns -1.
+     * The index is computed from the coordinates of the nodes
+     * with the tables built in Update, so this is constant time.
      */
     EdgeIndex IndexForEdgeFromNodeToNode(NodeIndex sourceIndex, NodeIndex targetIndex);
     
     /**
      * Returns the edge at the index that is found by
      * IndexForEdgeFromNodeToNode. If an invalid edge is requested,
-     * then this function will return NULL.
+     * then this function will return an invalid edge.
      */
-    Edge* EdgeFromNodeToNode(NodeIndex sourceIndex, NodeIndex targetIndex);
+    Edge EdgeFromNodeToNode(NodeIndex sourceIndex, NodeIndex targetIndex);
     
     /**
-     * Creates and returns a vector of Edge objects. The amount of objects
-     * depends on the connectivity property of the Nodes object.
-     * The vector is ordered as follows: an edge from NODE_SOURCE to node,
-     * then from node to NODE_SINK and then all the other connected nodes.
+     * Returns the index of the arc that runs from the node at
+     * @p fromIndex to the node at @p toIndex, or ARC_NONE when
+     * the nodes are not connected.
      */
-    std::vector<Edge*>* CreateEdgesForNodes(Nodes*);
+    ArcIndex ArcFromNodeToNode(NodeIndex fromIndex, NodeIndex toIndex);
+    
+    /**
+     * Returns the residual capacity of the arc at @p arc.
+     */
+    int ResidualCapacityForArc(ArcIndex arc) {
+        return _residuals[arc];
+    }
+    
+    /**
+     * Pushes @p flow through the arc at @p arc, which moves
+     * capacity from the arc to its reverse.
+     */
+    void PushFlowThroughArc(ArcIndex arc, int flow) {
+        assert(_residuals[arc] >= flow);
+        _residuals[arc] -= flow;
+        _residuals[arc ^ 1] += flow;
+    }
+    
+    /**
+     * Removes all the flow from the edges, so that both arcs of
+     * every edge get back the full capacity of the edge.
+     */
+    void ResetFlow();
+    
+    /**
+     * Allocates the residual capacities for all the edges of
+     * the given nodes. The amount of edges depends on the
+     * connectivity property of the Nodes object.
+     * The edges are ordered as follows: an edge from NODE_SOURCE to node,
+     * then from node to NODE_SINK and then all the other connected nodes
+     * with a higher index.
+     */
+    void CreateEdgesForNodes(Nodes*);
     
     /**
      * Returns the number of edges for a given connectivity.
      */
     int NumberOfEdgesForConnectivity(vtkConnectivity connectivity);
     
+    /**
+     * Returns the index of the first edge of the node at @p index,
+     * which is the edge from NODE_SOURCE to that node.
+     */
+    EdgeIndex FirstEdgeIndexForNode(NodeIndex index);
+    
 protected:
-    std::vector<Edge*>* _edges;
+    /**
+     * Builds the tables that are used to calculate the index
+     * of an edge from the coordinates of its nodes. The edges of
+     * a node are ordered as: source, sink and then the edges to the
+     * neighbours with a higher index.
+     */
+    void CreateAddressingTables(Nodes* nodes);
+    
+    /**
+     * Stores the first edge and the neighbours with a higher index
+     * of every node of the band of @p nodes.
+     */
+    void CreateBandAddressingTables(Nodes* nodes);
+    
+    /**
+     * Returns the key for the table of edge slots, which depends
+     * on whether the coordinate lies on the border of the volume.
+     */
+    int SlotKeyForCoordinate(int* coordinate);
+    
+    /**
+     * Returns the slot of the edge to the neighbour at forward offset
+     * @p forwardOffset within the edges of the node at @p index, with
+     * @p coordinate the coordinate of its voxel, or -1 when the
+     * neighbour has no node.
+     */
+    int SlotForForwardOffset(NodeIndex index, int* coordinate, int forwardOffset);
+    
+    /**
+     * Calculates the coordinate of the voxel at @p index.
+     */
+    void CoordinateForIndex(int index, int* coordinate);
+    
+    /**
+     * Returns the index of the voxel of the node at @p index.
+     */
+    int VoxelForIndex(NodeIndex index) {
+        return _voxelsForIndices ? _voxelsForIndices[index] : (int)index;
+    }
+    
+    /**
+     * Returns the number of nodes that the edges are addressed for.
+     */
+    int NumberOfNodes();
+    
+    /**
+     * Frees the residual capacities and the addressing tables.
+     */
+    void DeleteEdges();
+    
     Nodes* _nodes;
     bool _dirty;
+    
+    // Residual capacities: two arcs for every edge
+    int* _residuals;
+    EdgeIndex _size;
+    int _dimensions[3];
+    
+    // Offsets to neighbours with a higher index, in the order
+    // in which their edges are laid out.
+    int _numberOfForwardOffsets;
+    int _forwardOffsets[13][3];
+    // Maps (x+1) + 3*(y+1) + 9*(z+1) to an index in _forwardOffsets
+    int _forwardOffsetLookup[27];
+    
+    // Number of edges that precede a slice, a row in a slice
+    // and a node in a row. Rows and nodes depend on whether they
+    // lie on the border of the volume.
+    std::vector<EdgeIndex> _edgesBeforeSlice;
+    std::vector<EdgeIndex> _edgesBeforeRow[2];
+    std::vector<EdgeIndex> _edgesBeforeColumn[8];
+    
+    // Slot of each forward edge within the edges of a node, or -1
+    // when the neighbour lies outside of the volume.
+    std::vector<int> _edgeSlots;
+    
+    // With a band: the tables of the nodes that map voxels to nodes
+    // and back, the first edge of every node followed by the number
+    // of edges and a bit for each forward offset that leads to a node
+    const NodeIndex* _indicesForVoxels;
+    const int* _voxelsForIndices;
+    std::vector<EdgeIndex> _firstEdges;
+    std::vector<unsigned short> _forwardNeighbours;
 };
 
 #endif /* Edges_h */
@@ -0,0 +1,193 @@
+//
+//  IncrementalBreadthFirstSearch.cxx
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 25/07/16.
+//
+//
+
+#include "IncrementalBreadthFirstSearch.h"
+#include <algorithm>
+#include <assert.h>
+#include "Internal/Edges.h"
+#include "Internal/Nodes.h"
+#include "Internal/Node.h"
+#include "Internal/NeighbourIterator.h"
+#include "Internal/Tree.h"
+#include "Internal/ActiveNodes.h"
+
+IncrementalBreadthFirstSearch::IncrementalBreadthFirstSearch(Edges* edges) {
+    _edges = edges;
+    _nodes = edges->GetNodes();
+    _sourceTree = new Tree(TREE_SOURCE, edges);
+    _sinkTree = new Tree(TREE_SINK, edges);
+    _activeSourceNodes = new ActiveNodes(_nodes);
+    _activeSinkNodes = new ActiveNodes(_nodes);
+    _sourceTree->SetActiveNodes(_activeSourceNodes);
+    _sinkTree->SetActiveNodes(_activeSinkNodes);
+    _layerDepths[0] = 1;
+    _layerDepths[1] = 1;
+}
+
+
+IncrementalBreadthFirstSearch::~IncrementalBreadthFirstSearch() {
+    delete _sourceTree;
+    delete _sinkTree;
+    delete _activeSourceNodes;
+    delete _activeSinkNodes;
+}
+
+
+template <vtkConnectivity Connectivity>
+void IncrementalBreadthFirstSearch::MaxFlow() {
+    InitializeTrees();
+
+    // Grow the tree with the smallest layer, until neither tree has
+    // nodes left to scan
+    while (true) {
+        bool sourceCanGrow = !_layers[0].empty() || !_activeSourceNodes->IsEmpty();
+        bool sinkCanGrow = !_layers[1].empty() || !_activeSinkNodes->IsEmpty();
+        if (!sourceCanGrow && !sinkCanGrow) {
+            break;
+        }
+        bool growSource = sourceCanGrow && (!sinkCanGrow || _layers[0].size() <= _layers[1].size());
+        Grow<Connectivity>(growSource ? TREE_SOURCE : TREE_SINK);
+    }
+}
+
+
+// Protected
+
+void IncrementalBreadthFirstSearch::InitializeTrees() {
+    int numberOfNodes = _nodes->GetSize();
+    for (int index = 0; index < numberOfNodes; ++index) {
+        NodeIndex nodeIndex = (NodeIndex)index;
+
+        // Push the flow that can go straight through the node
+        EdgeIndex sourceEdgeIndex = _edges->FirstEdgeIndexForNode(nodeIndex);
+        ArcIndex sourceArc = (ArcIndex)(2 * sourceEdgeIndex);
+        ArcIndex sinkArc = (ArcIndex)(2 * (sourceEdgeIndex + 1));
+        int flow = std::min(_edges->ResidualCapacityForArc(sourceArc), _edges->ResidualCapacityForArc(sinkArc));
+        if (flow > 0) {
+            _edges->PushFlowThroughArc(sourceArc, flow);
+            _edges->PushFlowThroughArc(sinkArc, flow);
+        }
+
+        if (_edges->ResidualCapacityForArc(sourceArc) > 0) {
+            _sourceTree->AddChildToParent(nodeIndex, NODE_SOURCE);
+            _layers[0].push_back(nodeIndex);
+        } else if (_edges->ResidualCapacityForArc(sinkArc) > 0) {
+            _sinkTree->AddChildToParent(nodeIndex, NODE_SINK);
+            _layers[1].push_back(nodeIndex);
+        }
+    }
+}
+
+
+template <vtkConnectivity Connectivity>
+void IncrementalBreadthFirstSearch::Grow(vtkTreeType tree) {
+    int t = tree == TREE_SOURCE ? 0 : 1;
+    ActiveNodes* activeNodes = tree == TREE_SOURCE ? _activeSourceNodes : _activeSinkNodes;
+    ActiveNodes* otherActiveNodes = tree == TREE_SOURCE ? _activeSinkNodes : _activeSourceNodes;
+
+    // Layers may hold nodes that left the tree or moved down since
+    // they were added
+    for (size_t i = 0; i < _layers[t].size(); ++i) {
+        NodeIndex index = _layers[t][i];
+        Node node = _nodes->GetNode(index);
+        if (node.tree == tree && node.depthInTree == _layerDepths[t]) {
+            Scan<Connectivity>(tree, index);
+        }
+    }
+
+    // Active nodes have to be scanned again, unless they are in the
+    // next layer already. Nodes that moved to the other tree since
+    // they were activated are handed to its list.
+    NodeIndex index = activeNodes->GetFront();
+    while (index != NODE_NONE) {
+        activeNodes->Pop();
+        Node node = _nodes->GetNode(index);
+        if (node.tree == tree) {
+            if (node.depthInTree == _layerDepths[t] + 1) {
+                _nextLayers[t].push_back(index);
+            } else {
+                Scan<Connectivity>(tree, index);
+            }
+        } else if (node.tree != TREE_NONE) {
+            otherActiveNodes->Push(index);
+        }
+        index = activeNodes->GetFront();
+    }
+
+    _layers[t].swap(_nextLayers[t]);
+    _nextLayers[t].clear();
+    ++_layerDepths[t];
+}
+
+
+template <vtkConnectivity Connectivity>
+void IncrementalBreadthFirstSearch::Scan(vtkTreeType tree, NodeIndex index) {
+    Tree* growingTree = tree == TREE_SOURCE ? _sourceTree : _sinkTree;
+    Node node = _nodes->GetNode(index);
+    FixedNeighbourIterator<Connectivity> it(_nodes, index);
+    while (!it.IsAtEnd()) {
+        NodeIndex neighbourIndex = it.GetIndex();
+        ArcIndex arc = tree == TREE_SOURCE
+            ? _edges->ArcFromNodeToNode(index, neighbourIndex)
+            : _edges->ArcFromNodeToNode(neighbourIndex, index);
+        vtkTreeType neighbourTree = _nodes->TreeForIndex(neighbourIndex);
+        if (_edges->ResidualCapacityForArc(arc) == 0 || neighbourTree == tree) {
+            it.Next();
+        } else if (neighbourTree == TREE_NONE) {
+            growingTree->AddChildToParent(neighbourIndex, index);
+            Schedule(tree, neighbourIndex);
+            it.Next();
+        } else {
+            // The trees touch. The same neighbour is tried again after
+            // augmenting, as long as the node is still in the tree at
+            // the same depth.
+            int depthInTree = node.depthInTree;
+            if (tree == TREE_SOURCE) {
+                Augment<Connectivity>(index, neighbourIndex, arc);
+            } else {
+                Augment<Connectivity>(neighbourIndex, index, arc);
+            }
+            if (node.tree != tree || node.orphan || node.depthInTree != depthInTree) {
+                return;
+            }
+        }
+    }
+}
+
+
+template <vtkConnectivity Connectivity>
+void IncrementalBreadthFirstSearch::Augment(NodeIndex sourceNode, NodeIndex sinkNode, ArcIndex arc) {
+    int flow = _edges->ResidualCapacityForArc(arc);
+    flow = _sourceTree->MaxFlowToRoot(sourceNode, flow);
+    flow = _sinkTree->MaxFlowToRoot(sinkNode, flow);
+    assert(flow > 0);
+
+    _edges->PushFlowThroughArc(arc, flow);
+    _sourceTree->PushFlowToRoot(sourceNode, flow, &_orphans);
+    _sinkTree->PushFlowToRoot(sinkNode, flow, &_orphans);
+
+    // Orphans may not end up below the layer that their tree grows next
+    _sourceTree->AdoptByDistance<Connectivity>(&_orphans, _layerDepths[0] + 1);
+    _sinkTree->AdoptByDistance<Connectivity>(&_orphans, _layerDepths[1] + 1);
+    _orphans.clear();
+}
+
+
+void IncrementalBreadthFirstSearch::Schedule(vtkTreeType tree, NodeIndex index) {
+    int t = tree == TREE_SOURCE ? 0 : 1;
+    if (_nodes->GetNode(index).depthInTree == _layerDepths[t] + 1) {
+        _nextLayers[t].push_back(index);
+    } else {
+        (tree == TREE_SOURCE ? _activeSourceNodes : _activeSinkNodes)->Push(index);
+    }
+}
+
+
+template void IncrementalBreadthFirstSearch::MaxFlow<SIX>();
+template void IncrementalBreadthFirstSearch::MaxFlow<EIGHTEEN>();
+template void IncrementalBreadthFirstSearch::MaxFlow<TWENTYSIX>();
@@ -0,0 +1,101 @@
+//
+//  IncrementalBreadthFirstSearch.h
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 25/07/16.
+//
+//
+
+#ifndef IncrementalBreadthFirstSearch_h
+#define IncrementalBreadthFirstSearch_h
+
+#include "vtkGraphCutDataTypes.h"
+#include "vtkGraphCutDefinitions.h"
+#include <vector>
+
+
+class Edges;
+class Nodes;
+class Tree;
+class ActiveNodes;
+
+
+/**
+ * IncrementalBreadthFirstSearch calculates a maximum flow with the
+ * incremental breadth-first search (IBFS) algorithm of Goldberg et al.
+ * Like the augmenting path solver it grows a source and a sink tree
+ * until they touch, but the trees are grown one whole layer at a time
+ * and the depth of every node is kept exact. The augmenting paths are
+ * therefore always shortest paths, which makes the running time depend
+ * much less on the structure of the paths.
+ *
+ * The depths are kept by Tree::AdoptByDistance: orphans stay at their
+ * depth when they can, move down otherwise and become free when they
+ * would end up below the layer that is grown. Nodes that have to be
+ * scanned again after an adoption are kept in the active nodes of
+ * their tree.
+ */
+class IncrementalBreadthFirstSearch {
+public:
+    IncrementalBreadthFirstSearch(Edges* edges);
+    ~IncrementalBreadthFirstSearch();
+
+    /**
+     * Calculates a maximum flow for nodes with the given @p Connectivity,
+     * starting from a zero flow and free nodes. Afterwards the trees of
+     * the nodes are the sides of the minimum cut, like those of the
+     * augmenting path solver.
+     * Instantiated for SIX, EIGHTEEN and TWENTYSIX.
+     */
+    template <vtkConnectivity Connectivity>
+    void MaxFlow();
+
+protected:
+    void InitializeTrees();
+
+    /**
+     * Scans the active nodes and the current layer of @p tree, which
+     * adds the next layer to the tree.
+     */
+    template <vtkConnectivity Connectivity>
+    void Grow(vtkTreeType tree);
+
+    /**
+     * Grows the tree into the free neighbours of the node at @p index
+     * and augments along the paths to the other tree.
+     */
+    template <vtkConnectivity Connectivity>
+    void Scan(vtkTreeType tree, NodeIndex index);
+
+    /**
+     * Pushes flow from the source through @p sourceNode, the arc
+     * @p arc and @p sinkNode to the sink and adopts the orphans.
+     */
+    template <vtkConnectivity Connectivity>
+    void Augment(NodeIndex sourceNode, NodeIndex sinkNode, ArcIndex arc);
+
+    /**
+     * Adds the node at @p index, which was just added to @p tree, to
+     * the next layer or to the active nodes, depending on its depth.
+     */
+    void Schedule(vtkTreeType tree, NodeIndex index);
+
+    Edges* _edges;
+    Nodes* _nodes;
+
+    Tree* _sourceTree;
+    Tree* _sinkTree;
+    ActiveNodes* _activeSourceNodes;
+    ActiveNodes* _activeSinkNodes;
+
+    // For the source (0) and the sink (1): the depth of the layer that
+    // is scanned next, the nodes of that layer and the nodes of the
+    // layer below it
+    int _layerDepths[2];
+    std::vector<NodeIndex> _layers[2];
+    std::vector<NodeIndex> _nextLayers[2];
+
+    std::vector<NodeIndex> _orphans;
+};
+
+#endif /* IncrementalBreadthFirstSearch_h */
@@ -0,0 +1,128 @@
+//
+//  NeighbourIterator.h
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 18/07/16.
+//
+//
+
+#ifndef NeighbourIterator_h
+#define NeighbourIterator_h
+
+#include "Internal/Nodes.h"
+#include "Internal/ConnectivityTraits.h"
+
+
+/**
+ * NeighbourIterator enumerates the indices of the neighbours of a
+ * node without allocating. It walks the precomputed offset table
+ * that Nodes keeps for the border class of the node, so every
+ * offset it visits is valid and no bounds checks are needed. When
+ * the nodes only cover a band, the voxels without a node are
+ * skipped.
+ *
+ * for (NeighbourIterator it(nodes, index); !it.IsAtEnd(); it.Next()) {
+ *     NodeIndex neighbour = it.GetIndex();
+ * }
+ */
+class NeighbourIterator
+{
+public:
+    NeighbourIterator(Nodes* nodes, NodeIndex index)
+        : _voxel(nodes->VoxelForIndex(index))
+        , _indices(nodes->GetIndicesForVoxels())
+    {
+        int borderClass = nodes->BorderClassForIndex(index);
+        _current = nodes->NeighbourOffsetsForBorderClass(borderClass);
+        _end = _current + nodes->NumberOfNeighbourOffsetsForBorderClass(borderClass);
+        SkipVoxelsOutsideBand();
+    }
+
+    bool IsAtEnd() const {
+        return _current == _end;
+    }
+
+    void Next() {
+        ++_current;
+        SkipVoxelsOutsideBand();
+    }
+
+    NodeIndex GetIndex() const {
+        int voxel = _voxel + *_current;
+        return _indices ? _indices[voxel] : (NodeIndex)voxel;
+    }
+
+private:
+    void SkipVoxelsOutsideBand() {
+        if (!_indices) {
+            return;
+        }
+        while (_current != _end && _indices[_voxel + *_current] == NODE_NONE) {
+            ++_current;
+        }
+    }
+
+    int _voxel;
+    const NodeIndex* _indices;
+    const int* _current;
+    const int* _end;
+};
+
+
+/**
+ * FixedNeighbourIterator is a NeighbourIterator for a connectivity
+ * that is known at compile time. Nodes that do not lie on the border
+ * of the volume, which are the vast majority, get a constant number
+ * of neighbours, so loops over them have a fixed trip count, unless
+ * the nodes only cover a band.
+ * The connectivity of @p nodes should match @p Connectivity.
+ */
+template <vtkConnectivity Connectivity>
+class FixedNeighbourIterator
+{
+public:
+    FixedNeighbourIterator(Nodes* nodes, NodeIndex index)
+        : _voxel(nodes->VoxelForIndex(index))
+        , _indices(nodes->GetIndicesForVoxels())
+    {
+        int borderClass = nodes->BorderClassForIndex(index);
+        _current = nodes->NeighbourOffsetsForBorderClass(borderClass);
+        if (borderClass == 0) {
+            _end = _current + ConnectivityTraits<Connectivity>::NumberOfNeighbours;
+        } else {
+            _end = _current + nodes->NumberOfNeighbourOffsetsForBorderClass(borderClass);
+        }
+        SkipVoxelsOutsideBand();
+    }
+
+    bool IsAtEnd() const {
+        return _current == _end;
+    }
+
+    void Next() {
+        ++_current;
+        SkipVoxelsOutsideBand();
+    }
+
+    NodeIndex GetIndex() const {
+        int voxel = _voxel + *_current;
+        return _indices ? _indices[voxel] : (NodeIndex)voxel;
+    }
+
+private:
+    void SkipVoxelsOutsideBand() {
+        if (!_indices) {
+            return;
+        }
+        while (_current != _end && _indices[_voxel + *_current] == NODE_NONE) {
+            ++_current;
+        }
+    }
+
+    int _voxel;
+    const NodeIndex* _indices;
+    const int* _current;
+    const int* _end;
+};
+
+#endif /* NeighbourIterator_h */
@@ -11,17 +11,50 @@
 
 #include "vtkGraphCutDataTypes.h"
 
+
+/**
+ * Node is a lightweight accessor for a single node of a Nodes
+ * object. Nodes stores every property in its own contiguous array
+ * and the members of Node are references into these arrays, so
+ * reading and writing them reads and writes the arrays directly.
+ * Get a Node from Nodes::GetNode and pass it around by value.
+ */
 class Node
 {
 public:
-    Node();
+    Node(vtkTreeType& tree, int& depthInTree, int& timestamp, NodeIndex& parent, ArcIndex& parentArc, NodeIndex& firstChild, NodeIndex& nextSibling, bool& active, NodeIndex& nextActive, bool& orphan, bool& seedPoint)
+        : tree(tree)
+        , depthInTree(depthInTree)
+        , timestamp(timestamp)
+        , parent(parent)
+        , parentArc(parentArc)
+        , firstChild(firstChild)
+        , nextSibling(nextSibling)
+        , active(active)
+        , nextActive(nextActive)
+        , orphan(orphan)
+        , seedPoint(seedPoint)
+    {
+    }
     
-    vtkTreeType tree;
-    int depthInTree;
-    NodeIndex parent;
-    bool active;
-    bool orphan;
-    bool seedPoint;
+    vtkTreeType& tree;
+    int& depthInTree;
+    // Adoption pass in which depthInTree was last known to be
+    // the distance to the root
+    int& timestamp;
+    NodeIndex& parent;
+    // Arc between the node and its parent in the direction
+    // of the flow: from the parent in the source tree and
+    // towards the parent in the sink tree
+    ArcIndex& parentArc;
+    // The children of a node form a linked list that starts
+    // at firstChild and is linked through nextSibling
+    NodeIndex& firstChild;
+    NodeIndex& nextSibling;
+    bool& active;
+    NodeIndex& nextActive;
+    bool& orphan;
+    bool& seedPoint;
 };
 
 #endif /* Node_h */
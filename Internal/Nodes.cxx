@@ -7,14 +7,31 @@
 //
 
 #include "Nodes.h"
+#include "NeighbourIterator.h"
+#include "ConnectivityTraits.h"
 #include <cstdlib>
 #include <assert.h>
 #include <stdio.h>
+#include <algorithm>
 
 
 Nodes::Nodes() {
-    _nodes = NULL;
+    _size = 0;
+    _tree = NULL;
+    _depthInTree = NULL;
+    _timestamp = NULL;
+    _parent = NULL;
+    _parentArc = NULL;
+    _firstChild = NULL;
+    _nextSibling = NULL;
+    _active = NULL;
+    _nextActive = NULL;
+    _orphan = NULL;
+    _seedPoint = NULL;
     _dimensions = NULL;
+    _indexForVoxel = NULL;
+    _voxelForIndex = NULL;
+    _bandSize = 0;
     Reset();
 }
 
@@ -26,6 +43,7 @@ Nodes::~Nodes() {
 
 void Nodes::SetConnectivity(vtkConnectivity connectivity) {
     _connectivity = connectivity;
+    UpdateNeighbourOffsets();
 }
 
 
@@ -41,6 +59,35 @@ void Nodes::SetDimensions(int *dimensions) {
     for (int i = 0; i < 3; i++) {
         _dimensions[i] = dimensions[i];
     }
+    // The nodes of a band do not fit the new dimensions
+    if (HasBand()) {
+        DeleteNodes();
+        DeleteBand();
+    }
+    UpdateNeighbourOffsets();
+}
+
+
+void Nodes::SetBand(const std::vector<char>& band) {
+    assert(_dimensions);
+    int numberOfVoxels = _dimensions[0] * _dimensions[1] * _dimensions[2];
+    assert((int)band.size() == numberOfVoxels);
+    
+    DeleteNodes();
+    DeleteBand();
+    _bandSize = numberOfVoxels - (int)std::count(band.begin(), band.end(), (char)0);
+    _indexForVoxel = new NodeIndex[numberOfVoxels];
+    _voxelForIndex = new int[_bandSize];
+    int index = 0;
+    for (int voxel = 0; voxel < numberOfVoxels; ++voxel) {
+        if (band[voxel]) {
+            _voxelForIndex[index] = voxel;
+            _indexForVoxel[voxel] = (NodeIndex)index;
+            ++index;
+        } else {
+            _indexForVoxel[voxel] = NODE_NONE;
+        }
+    }
 }
 
 
@@ -60,46 +107,28 @@ void Nodes::Update() {
         return;
     }
     
-    if (!_nodes) {
-        _nodes = CreateNodesForDimensions(_dimensions);
+    if (!_tree) {
+        CreateNodesForDimensions(_dimensions);
     }
 }
 
 
 void Nodes::Reset() {
-    if (_nodes != NULL) {
-        for (std::vector<Node*>::iterator i = _nodes->begin(); i != _nodes->end(); ++i) {
-            delete *i;
-        }
-        delete _nodes;
-    }
-    _nodes = NULL;
+    DeleteNodes();
+    DeleteBand();
     _connectivity = UNCONNECTED;
     if (_dimensions != NULL) {
         delete _dimensions;
     }
     _dimensions = NULL;
+    UpdateNeighbourOffsets();
 }
 
 
 std::vector<NodeIndex> Nodes::GetIndicesForNeighbours(NodeIndex index) {
     std::vector<NodeIndex> result;
-    
-    int coordinate[3];
-    GetCoordinateForIndex(index, coordinate);
-    int coord[3] = {0, 0, 0};
-    for (int z = -1; z < 2; ++z) {
-        for (int y = -1; y < 2; ++y) {
-            for (int x = -1; x < 2; ++x) {
-                coord[0] = coordinate[0]+x;
-                coord[1] = coordinate[1]+y;
-                coord[2] = coordinate[2]+z;
-                if (IsNodeAtOffsetConnected(x, y, z)
-                    && IsValidCoordinate(coord)) {
-                    result.push_back(GetIndexForCoordinate(coord));
-                }
-            }
-        }
+    for (NeighbourIterator it(this, index); !it.IsAtEnd(); it.Next()) {
+        result.push_back(it.GetIndex());
     }
     return result;
 }
@@ -123,19 +152,20 @@ NodeIndex Nodes::GetIndexForCoordinate(int* coordinate) {
     assert(coordinate[1] >= 0);
     assert(coordinate[2] >= 0);
     
-    return (NodeIndex) (coordinate[0]
-                        + coordinate[1] * _dimensions[0]
-                        + coordinate[2] * _dimensions[0] * _dimensions[1]);
+    return IndexForVoxel(coordinate[0]
+                         + coordinate[1] * _dimensions[0]
+                         + coordinate[2] * _dimensions[0] * _dimensions[1]);
 }
 
 
 bool Nodes::GetCoordinateForIndex(NodeIndex index, int* coordinate) {
-    if (index >= _dimensions[0] * _dimensions[1] * _dimensions[2] || index < 0) {
+    int numberOfNodes = HasBand() ? _bandSize : _dimensions[0] * _dimensions[1] * _dimensions[2];
+    if (index >= numberOfNodes || index < 0) {
         return false;
     }
     
     int dims = _dimensions[0] * _dimensions[1];
-    int rest = index;
+    int rest = VoxelForIndex(index);
     coordinate[2] = rest / dims;
     rest -= coordinate[2] * dims;
     dims = _dimensions[0];
@@ -151,57 +181,132 @@ bool Nodes::IsNodeAtOffsetConnected(int x, int y, int z) {
     assert(std::abs(x) < 2 && std::abs(y) < 2 && std::abs(z) < 2);
     switch (_connectivity) {
         case SIX:
-            return (std::abs(x + y) == 1 && z == 0)
-            || (std::abs(y + z) == 1 && x == 0)
-            || (std::abs(z + x) == 1 && y == 0);
+            return ConnectivityTraits<SIX>::IsConnected(x, y, z);
         case EIGHTEEN:
-            return (x == 0 || y == 0 || z == 0) && !(x == 0 && y == 0 && z == 0);
+            return ConnectivityTraits<EIGHTEEN>::IsConnected(x, y, z);
         case TWENTYSIX:
-            return !(x == 0 && y == 0 && z == 0);
-            break;
+            return ConnectivityTraits<TWENTYSIX>::IsConnected(x, y, z);
         default:
             return false;
     }
 }
 
 
-Node* Nodes::GetNode(int index) {
-    if (_nodes == NULL || index < 0 || index >= _nodes->size()) {
-        return NULL;
-    }
-    return _nodes->at(index);
+bool Nodes::IsValidIndex(int index) {
+    return index >= 0 && index < _size;
 }
 
 
 int Nodes::GetSize() {
-    if (_nodes == NULL) {
-        return 0;
-    }
-    return _nodes->size();
+    return _size;
 }
 
 
-std::vector<Node*>::iterator Nodes::GetIterator() {
-    return _nodes->begin();
+void Nodes::CreateNodesForDimensions(int* dimensions) {
+    DeleteNodes();
+    
+    int numberOfVertices = HasBand() ? _bandSize : dimensions[0] * dimensions[1] * dimensions[2];
+    
+    _tree = new vtkTreeType[numberOfVertices];
+    _depthInTree = new int[numberOfVertices];
+    _timestamp = new int[numberOfVertices];
+    _parent = new NodeIndex[numberOfVertices];
+    _parentArc = new ArcIndex[numberOfVertices];
+    _firstChild = new NodeIndex[numberOfVertices];
+    _nextSibling = new NodeIndex[numberOfVertices];
+    _active = new bool[numberOfVertices];
+    _nextActive = new NodeIndex[numberOfVertices];
+    _orphan = new bool[numberOfVertices];
+    _seedPoint = new bool[numberOfVertices];
+    _size = numberOfVertices;
+    
+    ClearTrees();
+    std::fill(_seedPoint, _seedPoint + numberOfVertices, false);
 }
 
 
-std::vector<Node*>::iterator Nodes::GetEnd() {
-    return _nodes->end();
+void Nodes::ClearTrees() {
+    std::fill(_tree, _tree + _size, TREE_NONE);
+    std::fill(_depthInTree, _depthInTree + _size, -1);
+    std::fill(_timestamp, _timestamp + _size, 0);
+    std::fill(_parent, _parent + _size, NODE_NONE);
+    std::fill(_parentArc, _parentArc + _size, ARC_NONE);
+    std::fill(_firstChild, _firstChild + _size, NODE_NONE);
+    std::fill(_nextSibling, _nextSibling + _size, NODE_NONE);
+    std::fill(_active, _active + _size, false);
+    std::fill(_nextActive, _nextActive + _size, NODE_NONE);
+    std::fill(_orphan, _orphan + _size, false);
 }
 
 
-std::vector<Node*>* Nodes::CreateNodesForDimensions(int* dimensions) {
-    std::vector<Node*>* result = new std::vector<Node*>();
-    
-    int numberOfVertices = dimensions[0] * dimensions[1] * dimensions[2];
-    result->reserve(numberOfVertices);
-    
-    for (int i = 0; i < numberOfVertices; i++) {
-        Node* node = new Node();
-        result->push_back(node);
+void Nodes::DeleteNodes() {
+    delete [] _tree;
+    delete [] _depthInTree;
+    delete [] _timestamp;
+    delete [] _parent;
+    delete [] _parentArc;
+    delete [] _firstChild;
+    delete [] _nextSibling;
+    delete [] _active;
+    delete [] _nextActive;
+    delete [] _orphan;
+    delete [] _seedPoint;
+    _tree = NULL;
+    _depthInTree = NULL;
+    _timestamp = NULL;
+    _parent = NULL;
+    _parentArc = NULL;
+    _firstChild = NULL;
+    _nextSibling = NULL;
+    _active = NULL;
+    _nextActive = NULL;
+    _orphan = NULL;
+    _seedPoint = NULL;
+    _size = 0;
+}
+
+
+void Nodes::DeleteBand() {
+    delete [] _indexForVoxel;
+    delete [] _voxelForIndex;
+    _indexForVoxel = NULL;
+    _voxelForIndex = NULL;
+    _bandSize = 0;
+}
+
+
+void Nodes::UpdateNeighbourOffsets() {
+    std::fill(_numberOfNeighbourOffsets, _numberOfNeighbourOffsets + 64, 0);
+    if (_dimensions == NULL || _connectivity == UNCONNECTED) {
+        return;
     }
     
-    return result;
+    for (int borderClass = 0; borderClass < 64; ++borderClass) {
+        int* offsets = _neighbourOffsets + borderClass * 26;
+        int count = 0;
+        for (int z = -1; z < 2; ++z) {
+            for (int y = -1; y < 2; ++y) {
+                for (int x = -1; x < 2; ++x) {
+                    if (!IsNodeAtOffsetConnected(x, y, z)) {
+                        continue;
+                    }
+                    int offset[3] = {x, y, z};
+                    bool valid = true;
+                    for (int i = 0; i < 3; ++i) {
+                        bool atLowSide = (borderClass >> (2 * i)) & 1;
+                        bool atHighSide = (borderClass >> (2 * i + 1)) & 1;
+                        if ((offset[i] < 0 && atLowSide) || (offset[i] > 0 && atHighSide)) {
+                            valid = false;
+                        }
+                    }
+                    if (valid) {
+                        offsets[count++] = x
+                            + y * _dimensions[0]
+                            + z * _dimensions[0] * _dimensions[1];
+                    }
+                }
+            }
+        }
+        _numberOfNeighbourOffsets[borderClass] = count;
+    }
 }
-
@@ -10,9 +10,17 @@
 #define Nodes_h
 
 #include <vector>
+#include <cstddef>
+#include <assert.h>
 #include "Internal/Node.h"
 #include "vtkGraphCutDefinitions.h"
 
+
+/**
+ * Nodes holds the state of all the nodes of the graph. Every
+ * property is stored in its own contiguous array that is indexed
+ * by NodeIndex. Use GetNode to get an accessor for a single node.
+ */
 class Nodes {
 public:
     // Constructors
@@ -26,6 +34,23 @@ public:
     void SetDimensions(int* dimensions);
     int* GetDimensions();
     
+    /**
+     * Gives only the voxels of the dimensions for which @p band is
+     * set a node, so that a graph can be built around a boundary
+     * without nodes for the rest of the volume. @p band holds a char
+     * for every voxel. The nodes are numbered in the order of their
+     * voxels and the voxels outside the band are no neighbours. Set
+     * the dimensions first; setting them again clears the band.
+     */
+    void SetBand(const std::vector<char>& band);
+    
+    /**
+     * Returns true iff only the voxels of a band have nodes.
+     */
+    bool HasBand() {
+        return _indexForVoxel != NULL;
+    }
+    
     /**
      * Updates internal state to apply
      * the new properties, if any.
@@ -43,9 +68,80 @@ public:
     
     /**
      * Returns indices of all neighbouring nodes.
+     * Hot loops should use NeighbourIterator instead, which
+     * does not allocate.
      */
     std::vector<NodeIndex> GetIndicesForNeighbours(NodeIndex index);
     
+    /**
+     * Returns the border class of the node at @p index: a bit
+     * for each side of the volume that the node lies on. Nodes
+     * that do not lie on any side have border class 0.
+     */
+    int BorderClassForIndex(NodeIndex index) {
+        int voxel = VoxelForIndex(index);
+        int x = voxel % _dimensions[0];
+        int rest = voxel / _dimensions[0];
+        int y = rest % _dimensions[1];
+        int z = rest / _dimensions[1];
+        return (x == 0)
+            | (x == _dimensions[0] - 1) << 1
+            | (y == 0) << 2
+            | (y == _dimensions[1] - 1) << 3
+            | (z == 0) << 4
+            | (z == _dimensions[2] - 1) << 5;
+    }
+    
+    /**
+     * Returns the offsets in voxel space to all the neighbours
+     * of a node with the given @p borderClass. Only offsets to
+     * voxels that lie within the dimensions are returned; with a
+     * band these may still have no node.
+     */
+    const int* NeighbourOffsetsForBorderClass(int borderClass) {
+        return _neighbourOffsets + borderClass * 26;
+    }
+    
+    /**
+     * Returns the number of offsets returned by
+     * NeighbourOffsetsForBorderClass.
+     */
+    int NumberOfNeighbourOffsetsForBorderClass(int borderClass) {
+        return _numberOfNeighbourOffsets[borderClass];
+    }
+    
+    /**
+     * Returns the index of the voxel of the node at @p index. Without
+     * a band these are the same.
+     */
+    int VoxelForIndex(NodeIndex index) {
+        return _voxelForIndex ? _voxelForIndex[index] : (int)index;
+    }
+    
+    /**
+     * Returns the index of the node at @p voxel, or NODE_NONE when
+     * the voxel lies outside of the band.
+     */
+    NodeIndex IndexForVoxel(int voxel) {
+        return _indexForVoxel ? _indexForVoxel[voxel] : (NodeIndex)voxel;
+    }
+    
+    /**
+     * Returns the table that IndexForVoxel looks in, or NULL when
+     * there is no band.
+     */
+    const NodeIndex* GetIndicesForVoxels() {
+        return _indexForVoxel;
+    }
+    
+    /**
+     * Returns the table that VoxelForIndex looks in, or NULL when
+     * there is no band.
+     */
+    const int* GetVoxelsForIndices() {
+        return _voxelForIndex;
+    }
+    
     /**
      * Returns true iff the index is within the internal
      * nodes array and coordinate is pointing to valid value.
@@ -68,7 +164,8 @@ public:
     bool IsValidCoordinate(int* coordinate);
     
     /**
-     * Returns the index of a node for a given coordinate.
+     * Returns the index of a node for a given coordinate, or
+     * NODE_NONE when the coordinate lies outside of the band.
      * Make sure to call IsValidCoordinate before calling this
      * method to make sure that the index is actually valid for
      * further use.
@@ -76,34 +173,99 @@ public:
     NodeIndex GetIndexForCoordinate(int* coordinate);
     
     /**
-     * Returns the node for a given index.
+     * Returns true iff @p index refers to an existing node.
+     */
+    bool IsValidIndex(int index);
+    
+    /**
+     * Returns an accessor for the node at the given index.
+     * Make sure that the index is valid.
+     */
+    Node GetNode(int index) {
+        assert(IsValidIndex(index));
+        return Node(_tree[index],
+                    _depthInTree[index],
+                    _timestamp[index],
+                    _parent[index],
+                    _parentArc[index],
+                    _firstChild[index],
+                    _nextSibling[index],
+                    _active[index],
+                    _nextActive[index],
+                    _orphan[index],
+                    _seedPoint[index]);
+    }
+    
+    /**
+     * Returns the tree of the node at the given index, without
+     * the cost of creating an accessor.
      */
-    Node* GetNode(int index);
+    vtkTreeType TreeForIndex(NodeIndex index) {
+        assert(IsValidIndex(index));
+        return _tree[index];
+    }
     
     /**
      * Returns the number of nodes;
      */
     int GetSize();
+    
+    /**
+     * Allocates the arrays for the given dimensions, or for the
+     * voxels of the band when there is one, and initializes every
+     * node to a free node.
+     */
+    void CreateNodesForDimensions(int* dimensions);
+    
+    /**
+     * Makes every node a free node again, without allocating the
+     * arrays anew. Whether a node is a seed point is kept.
+     */
+    void ClearTrees();
 
+protected:
     /**
-     * Returns an iterator to the start of the internal vector.
+     * Frees the arrays that hold the state of the nodes.
      */
-    std::vector<Node*>::iterator GetIterator();
+    void DeleteNodes();
     
     /**
-     * Returns the iterator at the end of the internal vector.
+     * Frees the tables that map the voxels of the band to nodes.
      */
-    std::vector<Node*>::iterator GetEnd();
+    void DeleteBand();
     
     /**
-     * Creates and returns a vector of Node objects.
+     * Fills the neighbour offset tables for the current
+     * connectivity and dimensions.
      */
-    std::vector<Node*>* CreateNodesForDimensions(int* dimensions);
-
-protected:
-    std::vector<Node*>* _nodes;
+    void UpdateNeighbourOffsets();
+    
+    int _size;
+    vtkTreeType* _tree;
+    int* _depthInTree;
+    int* _timestamp;
+    NodeIndex* _parent;
+    ArcIndex* _parentArc;
+    NodeIndex* _firstChild;
+    NodeIndex* _nextSibling;
+    bool* _active;
+    NodeIndex* _nextActive;
+    bool* _orphan;
+    bool* _seedPoint;
+    
     vtkConnectivity _connectivity;
     int* _dimensions;
+    
+    // The node of every voxel of the dimensions and the voxel of
+    // every node, when only the voxels of a band have nodes
+    NodeIndex* _indexForVoxel;
+    int* _voxelForIndex;
+    int _bandSize;
+    
+    // For each of the 64 border classes (a bit for each side of the
+    // volume the node lies on) the offsets to its valid neighbours
+    int _neighbourOffsets[64 * 26];
+    int _numberOfNeighbourOffsets[64];
 };
 
 #endif /* Nodes_h */
@@ -0,0 +1,335 @@
+//
+//  PushRelabel.cxx
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 24/07/16.
+//
+//
+
+#include "PushRelabel.h"
+#include <algorithm>
+#include <assert.h>
+#include "Internal/Edges.h"
+#include "Internal/Nodes.h"
+#include "Internal/Node.h"
+#include "Internal/NeighbourIterator.h"
+#include "Internal/ConnectivityTraits.h"
+
+PushRelabel::PushRelabel(Edges* edges) {
+    _edges = edges;
+    _nodes = edges->GetNodes();
+    _size = _nodes->GetSize();
+    _unreachable = 2 * _size + 1;
+    _highestBucket = 0;
+    _relabelsSinceGlobalRelabel = 0;
+}
+
+
+PushRelabel::~PushRelabel() {
+    _edges = NULL;
+    _nodes = NULL;
+}
+
+
+template <vtkConnectivity Connectivity>
+void PushRelabel::MaxFlow() {
+    InitializePreflow();
+    GlobalRelabel<Connectivity>();
+    while (!_activeNodes.empty()) {
+        NodeIndex index = _activeNodes.front();
+        _activeNodes.pop_front();
+        _active[index] = 0;
+        Discharge<Connectivity>(index);
+        if (_relabelsSinceGlobalRelabel > _size) {
+            GlobalRelabel<Connectivity>();
+        }
+    }
+}
+
+
+template <vtkConnectivity Connectivity>
+void PushRelabel::LabelNodes() {
+    for (int index = 0; index < _size; ++index) {
+        _nodes->GetNode((NodeIndex)index).tree = TREE_NONE;
+    }
+
+    // Nodes that can be reached from the source
+    std::vector<NodeIndex> queue;
+    for (int index = 0; index < _size; ++index) {
+        ArcIndex sourceArc = (ArcIndex)(2 * _edges->FirstEdgeIndexForNode((NodeIndex)index));
+        if (_edges->ResidualCapacityForArc(sourceArc) > 0) {
+            _nodes->GetNode((NodeIndex)index).tree = TREE_SOURCE;
+            queue.push_back((NodeIndex)index);
+        }
+    }
+    for (size_t i = 0; i < queue.size(); ++i) {
+        for (FixedNeighbourIterator<Connectivity> it(_nodes, queue[i]); !it.IsAtEnd(); it.Next()) {
+            NodeIndex neighbour = it.GetIndex();
+            if (_nodes->TreeForIndex(neighbour) == TREE_NONE
+                && _edges->ResidualCapacityForArc(_edges->ArcFromNodeToNode(queue[i], neighbour)) > 0) {
+                _nodes->GetNode(neighbour).tree = TREE_SOURCE;
+                queue.push_back(neighbour);
+            }
+        }
+    }
+
+    // Nodes that can reach the sink
+    queue.clear();
+    for (int index = 0; index < _size; ++index) {
+        ArcIndex sinkArc = (ArcIndex)(2 * (_edges->FirstEdgeIndexForNode((NodeIndex)index) + 1));
+        if (_nodes->TreeForIndex((NodeIndex)index) == TREE_NONE && _edges->ResidualCapacityForArc(sinkArc) > 0) {
+            _nodes->GetNode((NodeIndex)index).tree = TREE_SINK;
+            queue.push_back((NodeIndex)index);
+        }
+    }
+    for (size_t i = 0; i < queue.size(); ++i) {
+        for (FixedNeighbourIterator<Connectivity> it(_nodes, queue[i]); !it.IsAtEnd(); it.Next()) {
+            NodeIndex neighbour = it.GetIndex();
+            if (_nodes->TreeForIndex(neighbour) == TREE_NONE
+                && _edges->ResidualCapacityForArc(_edges->ArcFromNodeToNode(neighbour, queue[i])) > 0) {
+                _nodes->GetNode(neighbour).tree = TREE_SINK;
+                queue.push_back(neighbour);
+            }
+        }
+    }
+}
+
+
+// Protected
+
+void PushRelabel::InitializePreflow() {
+    _excess.assign(_size, 0);
+    _labels.assign(_size, _unreachable);
+    _currentArcs.assign(_size, 0);
+    _active.assign(_size, 0);
+    _activeNodes.clear();
+    _bucketFirst.assign(_size, NODE_NONE);
+    _bucketNext.assign(_size, NODE_NONE);
+    _bucketPrevious.assign(_size, NODE_NONE);
+
+    for (int index = 0; index < _size; ++index) {
+        EdgeIndex sourceEdgeIndex = _edges->FirstEdgeIndexForNode((NodeIndex)index);
+        ArcIndex sourceArc = (ArcIndex)(2 * sourceEdgeIndex);
+        ArcIndex sinkArc = (ArcIndex)(2 * (sourceEdgeIndex + 1));
+        int flow = std::min(_edges->ResidualCapacityForArc(sourceArc), _edges->ResidualCapacityForArc(sinkArc));
+        if (flow > 0) {
+            _edges->PushFlowThroughArc(sourceArc, flow);
+            _edges->PushFlowThroughArc(sinkArc, flow);
+        }
+        int excess = _edges->ResidualCapacityForArc(sourceArc);
+        if (excess > 0) {
+            _edges->PushFlowThroughArc(sourceArc, excess);
+            _excess[index] = excess;
+        }
+    }
+}
+
+
+template <vtkConnectivity Connectivity>
+void PushRelabel::GlobalRelabel() {
+    _labels.assign(_size, _unreachable);
+    std::fill(_bucketFirst.begin(), _bucketFirst.end(), NODE_NONE);
+    _highestBucket = 0;
+
+    // Distances to the sink, followed by the distances to the source for
+    // the nodes that can't reach the sink. Both are found by walking the
+    // residual arcs backwards.
+    std::vector<NodeIndex> queue;
+    for (int terminal = 0; terminal < 2; ++terminal) {
+        size_t first = queue.size();
+        for (int index = 0; index < _size; ++index) {
+            if (_labels[index] != _unreachable) {
+                continue;
+            }
+            EdgeIndex sourceEdgeIndex = _edges->FirstEdgeIndexForNode((NodeIndex)index);
+            ArcIndex arc = terminal == 0
+                ? (ArcIndex)(2 * (sourceEdgeIndex + 1))
+                : (ArcIndex)(2 * sourceEdgeIndex + 1);
+            if (_edges->ResidualCapacityForArc(arc) > 0) {
+                _labels[index] = terminal == 0 ? 1 : _size + 1;
+                queue.push_back((NodeIndex)index);
+            }
+        }
+        for (size_t i = first; i < queue.size(); ++i) {
+            NodeIndex index = queue[i];
+            for (FixedNeighbourIterator<Connectivity> it(_nodes, index); !it.IsAtEnd(); it.Next()) {
+                NodeIndex neighbour = it.GetIndex();
+                if (_labels[neighbour] == _unreachable
+                    && _edges->ResidualCapacityForArc(_edges->ArcFromNodeToNode(neighbour, index)) > 0) {
+                    _labels[neighbour] = _labels[index] + 1;
+                    queue.push_back(neighbour);
+                }
+            }
+        }
+    }
+
+    _activeNodes.clear();
+    for (int index = 0; index < _size; ++index) {
+        _currentArcs[index] = 0;
+        if (_labels[index] < _size) {
+            AddToBucket((NodeIndex)index);
+        }
+        _active[index] = _excess[index] > 0 && _labels[index] != _unreachable;
+        if (_active[index]) {
+            _activeNodes.push_back((NodeIndex)index);
+        }
+    }
+    _relabelsSinceGlobalRelabel = 0;
+}
+
+
+template <vtkConnectivity Connectivity>
+void PushRelabel::Relabel(NodeIndex index) {
+    int label = LabelForRelabel<Connectivity>(index);
+    int oldLabel = _labels[index];
+    assert(label > oldLabel);
+    if (oldLabel < _size) {
+        RemoveFromBucket(index);
+        if (_bucketFirst[oldLabel] == NODE_NONE) {
+            Gap(oldLabel);
+            label = std::max(label, _size + 1);
+        }
+    }
+    _labels[index] = std::min(label, _unreachable);
+    if (_labels[index] < _size) {
+        AddToBucket(index);
+    }
+    _currentArcs[index] = 0;
+    ++_relabelsSinceGlobalRelabel;
+}
+
+
+template <vtkConnectivity Connectivity>
+int PushRelabel::LabelForRelabel(NodeIndex index) {
+    // The new label is one more than the lowest label that the node
+    // has a residual arc to
+    EdgeIndex sourceEdgeIndex = _edges->FirstEdgeIndexForNode(index);
+    int label = _unreachable;
+    if (_edges->ResidualCapacityForArc((ArcIndex)(2 * (sourceEdgeIndex + 1))) > 0) {
+        label = 1;
+    }
+    if (_edges->ResidualCapacityForArc((ArcIndex)(2 * sourceEdgeIndex + 1)) > 0) {
+        label = std::min(label, _size + 1);
+    }
+    for (FixedNeighbourIterator<Connectivity> it(_nodes, index); !it.IsAtEnd(); it.Next()) {
+        NodeIndex neighbour = it.GetIndex();
+        if (_edges->ResidualCapacityForArc(_edges->ArcFromNodeToNode(index, neighbour)) > 0) {
+            label = std::min(label, _labels[neighbour] + 1);
+        }
+    }
+    return label;
+}
+
+
+template <vtkConnectivity Connectivity>
+void PushRelabel::Discharge(NodeIndex index) {
+    int borderClass = _nodes->BorderClassForIndex(index);
+    const int* offsets = _nodes->NeighbourOffsetsForBorderClass(borderClass);
+    int numberOfArcs = 2 + (borderClass == 0
+        ? (int)ConnectivityTraits<Connectivity>::NumberOfNeighbours
+        : _nodes->NumberOfNeighbourOffsetsForBorderClass(borderClass));
+    EdgeIndex sourceEdgeIndex = _edges->FirstEdgeIndexForNode(index);
+    int voxel = _nodes->VoxelForIndex(index);
+
+    while (_excess[index] > 0) {
+        int current = _currentArcs[index];
+        if (current == numberOfArcs) {
+            Relabel<Connectivity>(index);
+            if (_labels[index] == _unreachable) {
+                break;
+            }
+            continue;
+        }
+
+        ArcIndex arc;
+        int targetLabel;
+        NodeIndex target = NODE_NONE;
+        if (current == 0) {
+            arc = (ArcIndex)(2 * (sourceEdgeIndex + 1));
+            targetLabel = 0;
+        } else if (current == 1) {
+            arc = (ArcIndex)(2 * sourceEdgeIndex + 1);
+            targetLabel = _size;
+        } else {
+            // The offsets lead to voxels that may lie outside of a band
+            target = _nodes->IndexForVoxel(voxel + offsets[current - 2]);
+            if (target == NODE_NONE) {
+                _currentArcs[index] = current + 1;
+                continue;
+            }
+            arc = _edges->ArcFromNodeToNode(index, target);
+            targetLabel = _labels[target];
+        }
+
+        int residual = _edges->ResidualCapacityForArc(arc);
+        if (residual > 0 && _labels[index] == targetLabel + 1) {
+            int flow = std::min(_excess[index], residual);
+            _edges->PushFlowThroughArc(arc, flow);
+            _excess[index] -= flow;
+            if (target != NODE_NONE) {
+                _excess[target] += flow;
+                Activate(target);
+            }
+        } else {
+            _currentArcs[index] = current + 1;
+        }
+    }
+}
+
+
+void PushRelabel::Gap(int label) {
+    for (int l = label + 1; l <= _highestBucket; ++l) {
+        NodeIndex index = _bucketFirst[l];
+        while (index != NODE_NONE) {
+            NodeIndex next = _bucketNext[index];
+            _labels[index] = _size + 1;
+            _currentArcs[index] = 0;
+            index = next;
+        }
+        _bucketFirst[l] = NODE_NONE;
+    }
+    _highestBucket = std::max(label - 1, 0);
+}
+
+
+void PushRelabel::AddToBucket(NodeIndex index) {
+    int label = _labels[index];
+    NodeIndex first = _bucketFirst[label];
+    _bucketPrevious[index] = NODE_NONE;
+    _bucketNext[index] = first;
+    if (first != NODE_NONE) {
+        _bucketPrevious[first] = index;
+    }
+    _bucketFirst[label] = index;
+    _highestBucket = std::max(_highestBucket, label);
+}
+
+
+void PushRelabel::RemoveFromBucket(NodeIndex index) {
+    NodeIndex previous = _bucketPrevious[index];
+    NodeIndex next = _bucketNext[index];
+    if (previous != NODE_NONE) {
+        _bucketNext[previous] = next;
+    } else {
+        _bucketFirst[_labels[index]] = next;
+    }
+    if (next != NODE_NONE) {
+        _bucketPrevious[next] = previous;
+    }
+}
+
+
+void PushRelabel::Activate(NodeIndex index) {
+    if (!_active[index]) {
+        _active[index] = 1;
+        _activeNodes.push_back(index);
+    }
+}
+
+
+template void PushRelabel::MaxFlow<SIX>();
+template void PushRelabel::MaxFlow<EIGHTEEN>();
+template void PushRelabel::MaxFlow<TWENTYSIX>();
+template void PushRelabel::LabelNodes<SIX>();
+template void PushRelabel::LabelNodes<EIGHTEEN>();
+template void PushRelabel::LabelNodes<TWENTYSIX>();
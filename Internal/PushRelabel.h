@@ -0,0 +1,122 @@
+//
+//  PushRelabel.h
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 24/07/16.
+//
+//
+
+#ifndef PushRelabel_h
+#define PushRelabel_h
+
+#include "vtkGraphCutDataTypes.h"
+#include "vtkGraphCutDefinitions.h"
+#include <deque>
+#include <vector>
+
+
+class Edges;
+class Nodes;
+
+
+/**
+ * PushRelabel calculates a maximum flow with the FIFO push-relabel
+ * algorithm of Goldberg and Tarjan. It works on the residual capacities
+ * of an Edges object, so it shares the graph with the augmenting path
+ * solver. The source has label n and the sink has label 0, where n is
+ * the number of nodes.
+ *
+ * Two heuristics keep the number of relabels down:
+ * - Global relabeling: every n relabels the labels are set to the exact
+ *   distances to the sink, or to n plus the distance to the source, by
+ *   a breadth-first search backwards through the residual graph.
+ * - Gap relabeling: when no node is left with some label below n, the
+ *   nodes with a higher label below n can no longer reach the sink, so
+ *   they are lifted to n + 1 at once.
+ *
+ * Excess that can't reach the sink flows back to the source, so the
+ * result is a flow and not just a preflow.
+ */
+class PushRelabel {
+public:
+    PushRelabel(Edges* edges);
+    ~PushRelabel();
+
+    /**
+     * Calculates a maximum flow for nodes with the given @p Connectivity,
+     * starting from the flow that is in the edges. The terminal edges of
+     * every node are used as is, so they should hold a valid flow.
+     * Instantiated for SIX, EIGHTEEN and TWENTYSIX.
+     */
+    template <vtkConnectivity Connectivity>
+    void MaxFlow();
+
+    /**
+     * Sets the tree of every node to the side of the minimum cut that it
+     * is on: TREE_SOURCE for the nodes that can be reached from the
+     * source through the residual graph, TREE_SINK for the nodes that
+     * can reach the sink and TREE_NONE for the other nodes. These are
+     * the same trees as the augmenting path solver ends with.
+     */
+    template <vtkConnectivity Connectivity>
+    void LabelNodes();
+
+protected:
+    /**
+     * Pushes the flow that can go straight through a node to the sink and
+     * saturates what is left of the arcs from the source, which gives the
+     * preflow that the algorithm starts from.
+     */
+    void InitializePreflow();
+
+    template <vtkConnectivity Connectivity>
+    void GlobalRelabel();
+    template <vtkConnectivity Connectivity>
+    void Relabel(NodeIndex index);
+
+    /**
+     * Returns one more than the lowest label that the node at @p index
+     * has a residual arc to, or the unreachable label if it has none.
+     */
+    template <vtkConnectivity Connectivity>
+    int LabelForRelabel(NodeIndex index);
+    template <vtkConnectivity Connectivity>
+    void Discharge(NodeIndex index);
+
+    /**
+     * Lifts all the nodes with a label between @p label and n to n + 1.
+     */
+    void Gap(int label);
+
+    void AddToBucket(NodeIndex index);
+    void RemoveFromBucket(NodeIndex index);
+    void Activate(NodeIndex index);
+
+    Edges* _edges;
+    Nodes* _nodes;
+    int _size;
+    // Label of the nodes that can reach neither terminal
+    int _unreachable;
+
+    std::vector<int> _excess;
+    std::vector<int> _labels;
+    // Position of the arc of every node that is tried next: 0 for the
+    // sink, 1 for the source and then the neighbours
+    std::vector<int> _currentArcs;
+
+    // FIFO queue of the nodes with excess. The flags are chars instead
+    // of bits, so that different threads can set neighbouring ones.
+    std::deque<NodeIndex> _activeNodes;
+    std::vector<char> _active;
+
+    // The nodes with a label below n are kept in a doubly linked list
+    // for every label, which tells when a gap appears
+    std::vector<NodeIndex> _bucketFirst;
+    std::vector<NodeIndex> _bucketNext;
+    std::vector<NodeIndex> _bucketPrevious;
+    int _highestBucket;
+
+    int _relabelsSinceGlobalRelabel;
+};
+
+#endif /* PushRelabel_h */
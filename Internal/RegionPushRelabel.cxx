@@ -0,0 +1,304 @@
+//
+//  RegionPushRelabel.cxx
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 26/07/16.
+//
+//
+
+#include "RegionPushRelabel.h"
+#include <algorithm>
+#include <assert.h>
+#include <vtkSMPTools.h>
+#include "Internal/Edges.h"
+#include "Internal/Nodes.h"
+#include "Internal/NeighbourIterator.h"
+#include "Internal/ConnectivityTraits.h"
+
+
+/**
+ * Discharges every other region, for use with vtkSMPTools. Index i
+ * stands for region 2 * i + parity.
+ */
+template <vtkConnectivity Connectivity>
+class RegionDischargeFunctor
+{
+public:
+    void operator()(vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i) {
+            solver->DischargeRegion<Connectivity>((int)(2 * i + parity));
+        }
+    }
+
+    RegionPushRelabel* solver;
+    int parity;
+};
+
+
+RegionPushRelabel::RegionPushRelabel(Edges* edges, int numberOfRegions) : PushRelabel(edges) {
+    int* dimensions = _nodes->GetDimensions();
+    int numberOfSlices = dimensions[2];
+    _sliceSize = dimensions[0] * dimensions[1];
+
+    // Regions of a single slice would let the regions on both sides of
+    // them push into the same nodes
+    _numberOfRegions = std::max(1, std::min(numberOfRegions, numberOfSlices / 2));
+    _regionForSlice.resize(numberOfSlices);
+    for (int z = 0; z < numberOfSlices; ++z) {
+        _regionForSlice[z] = z * _numberOfRegions / numberOfSlices;
+    }
+    // The nodes are numbered in the order of their voxels, so every
+    // region holds a range of nodes, which is empty when the nodes
+    // only cover a band that misses its slices
+    _regionFirstNodes.assign(_numberOfRegions + 1, _size);
+    for (int index = _size - 1; index >= 0; --index) {
+        _regionFirstNodes[RegionForIndex((NodeIndex)index)] = index;
+    }
+    for (int region = _numberOfRegions - 1; region >= 0; --region) {
+        _regionFirstNodes[region] = std::min(_regionFirstNodes[region], _regionFirstNodes[region + 1]);
+    }
+    _regionActiveNodes.resize(_numberOfRegions);
+    _regionBorderNodes.resize(_numberOfRegions);
+    _regionRelabels.assign(_numberOfRegions, 0);
+}
+
+
+RegionPushRelabel::~RegionPushRelabel() {
+}
+
+
+template <vtkConnectivity Connectivity>
+void RegionPushRelabel::MaxFlow() {
+    InitializePreflow();
+    GlobalRelabel<Connectivity>();
+    DistributeActiveNodes();
+
+    while (true) {
+        DischargeRegions<Connectivity>(0);
+        DischargeRegions<Connectivity>(1);
+
+        bool foundActiveNodes = false;
+        int relabels = 0;
+        for (int region = 0; region < _numberOfRegions; ++region) {
+            foundActiveNodes = foundActiveNodes || !_regionActiveNodes[region].empty();
+            relabels += _regionRelabels[region];
+        }
+        if (!foundActiveNodes) {
+            break;
+        }
+        // The labels of the nodes next to a region were fixed while it
+        // was discharged, so they are set right again after every round
+        // that changed them
+        if (relabels > 0) {
+            GlobalRelabel<Connectivity>();
+            DistributeActiveNodes();
+        }
+    }
+}
+
+
+template <vtkConnectivity Connectivity>
+void RegionPushRelabel::DischargeRegion(int region) {
+    std::deque<NodeIndex>& activeNodes = _regionActiveNodes[region];
+    if (activeNodes.empty()) {
+        return;
+    }
+    int regionSize = _regionFirstNodes[region + 1] - _regionFirstNodes[region];
+    RelabelRegion<Connectivity>(region);
+    int relabels = _regionRelabels[region];
+    while (!activeNodes.empty()) {
+        NodeIndex index = activeNodes.front();
+        activeNodes.pop_front();
+        _active[index] = 0;
+        DischargeNodeInRegion<Connectivity>(region, index);
+        if (_regionRelabels[region] - relabels > regionSize) {
+            RelabelRegion<Connectivity>(region);
+            relabels = _regionRelabels[region];
+        }
+    }
+}
+
+
+int RegionPushRelabel::GetNumberOfRegions() {
+    return _numberOfRegions;
+}
+
+
+// Protected
+
+template <vtkConnectivity Connectivity>
+void RegionPushRelabel::DischargeNodeInRegion(int region, NodeIndex index) {
+    int borderClass = _nodes->BorderClassForIndex(index);
+    const int* offsets = _nodes->NeighbourOffsetsForBorderClass(borderClass);
+    int numberOfArcs = 2 + (borderClass == 0
+        ? (int)ConnectivityTraits<Connectivity>::NumberOfNeighbours
+        : _nodes->NumberOfNeighbourOffsetsForBorderClass(borderClass));
+    EdgeIndex sourceEdgeIndex = _edges->FirstEdgeIndexForNode(index);
+    int voxel = _nodes->VoxelForIndex(index);
+
+    while (_excess[index] > 0) {
+        int current = _currentArcs[index];
+        if (current == numberOfArcs) {
+            RelabelInRegion<Connectivity>(region, index);
+            if (_labels[index] == _unreachable) {
+                break;
+            }
+            continue;
+        }
+
+        ArcIndex arc;
+        int targetLabel;
+        NodeIndex target = NODE_NONE;
+        if (current == 0) {
+            arc = (ArcIndex)(2 * (sourceEdgeIndex + 1));
+            targetLabel = 0;
+        } else if (current == 1) {
+            arc = (ArcIndex)(2 * sourceEdgeIndex + 1);
+            targetLabel = _size;
+        } else {
+            // The offsets lead to voxels that may lie outside of a band
+            target = _nodes->IndexForVoxel(voxel + offsets[current - 2]);
+            if (target == NODE_NONE) {
+                _currentArcs[index] = current + 1;
+                continue;
+            }
+            arc = _edges->ArcFromNodeToNode(index, target);
+            targetLabel = _labels[target];
+        }
+
+        int residual = _edges->ResidualCapacityForArc(arc);
+        if (residual > 0 && _labels[index] == targetLabel + 1) {
+            int flow = std::min(_excess[index], residual);
+            _edges->PushFlowThroughArc(arc, flow);
+            _excess[index] -= flow;
+            if (target != NODE_NONE) {
+                _excess[target] += flow;
+                ActivateInRegion(region, target);
+            }
+        } else {
+            _currentArcs[index] = current + 1;
+        }
+    }
+}
+
+
+template <vtkConnectivity Connectivity>
+void RegionPushRelabel::RelabelInRegion(int region, NodeIndex index) {
+    int label = LabelForRelabel<Connectivity>(index);
+    assert(label > _labels[index]);
+    _labels[index] = std::min(label, _unreachable);
+    _currentArcs[index] = 0;
+    ++_regionRelabels[region];
+}
+
+
+template <vtkConnectivity Connectivity>
+void RegionPushRelabel::RelabelRegion(int region) {
+    int firstNode = _regionFirstNodes[region];
+    int endNode = _regionFirstNodes[region + 1];
+
+    // The distance of every node to a terminal or to a node outside
+    // the region, through the nodes of the region. The nodes outside
+    // the region keep their labels, so the nodes next to them start
+    // at different distances: those are sorted and merged with the
+    // queue of the breadth-first search, which keeps the nodes in the
+    // order of their labels.
+    std::vector<std::pair<int, NodeIndex> > starts;
+    for (int i = firstNode; i < endNode; ++i) {
+        NodeIndex index = (NodeIndex)i;
+        EdgeIndex sourceEdgeIndex = _edges->FirstEdgeIndexForNode(index);
+        int label = _unreachable;
+        if (_edges->ResidualCapacityForArc((ArcIndex)(2 * (sourceEdgeIndex + 1))) > 0) {
+            label = 1;
+        } else if (_edges->ResidualCapacityForArc((ArcIndex)(2 * sourceEdgeIndex + 1)) > 0) {
+            label = _size + 1;
+        }
+        for (FixedNeighbourIterator<Connectivity> it(_nodes, index); !it.IsAtEnd(); it.Next()) {
+            NodeIndex neighbour = it.GetIndex();
+            if ((neighbour < firstNode || neighbour >= endNode)
+                && _edges->ResidualCapacityForArc(_edges->ArcFromNodeToNode(index, neighbour)) > 0) {
+                label = std::min(label, _labels[neighbour] + 1);
+            }
+        }
+        _labels[index] = std::min(label, _unreachable);
+        _currentArcs[index] = 0;
+        if (_labels[index] < _unreachable) {
+            starts.push_back(std::make_pair(_labels[index], index));
+        }
+    }
+    std::sort(starts.begin(), starts.end());
+
+    std::vector<char> done(endNode - firstNode, 0);
+    std::deque<NodeIndex> queue;
+    size_t start = 0;
+    while (start < starts.size() || !queue.empty()) {
+        NodeIndex index;
+        if (queue.empty() || (start < starts.size() && starts[start].first < _labels[queue.front()])) {
+            index = starts[start].second;
+            ++start;
+        } else {
+            index = queue.front();
+            queue.pop_front();
+        }
+        if (done[index - firstNode]) {
+            continue;
+        }
+        done[index - firstNode] = 1;
+        for (FixedNeighbourIterator<Connectivity> it(_nodes, index); !it.IsAtEnd(); it.Next()) {
+            NodeIndex neighbour = it.GetIndex();
+            if (neighbour >= firstNode && neighbour < endNode
+                && _labels[index] + 1 < _labels[neighbour]
+                && _edges->ResidualCapacityForArc(_edges->ArcFromNodeToNode(neighbour, index)) > 0) {
+                _labels[neighbour] = _labels[index] + 1;
+                queue.push_back(neighbour);
+            }
+        }
+    }
+}
+
+
+void RegionPushRelabel::ActivateInRegion(int region, NodeIndex index) {
+    if (_active[index]) {
+        return;
+    }
+    _active[index] = 1;
+    if (RegionForIndex(index) == region) {
+        _regionActiveNodes[region].push_back(index);
+    } else {
+        _regionBorderNodes[region].push_back(index);
+    }
+}
+
+
+template <vtkConnectivity Connectivity>
+void RegionPushRelabel::DischargeRegions(int parity) {
+    RegionDischargeFunctor<Connectivity> functor;
+    functor.solver = this;
+    functor.parity = parity;
+    vtkSMPTools::For(0, (_numberOfRegions - parity + 1) / 2, functor);
+
+    for (int region = parity; region < _numberOfRegions; region += 2) {
+        std::vector<NodeIndex>& borderNodes = _regionBorderNodes[region];
+        for (size_t i = 0; i < borderNodes.size(); ++i) {
+            _regionActiveNodes[RegionForIndex(borderNodes[i])].push_back(borderNodes[i]);
+        }
+        borderNodes.clear();
+    }
+}
+
+
+void RegionPushRelabel::DistributeActiveNodes() {
+    for (int region = 0; region < _numberOfRegions; ++region) {
+        _regionActiveNodes[region].clear();
+        _regionRelabels[region] = 0;
+    }
+    for (size_t i = 0; i < _activeNodes.size(); ++i) {
+        _regionActiveNodes[RegionForIndex(_activeNodes[i])].push_back(_activeNodes[i]);
+    }
+    _activeNodes.clear();
+}
+
+
+template void RegionPushRelabel::MaxFlow<SIX>();
+template void RegionPushRelabel::MaxFlow<EIGHTEEN>();
+template void RegionPushRelabel::MaxFlow<TWENTYSIX>();
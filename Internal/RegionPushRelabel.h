@@ -0,0 +1,115 @@
+//
+//  RegionPushRelabel.h
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 26/07/16.
+//
+//
+
+#ifndef RegionPushRelabel_h
+#define RegionPushRelabel_h
+
+#include "PushRelabel.h"
+#include "Internal/Nodes.h"
+#include <deque>
+#include <vector>
+
+
+/**
+ * RegionPushRelabel calculates a maximum flow with push-relabel on
+ * several threads, in the way of Delong and Boykov. The volume is split
+ * into slabs of whole slices, the regions, and every region discharges
+ * its own active nodes. Nodes only have neighbours in the slices right
+ * above and below them, so regions that are not next to each other
+ * share no nodes or edges: first the even regions are discharged at
+ * the same time, then the odd ones, until no region has excess left.
+ *
+ * Flow that is pushed over the border of a region is excess of a node
+ * in the region next to it, which picks it up in the next round. Every
+ * push and relabel is valid for the labels of the whole graph, so the
+ * result is the same exact maximum flow as that of PushRelabel.
+ *
+ * The gap heuristic needs to know the labels of all the nodes, so it
+ * is not used. Instead every region sets its labels to the distances
+ * through the region before it is discharged and again after every
+ * region size relabels, and the global relabel is done between rounds.
+ *
+ * The threads are those of vtkSMPTools, so vtkSMPTools::Initialize sets
+ * how many there are.
+ */
+class RegionPushRelabel : public PushRelabel {
+public:
+    /**
+     * Splits the nodes of @p edges into @p numberOfRegions regions of
+     * at least two slices, or into fewer regions when there are not
+     * enough slices.
+     */
+    RegionPushRelabel(Edges* edges, int numberOfRegions);
+    ~RegionPushRelabel();
+
+    /**
+     * Calculates a maximum flow for nodes with the given @p Connectivity,
+     * like PushRelabel::MaxFlow does.
+     * Instantiated for SIX, EIGHTEEN and TWENTYSIX.
+     */
+    template <vtkConnectivity Connectivity>
+    void MaxFlow();
+
+    /**
+     * Discharges the active nodes of @p region until none are left.
+     * Regions that are not next to each other can be discharged at the
+     * same time.
+     */
+    template <vtkConnectivity Connectivity>
+    void DischargeRegion(int region);
+
+    int GetNumberOfRegions();
+
+protected:
+    template <vtkConnectivity Connectivity>
+    void DischargeNodeInRegion(int region, NodeIndex index);
+    template <vtkConnectivity Connectivity>
+    void RelabelInRegion(int region, NodeIndex index);
+    void ActivateInRegion(int region, NodeIndex index);
+
+    /**
+     * Sets the labels of the nodes in @p region to their distances to
+     * the terminals through the region, where the nodes outside the
+     * region count with their own labels. This is the global relabel
+     * heuristic for a single region.
+     */
+    template <vtkConnectivity Connectivity>
+    void RelabelRegion(int region);
+
+    /**
+     * Discharges the regions with the given @p parity on the threads of
+     * vtkSMPTools and hands the nodes that received excess from a
+     * region next to them to their own region.
+     */
+    template <vtkConnectivity Connectivity>
+    void DischargeRegions(int parity);
+
+    /**
+     * Moves the active nodes that GlobalRelabel found to their regions.
+     */
+    void DistributeActiveNodes();
+
+    int RegionForIndex(NodeIndex index) {
+        return _regionForSlice[_nodes->VoxelForIndex(index) / _sliceSize];
+    }
+
+    int _numberOfRegions;
+    int _sliceSize;
+    std::vector<int> _regionForSlice;
+    // Index of the first node of every region, followed by the number
+    // of nodes
+    std::vector<int> _regionFirstNodes;
+
+    // For every region: the FIFO queue of its active nodes, the nodes of
+    // other regions that it pushed excess to and its number of relabels
+    std::vector<std::deque<NodeIndex> > _regionActiveNodes;
+    std::vector<std::vector<NodeIndex> > _regionBorderNodes;
+    std::vector<int> _regionRelabels;
+};
+
+#endif /* RegionPushRelabel_h */
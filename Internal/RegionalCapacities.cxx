@@ -0,0 +1,130 @@
+//
+//  RegionalCapacities.cxx
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 20/07/16.
+//
+//
+
+#include "RegionalCapacities.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define REGIONAL_CAPACITIES_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define REGIONAL_CAPACITIES_AVX2
+#include <immintrin.h>
+#endif
+
+
+// exp(x) = 2^n * exp(r) with n = round(x / ln(2)) and |r| <= ln(2) / 2.
+// ln(2) is split in two parts so that r is computed without losing
+// precision and exp(r) is approximated with the polynomial of Cephes.
+static const float ExponentMinimum = -87.0f;
+static const float Log2e = 1.44269504088896341f;
+static const float Ln2High = 0.693359375f;
+static const float Ln2Low = -2.12194440e-4f;
+static const float P0 = 1.9875691500e-4f;
+static const float P1 = 1.3981999507e-3f;
+static const float P2 = 8.3334519073e-3f;
+static const float P3 = 4.1665795894e-2f;
+static const float P4 = 1.6666665459e-1f;
+static const float P5 = 5.0000001201e-1f;
+static const float MaximumCapacity = 255.0f;
+
+
+void RegionalCapacities::Calculate(const float* exponents, int count, int* capacities) {
+    int i = 0;
+
+#ifdef REGIONAL_CAPACITIES_AVX2
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_max_ps(_mm256_loadu_ps(exponents + i), _mm256_set1_ps(ExponentMinimum));
+        __m256i n = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(Log2e)));
+        __m256 fn = _mm256_cvtepi32_ps(n);
+        __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(fn, _mm256_set1_ps(Ln2High)));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(fn, _mm256_set1_ps(Ln2Low)));
+
+        __m256 p = _mm256_set1_ps(P0);
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(P1));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(P2));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(P3));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(P4));
+        p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(P5));
+        __m256 y = _mm256_add_ps(_mm256_mul_ps(p, _mm256_mul_ps(r, r)), r);
+        y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+        __m256i scale = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+        y = _mm256_mul_ps(y, _mm256_castsi256_ps(scale));
+
+        __m256i capacity = _mm256_cvttps_epi32(_mm256_mul_ps(y, _mm256_set1_ps(MaximumCapacity)));
+        capacity = _mm256_add_epi32(capacity, _mm256_set1_epi32(1));
+        _mm256_storeu_si256((__m256i*)(capacities + i), capacity);
+    }
+#endif
+
+#ifdef REGIONAL_CAPACITIES_SSE2
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_max_ps(_mm_loadu_ps(exponents + i), _mm_set1_ps(ExponentMinimum));
+        __m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(Log2e)));
+        __m128 fn = _mm_cvtepi32_ps(n);
+        __m128 r = _mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(Ln2High)));
+        r = _mm_sub_ps(r, _mm_mul_ps(fn, _mm_set1_ps(Ln2Low)));
+
+        __m128 p = _mm_set1_ps(P0);
+        p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(P1));
+        p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(P2));
+        p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(P3));
+        p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(P4));
+        p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(P5));
+        __m128 y = _mm_add_ps(_mm_mul_ps(p, _mm_mul_ps(r, r)), r);
+        y = _mm_add_ps(y, _mm_set1_ps(1.0f));
+
+        __m128i scale = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+        y = _mm_mul_ps(y, _mm_castsi128_ps(scale));
+
+        __m128i capacity = _mm_cvttps_epi32(_mm_mul_ps(y, _mm_set1_ps(MaximumCapacity)));
+        capacity = _mm_add_epi32(capacity, _mm_set1_epi32(1));
+        _mm_storeu_si128((__m128i*)(capacities + i), capacity);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        capacities[i] = CapacityForExponent(exponents[i]);
+    }
+}
+
+
+void RegionalCapacities::CalculateReference(const float* exponents, int count, int* capacities) {
+    for (int i = 0; i < count; ++i) {
+        capacities[i] = (int)(255.0 * exp((double)exponents[i])) + 1;
+    }
+}
+
+
+int RegionalCapacities::CapacityForExponent(float exponent) {
+    float x = exponent < ExponentMinimum ? ExponentMinimum : exponent;
+    int n = (int)lrintf(x * Log2e);
+    float fn = (float)n;
+    float r = x - fn * Ln2High;
+    r = r - fn * Ln2Low;
+
+    float p = P0;
+    p = p * r + P1;
+    p = p * r + P2;
+    p = p * r + P3;
+    p = p * r + P4;
+    p = p * r + P5;
+    float y = p * (r * r) + r;
+    y = y + 1.0f;
+
+    int bits = (n + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    y = y * scale;
+
+    return (int)(y * MaximumCapacity) + 1;
+}
@@ -0,0 +1,52 @@
+//
+//  RegionalCapacities.h
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 20/07/16.
+//
+//
+
+#ifndef RegionalCapacities_h
+#define RegionalCapacities_h
+
+
+/**
+ * RegionalCapacities turns the exponents of the regional term into
+ * quantised edge capacities for many edges at once:
+ *
+ *   capacity = (int)(255 * exp(exponent)) + 1
+ *
+ * where the exponent is -(i1 - i2)^2 / (2 * variance^2) and thus never
+ * positive. The exponential is approximated with a range reduction
+ * and a polynomial that are evaluated with SSE2 or AVX2 when the
+ * compiler targets them, and with plain floats otherwise.
+ *
+ * The approximation has a relative error below 2e-7 for exponents in
+ * [-87, 0] and exponents below -87 give a capacity of 1. As a result,
+ * a capacity differs at most 1 from the one calculated with the exp of
+ * the standard library, and only when 255 * exp(exponent) lies within
+ * 1e-4 of an integer.
+ */
+class RegionalCapacities {
+public:
+    /**
+     * Calculates the capacities for the @p count @p exponents and
+     * stores them in @p capacities.
+     */
+    static void Calculate(const float* exponents, int count, int* capacities);
+
+    /**
+     * Calculates the capacities with the exp of the standard library.
+     * This is the reference that Calculate is compared with.
+     */
+    static void CalculateReference(const float* exponents, int count, int* capacities);
+
+protected:
+    /**
+     * Calculates a single capacity with the same approximation that
+     * the vectorised code uses.
+     */
+    static int CapacityForExponent(float exponent);
+};
+
+#endif /* RegionalCapacities_h */
@@ -8,38 +8,21 @@
 
 #include "Tree.h"
 #include <iostream>
+#include <algorithm>
 #include <assert.h>
 #include "Internal/Edges.h"
 #include "Internal/Edge.h"
 #include "Internal/Nodes.h"
 #include "Internal/Node.h"
-
-namespace {
-    
-    /**
-     * Update the tree depths of the children of the given node and
-     * recursively calls this method for each child.
-     */
-    void UpdateTreeDepthOfChildren(NodeIndex childIndex, int depth, Nodes* nodes);
-    
-    /**
-     * Returns all the neighbours that have the given @p parent as
-     * their parent.
-     */
-    std::vector<NodeIndex> ChildrenForNode(NodeIndex parent, Nodes* nodes);
-    
-    /**
-     * Returns the node index for the child of the given @p edge.
-     */
-    NodeIndex ChildForEdge(Edge* edge, Nodes* nodes);
-    
-}
-
+#include "Internal/NeighbourIterator.h"
+#include "Internal/ActiveNodes.h"
 
 Tree::Tree(vtkTreeType type, Edges* edges) {
     _edges = edges;
     _nodes = edges ? edges->GetNodes() : NULL;
     _treeType = type;
+    _activeNodes = NULL;
+    _time = 0;
 };
 
 
@@ -62,182 +45,408 @@ vtkTreeType Tree::GetTreeType() {
     return _treeType;
 }
 
+void Tree::SetActiveNodes(ActiveNodes* activeNodes) {
+    _activeNodes = activeNodes;
+}
+
+ActiveNodes* Tree::GetActiveNodes() {
+    return _activeNodes;
+}
+
 
 void Tree::AddChildToParent(NodeIndex childIndex, NodeIndex parentIndex) {
     assert(childIndex != parentIndex);
     
-    Edge* edge = _edges->EdgeFromNodeToNode(childIndex, parentIndex);
-    assert(edge != NULL);
+    // Store the arc in the direction of the flow
+    ArcIndex arc = _treeType == TREE_SOURCE
+        ? _edges->ArcFromNodeToNode(parentIndex, childIndex)
+        : _edges->ArcFromNodeToNode(childIndex, parentIndex);
+    assert(arc != ARC_NONE);
     
-    Node* child = _nodes->GetNode(childIndex);
+    Node child = _nodes->GetNode(childIndex);
+    if (child.parent >= 0) {
+        RemoveChildFromParent(childIndex, child.parent);
+    }
     
-    child->tree = _treeType;
-    if (edge->isTerminal()) {
-        assert(edge->rootNode() == parentIndex);
-        assert(edge->rootNode() == (int)_treeType);
-        child->parent = parentIndex;
-        child->depthInTree = 1;
+    // The depth of the child is derived from its parent and is only
+    // as recent as the timestamp of the parent. The depths in the
+    // subtree of the child are not updated: they are verified lazily
+    // during adoption.
+    child.tree = _treeType;
+    child.parent = parentIndex;
+    child.parentArc = arc;
+    if (parentIndex < 0) {
+        assert(parentIndex == (int)_treeType);
+        child.depthInTree = 1;
+        child.timestamp = _time;
+        child.nextSibling = NODE_NONE;
     } else {
-        Node* parent = _nodes->GetNode(parentIndex);
-        assert(parent->tree == _treeType);
-        child->parent = parentIndex;
-        child->depthInTree = parent->depthInTree + 1;
+        Node parent = _nodes->GetNode(parentIndex);
+        assert(parent.tree == _treeType);
+        child.depthInTree = parent.depthInTree + 1;
+        child.timestamp = parent.timestamp;
+        child.nextSibling = parent.firstChild;
+        parent.firstChild = childIndex;
     }
-    // TODO: should orphan be updated here?
-    child->orphan = false;
-    
-    UpdateTreeDepthOfChildren(childIndex, child->depthInTree, _nodes);
+    child.orphan = false;
 }
 
 
-std::vector<EdgeIndex> Tree::PathToRoot(NodeIndex leafIndex, int* maxFlow) {
-    std::vector<EdgeIndex> path;
-
-    if (leafIndex < 0) {
-        return path;
+void Tree::AddChildToRoot(NodeIndex childIndex, std::vector<NodeIndex>* orphans) {
+    // Children in the other tree can't follow the node
+    Node child = _nodes->GetNode(childIndex);
+    if (child.tree != TREE_NONE && child.tree != _treeType) {
+        OrphanChildren(childIndex, orphans);
     }
+    AddChildToParent(childIndex, (NodeIndex)_treeType);
+}
+
 
+int Tree::MaxFlowToRoot(NodeIndex leafIndex, int maxFlow) {
     NodeIndex childIndex = leafIndex;
-    do {
-        Node* child = _nodes->GetNode(childIndex);
-        NodeIndex parentIndex = child->parent;
-        assert(parentIndex != NODE_NONE);
-        EdgeIndex edgeIndex = _edges->IndexForEdgeFromNodeToNode(childIndex, parentIndex);
-        Edge* edge = _edges->GetEdge(edgeIndex);
-        path.push_back(edgeIndex);
-        NodeIndex pushFrom = _treeType == TREE_SOURCE ? parentIndex : childIndex;
-        int capacity = edge->capacityFromNode(pushFrom);
-        *maxFlow = (*maxFlow < 0 ? capacity : std::min(*maxFlow, capacity));
-        childIndex = parentIndex;
-    } while (childIndex >= 0);
-    
-    return path;
+    while (childIndex >= 0) {
+        Node child = _nodes->GetNode(childIndex);
+        assert(child.parent != NODE_NONE);
+        maxFlow = std::min(maxFlow, _edges->ResidualCapacityForArc(child.parentArc));
+        childIndex = child.parent;
+    }
+    return maxFlow;
 }
 
 
-void Tree::PushFlowThroughPath(std::vector<EdgeIndex> path, int flow, std::vector<NodeIndex>* orphans) {
-    for (std::vector<EdgeIndex>::iterator edgeIndex = path.begin(); edgeIndex != path.end(); ++edgeIndex) {
-        Edge* edge = _edges->GetEdge(*edgeIndex);
-        NodeIndex childIndex = NODE_NONE;
-        NodeIndex parentIndex = NODE_NONE;
-        if (edge->isTerminal()) {
-            childIndex = edge->nonRootNode();
-            parentIndex = edge->rootNode();
-            assert(_nodes->GetNode(childIndex)->depthInTree == 1);
-        } else {
-            Node* node1 = _nodes->GetNode(edge->node1());
-            childIndex = node1->parent == edge->node2() ? edge->node1() : edge->node2();
-            parentIndex = edge->node1() == childIndex ? edge->node2() : edge->node1();
-            assert(_nodes->GetNode(parentIndex)->depthInTree < _nodes->GetNode(childIndex)->depthInTree);
-        }
-        assert(childIndex != parentIndex);
-        NodeIndex pushFrom = _treeType == TREE_SOURCE ? parentIndex : childIndex;
-        edge->addFlowFromNode(pushFrom, flow);
-        if (edge->isSaturatedFromNode(pushFrom)) {
+void Tree::PushFlowToRoot(NodeIndex leafIndex, int flow, std::vector<NodeIndex>* orphans) {
+    NodeIndex childIndex = leafIndex;
+    while (childIndex >= 0) {
+        Node child = _nodes->GetNode(childIndex);
+        assert(child.parent != NODE_NONE);
+        _edges->PushFlowThroughArc(child.parentArc, flow);
+        if (_edges->ResidualCapacityForArc(child.parentArc) == 0) {
             orphans->push_back(childIndex);
-            _nodes->GetNode(childIndex)->orphan = true;
+            child.orphan = true;
         }
+        childIndex = child.parent;
     }
 }
 
 
 void Tree::Adopt(NodeIndex orphanIndex) {
-    assert(_nodes->GetNode(orphanIndex)->tree == _treeType);
-    std::vector<NodeIndex> neighbours = _nodes->GetIndicesForNeighbours(orphanIndex);
-    neighbours.push_back((NodeIndex)_treeType);
-    NodeIndex bestParent = NODE_NONE;
-    int bestDepthInTree = -1;
-    for (std::vector<NodeIndex>::iterator neighbour = neighbours.begin(); neighbour != neighbours.end(); ++neighbour) {
-        Edge* edge = _edges->EdgeFromNodeToNode(orphanIndex, *neighbour);
-        int depthInTree = -1;
-        if (!edge->isTerminal()) {
-            Node* node = _nodes->GetNode(*neighbour);
-            if (node->parent == orphanIndex) {
-                continue;
+    std::vector<NodeIndex> orphans(1, orphanIndex);
+    switch (_nodes->GetConnectivity()) {
+        case SIX:
+            Adopt<SIX>(&orphans);
+            break;
+        case EIGHTEEN:
+            Adopt<EIGHTEEN>(&orphans);
+            break;
+        case TWENTYSIX:
+            Adopt<TWENTYSIX>(&orphans);
+            break;
+        default:
+            assert(false);
+    }
+}
+
+
+template <vtkConnectivity Connectivity>
+void Tree::Adopt(std::vector<NodeIndex>* orphans) {
+    // Distances to the root that are computed in this pass are
+    // marked with the new time, so they can be reused
+    ++_time;
+    
+    // Orphans are processed in order from a queue instead of
+    // recursively, so that long cascades can't overflow the stack
+    _orphanQueue.clear();
+    for (std::vector<NodeIndex>::iterator i = orphans->begin(); i != orphans->end(); ++i) {
+        Node orphan = _nodes->GetNode(*i);
+        if (orphan.tree == _treeType && orphan.orphan) {
+            _orphanQueue.push_back(*i);
+        }
+    }
+    
+    for (size_t next = 0; next < _orphanQueue.size(); ++next) {
+        NodeIndex orphanIndex = _orphanQueue[next];
+        
+        NodeIndex bestParent = NODE_NONE;
+        int bestDepthInTree = -1;
+        // Visit all neighbours and finally the root of the tree
+        FixedNeighbourIterator<Connectivity> it(_nodes, orphanIndex);
+        bool visitedRoot = false;
+        while (!visitedRoot) {
+            NodeIndex neighbour = (NodeIndex)_treeType;
+            int depthInTree = 0;
+            if (!it.IsAtEnd()) {
+                neighbour = it.GetIndex();
+                it.Next();
+                if (_nodes->GetNode(neighbour).tree != _treeType) {
+                    continue;
+                }
+            } else {
+                visitedRoot = true;
             }
             
-            if (node->tree != _treeType) {
+            ArcIndex arc = _treeType == TREE_SOURCE
+                ? _edges->ArcFromNodeToNode(neighbour, orphanIndex)
+                : _edges->ArcFromNodeToNode(orphanIndex, neighbour);
+            if (_edges->ResidualCapacityForArc(arc) == 0) {
                 continue;
             }
             
-            // TODO: maybe check the whole route to root for orphans?
-            if (node->orphan) {
-                continue;
+            if (neighbour >= 0) {
+                depthInTree = DepthInTree(neighbour);
+                if (depthInTree < 0) {
+                    continue;
+                }
             }
             
-            depthInTree = node->depthInTree;
-        } else {
-            depthInTree = 0;
+            if (bestDepthInTree < 0 || depthInTree < bestDepthInTree) {
+                bestParent = neighbour;
+                bestDepthInTree = depthInTree;
+            }
         }
         
-        NodeIndex childIndex = ChildForEdge(edge, _nodes);
-        NodeIndex parentIndex = edge->otherNode(childIndex);
-        NodeIndex pushFrom = _treeType == TREE_SOURCE ? parentIndex : childIndex;
-        if (edge->isSaturatedFromNode(pushFrom)) {
+        if (bestParent != NODE_NONE) {
+            AddChildToParent(orphanIndex, bestParent);
             continue;
         }
         
-        if (bestDepthInTree < 0 || depthInTree < bestDepthInTree) {
-            bestParent = *neighbour;
-            bestDepthInTree = depthInTree;
+        // No parent was found, so the node becomes free
+        Node node = _nodes->GetNode(orphanIndex);
+        if (node.parent >= 0) {
+            RemoveChildFromParent(orphanIndex, node.parent);
         }
-    }
-    
-    if (bestParent != NODE_NONE) {
-        AddChildToParent(orphanIndex, bestParent);
-    } else {
-        Node* node = _nodes->GetNode(orphanIndex);
-        node->orphan = false;
-        node->parent = NODE_NONE;
-        node->depthInTree = -1;
+        node.tree = TREE_NONE;
+        node.orphan = false;
+        node.parent = NODE_NONE;
+        node.parentArc = ARC_NONE;
+        node.depthInTree = -1;
+        
+        // All its children become orphans
+        OrphanChildren(orphanIndex, &_orphanQueue);
         
-        std::vector<NodeIndex> children = ChildrenForNode(orphanIndex, _nodes);
-        for (std::vector<NodeIndex>::iterator childIndex = children.begin(); childIndex != children.end(); ++childIndex) {
-            Node* child = _nodes->GetNode(*childIndex);
-            child->orphan = true;
-            child->parent = NODE_NONE;
-            Adopt(*childIndex);
+        // Neighbours that could grow into the free node
+        // should become active again
+        if (_activeNodes) {
+            for (FixedNeighbourIterator<Connectivity> it(_nodes, orphanIndex); !it.IsAtEnd(); it.Next()) {
+                NodeIndex neighbour = it.GetIndex();
+                if (_nodes->GetNode(neighbour).tree != _treeType) {
+                    continue;
+                }
+                ArcIndex arc = _treeType == TREE_SOURCE
+                    ? _edges->ArcFromNodeToNode(neighbour, orphanIndex)
+                    : _edges->ArcFromNodeToNode(orphanIndex, neighbour);
+                if (_edges->ResidualCapacityForArc(arc) > 0) {
+                    _activeNodes->Push(neighbour);
+                }
+            }
         }
     }
-    
+    _orphanQueue.clear();
 }
 
 
-namespace {
-    
-    void UpdateTreeDepthOfChildren(NodeIndex parentIndex, int depth, Nodes* nodes) {
-        std::vector<NodeIndex> children = ChildrenForNode(parentIndex, nodes);
-        for (std::vector<NodeIndex>::iterator child = children.begin(); child != children.end(); ++child) {
-            Node* node = nodes->GetNode(*child);
-            if (node->parent == parentIndex) {
-                node->depthInTree = depth + 1;
-                // TODO: should orphan be updated here?
-                node->orphan = false;
-                UpdateTreeDepthOfChildren(*child, node->depthInTree, nodes);
-            }
+template <vtkConnectivity Connectivity>
+void Tree::AdoptByDistance(std::vector<NodeIndex>* orphans, int maximumDepth) {
+    _orphanQueue.clear();
+    for (std::vector<NodeIndex>::iterator i = orphans->begin(); i != orphans->end(); ++i) {
+        Node orphan = _nodes->GetNode(*i);
+        if (orphan.tree == _treeType && orphan.orphan) {
+            _orphanQueue.push_back(*i);
         }
     }
     
-    std::vector<NodeIndex> ChildrenForNode(NodeIndex parentIndex, Nodes* nodes) {
-        std::vector<NodeIndex> neighbours = nodes->GetIndicesForNeighbours(parentIndex);
-        std::vector<NodeIndex> children;
-        for (std::vector<NodeIndex>::iterator neighbour = neighbours.begin(); neighbour != neighbours.end(); ++neighbour) {
-            if (nodes->GetNode(*neighbour)->parent == parentIndex) {
-                children.push_back(*neighbour);
+    for (size_t next = 0; next < _orphanQueue.size(); ++next) {
+        NodeIndex orphanIndex = _orphanQueue[next];
+        Node orphan = _nodes->GetNode(orphanIndex);
+        int depthInTree = orphan.depthInTree;
+        
+        // The root is the best parent there is, and then a parent one
+        // level up. Such a parent can't be a descendant, because the
+        // depths along the edges of the tree are exact.
+        NodeIndex bestParent = NODE_NONE;
+        int bestDepthInTree = -1;
+        ArcIndex terminalArc = _treeType == TREE_SOURCE
+            ? _edges->ArcFromNodeToNode(NODE_SOURCE, orphanIndex)
+            : _edges->ArcFromNodeToNode(orphanIndex, NODE_SINK);
+        if (_edges->ResidualCapacityForArc(terminalArc) > 0) {
+            bestParent = (NodeIndex)_treeType;
+            bestDepthInTree = 0;
+        } else {
+            for (FixedNeighbourIterator<Connectivity> it(_nodes, orphanIndex); !it.IsAtEnd(); it.Next()) {
+                NodeIndex neighbour = it.GetIndex();
+                Node node = _nodes->GetNode(neighbour);
+                if (node.tree != _treeType || node.orphan || node.depthInTree != depthInTree - 1) {
+                    continue;
+                }
+                ArcIndex arc = _treeType == TREE_SOURCE
+                    ? _edges->ArcFromNodeToNode(neighbour, orphanIndex)
+                    : _edges->ArcFromNodeToNode(orphanIndex, neighbour);
+                if (_edges->ResidualCapacityForArc(arc) > 0) {
+                    bestParent = neighbour;
+                    bestDepthInTree = node.depthInTree;
+                    break;
+                }
+            }
+        }
+        
+        // Otherwise the orphan moves down or becomes free, so its
+        // children are orphaned first. A deeper parent has to reach the
+        // root without passing an orphan, as in Adopt, so that it can't
+        // be in the subtree of the orphan.
+        if (bestParent == NODE_NONE) {
+            OrphanChildren(orphanIndex, &_orphanQueue);
+            for (FixedNeighbourIterator<Connectivity> it(_nodes, orphanIndex); !it.IsAtEnd(); it.Next()) {
+                NodeIndex neighbour = it.GetIndex();
+                Node node = _nodes->GetNode(neighbour);
+                if (node.tree != _treeType || node.orphan) {
+                    continue;
+                }
+                if (bestDepthInTree >= 0 && node.depthInTree >= bestDepthInTree) {
+                    continue;
+                }
+                ArcIndex arc = _treeType == TREE_SOURCE
+                    ? _edges->ArcFromNodeToNode(neighbour, orphanIndex)
+                    : _edges->ArcFromNodeToNode(orphanIndex, neighbour);
+                if (_edges->ResidualCapacityForArc(arc) > 0 && ReachesRoot(neighbour)) {
+                    bestParent = neighbour;
+                    bestDepthInTree = node.depthInTree;
+                }
+            }
+        }
+        
+        if (bestParent != NODE_NONE && bestDepthInTree + 1 <= maximumDepth) {
+            // Children only keep exact depths when the node stays at
+            // its depth
+            bool moved = bestDepthInTree + 1 != depthInTree;
+            if (moved) {
+                OrphanChildren(orphanIndex, &_orphanQueue);
+            }
+            AddChildToParent(orphanIndex, bestParent);
+            if (moved && _activeNodes) {
+                _activeNodes->Push(orphanIndex);
+            }
+            continue;
+        }
+        
+        // No parent was found, so the node becomes free
+        if (orphan.parent >= 0) {
+            RemoveChildFromParent(orphanIndex, orphan.parent);
+        }
+        orphan.tree = TREE_NONE;
+        orphan.orphan = false;
+        orphan.parent = NODE_NONE;
+        orphan.parentArc = ARC_NONE;
+        orphan.depthInTree = -1;
+        OrphanChildren(orphanIndex, &_orphanQueue);
+        
+        // Neighbours that could grow into the free node have to be
+        // scanned again, including orphans that find a parent later
+        if (_activeNodes) {
+            for (FixedNeighbourIterator<Connectivity> it(_nodes, orphanIndex); !it.IsAtEnd(); it.Next()) {
+                NodeIndex neighbour = it.GetIndex();
+                if (_nodes->GetNode(neighbour).tree != _treeType) {
+                    continue;
+                }
+                ArcIndex arc = _treeType == TREE_SOURCE
+                    ? _edges->ArcFromNodeToNode(neighbour, orphanIndex)
+                    : _edges->ArcFromNodeToNode(orphanIndex, neighbour);
+                if (_edges->ResidualCapacityForArc(arc) > 0) {
+                    _activeNodes->Push(neighbour);
+                }
             }
         }
-        return children;
     }
-    
-    NodeIndex ChildForEdge(Edge* edge, Nodes* nodes) {
-        NodeIndex childIndex = NODE_NONE;
-        if (edge->isTerminal()) {
-            childIndex = edge->nonRootNode();
-        } else {
-            Node* node1 = nodes->GetNode(edge->node1());
-            childIndex = node1->parent == edge->node2() ? edge->node1() : edge->node2();
+    _orphanQueue.clear();
+}
+
+
+bool Tree::ReachesRoot(NodeIndex index) {
+    for (NodeIndex current = index; current >= 0; current = _nodes->GetNode(current).parent) {
+        if (_nodes->GetNode(current).orphan) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+int Tree::DepthInTree(NodeIndex index) {
+    // Walk up until the root or a node that was verified in this
+    // pass is found. An orphan on the way means there is no path.
+    int depth = 0;
+    NodeIndex current = index;
+    while (true) {
+        Node node = _nodes->GetNode(current);
+        if (node.orphan) {
+            return -1;
         }
-        return childIndex;
+        if (node.timestamp == _time) {
+            depth += node.depthInTree;
+            break;
+        }
+        ++depth;
+        if (node.parent < 0) {
+            assert(node.parent == (NodeIndex)_treeType);
+            node.timestamp = _time;
+            node.depthInTree = 1;
+            break;
+        }
+        current = node.parent;
     }
     
+    // Cache the depths of the nodes on the path for this pass
+    int result = depth;
+    for (current = index; _nodes->GetNode(current).timestamp != _time; current = _nodes->GetNode(current).parent) {
+        Node node = _nodes->GetNode(current);
+        node.timestamp = _time;
+        node.depthInTree = depth;
+        --depth;
+    }
+    return result;
 }
+
+
+void Tree::OrphanChildren(NodeIndex parentIndex, std::vector<NodeIndex>* orphans) {
+    Node parent = _nodes->GetNode(parentIndex);
+    NodeIndex childIndex = parent.firstChild;
+    parent.firstChild = NODE_NONE;
+    while (childIndex != NODE_NONE) {
+        Node child = _nodes->GetNode(childIndex);
+        NodeIndex nextSibling = child.nextSibling;
+        child.parent = NODE_NONE;
+        child.nextSibling = NODE_NONE;
+        if (!child.orphan) {
+            child.orphan = true;
+            orphans->push_back(childIndex);
+        }
+        childIndex = nextSibling;
+    }
+}
+
+
+void Tree::RemoveChildFromParent(NodeIndex childIndex, NodeIndex parentIndex) {
+    Node parent = _nodes->GetNode(parentIndex);
+    NodeIndex nextSibling = _nodes->GetNode(childIndex).nextSibling;
+    if (parent.firstChild == childIndex) {
+        parent.firstChild = nextSibling;
+    } else {
+        NodeIndex sibling = parent.firstChild;
+        while (sibling != NODE_NONE) {
+            Node node = _nodes->GetNode(sibling);
+            if (node.nextSibling == childIndex) {
+                node.nextSibling = nextSibling;
+                break;
+            }
+            sibling = node.nextSibling;
+        }
+    }
+    _nodes->GetNode(childIndex).nextSibling = NODE_NONE;
+}
+
+
+// Instantiations for use by the solver kernels
+template void Tree::Adopt<SIX>(std::vector<NodeIndex>*);
+template void Tree::Adopt<EIGHTEEN>(std::vector<NodeIndex>*);
+template void Tree::Adopt<TWENTYSIX>(std::vector<NodeIndex>*);
+template void Tree::AdoptByDistance<SIX>(std::vector<NodeIndex>*, int);
+template void Tree::AdoptByDistance<EIGHTEEN>(std::vector<NodeIndex>*, int);
+template void Tree::AdoptByDistance<TWENTYSIX>(std::vector<NodeIndex>*, int);
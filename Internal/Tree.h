@@ -10,6 +10,7 @@
 #define vtkTree_h
 
 #include "vtkGraphCutDataTypes.h"
+#include "vtkGraphCutDefinitions.h"
 #include <vector>
 
 
@@ -17,6 +18,7 @@ class Edges;
 class Edge;
 class Nodes;
 class Node;
+class ActiveNodes;
 
 
 /**
@@ -36,27 +38,45 @@ public:
     
     vtkTreeType GetTreeType();
     
+    /**
+     * The active nodes of the tree. When a node leaves the tree
+     * during adoption, its neighbours in the tree are made active
+     * so that they can grow into it again. May be NULL.
+     */
+    void SetActiveNodes(ActiveNodes* activeNodes);
+    ActiveNodes* GetActiveNodes();
+    
     /**
      * Adds the node at index @p child as child to the node
-     * at index @p parent. If the child has any children, the
-     * @p depthInTree property of all these children will be
-     * updated recursively.
+     * at index @p parent. If the child had a parent, it is removed
+     * from the children of that parent first. The depth of the child
+     * is taken from the parent; the depths of its own children are
+     * not updated but are verified lazily during adoption.
      */
     void AddChildToParent(NodeIndex child, NodeIndex parent);
     
     /**
-     * Returns the path to the root as a vector of edge indices.
-     * The value of @p maxFlow will be updated to hold the value of
-     * the maximum flow that is possible to push through the path.
+     * Adds the node at index @p child as child to the root of this
+     * tree. When the node was part of the other tree, its children
+     * there become orphans and are added to @p orphans.
      */
-    std::vector<EdgeIndex> PathToRoot(NodeIndex leaf, int* maxFlow);
+    void AddChildToRoot(NodeIndex child, std::vector<NodeIndex>* orphans);
     
     /**
-     * Pushes the given @p flow through all the edges in @p path.
-     * Whenever an edge becomes saturated, the node is made an orphan
-     * and added to the @p orphans vector.
+     * Returns the smallest residual capacity on the path from
+     * @p leaf to the root of the tree, or @p maxFlow when that
+     * is smaller. The path is followed through the parents of
+     * the nodes, so no edges have to be looked up.
      */
-    void PushFlowThroughPath(std::vector<EdgeIndex> path, int flow, std::vector<NodeIndex>* orphans);
+    int MaxFlowToRoot(NodeIndex leaf, int maxFlow);
+    
+    /**
+     * Pushes the given @p flow through all the arcs on the path
+     * from @p leaf to the root of the tree. Whenever an arc becomes
+     * saturated, its child is made an orphan and added to the
+     * @p orphans vector.
+     */
+    void PushFlowToRoot(NodeIndex leaf, int flow, std::vector<NodeIndex>* orphans);
     
     /**
      * Adopts the orphan at @p orphanIndex by looking for a new parent.
@@ -65,15 +85,72 @@ public:
      * From all the possible parents, the parent with the lowest depth in
      * the tree is chosen.
      * When no adopting parent can be found, then the node is removed from
-     * the tree and then all its children become orphans and will be adopted 
-     * recursively.
+     * the tree and then all its children become orphans and will be adopted
+     * in turn. Orphans are kept in a queue, so no recursion is involved.
      */
     void Adopt(NodeIndex orphanIndex);
     
+    /**
+     * Adopts all the @p orphans that belong to this tree in one pass,
+     * for nodes with the given @p Connectivity. Distances to the root
+     * that are found during the pass are marked with a timestamp, so
+     * that every path is walked at most once per pass.
+     * Instantiated for SIX, EIGHTEEN and TWENTYSIX.
+     */
+    template <vtkConnectivity Connectivity>
+    void Adopt(std::vector<NodeIndex>* orphans);
+    
+    /**
+     * Adopts the @p orphans the way incremental breadth-first search
+     * does, where the depth of every node in the tree is kept exact and
+     * serves as its distance label. An orphan first looks for a parent
+     * one level up. Otherwise it takes the parent with the lowest depth,
+     * which moves it down, and its children become orphans. An orphan
+     * that would end up deeper than @p maximumDepth becomes free.
+     * Nodes that have to be scanned again, because they moved down or
+     * could grow into a free node, are pushed to the active nodes.
+     * Instantiated for SIX, EIGHTEEN and TWENTYSIX.
+     */
+    template <vtkConnectivity Connectivity>
+    void AdoptByDistance(std::vector<NodeIndex>* orphans, int maximumDepth);
+    
 protected:
+    /**
+     * Returns the distance of the node at @p index to the root, or -1
+     * when the path through its parents passes an orphan. The depths of
+     * the nodes on the path are cached for the current timestamp.
+     */
+    int DepthInTree(NodeIndex index);
+    
+    /**
+     * Returns whether the path through the parents of the node at
+     * @p index reaches the root without passing an orphan.
+     */
+    bool ReachesRoot(NodeIndex index);
+    
+    /**
+     * Detaches all the children of the node at @p parent and makes
+     * them orphans. Children that were not orphans yet are added
+     * to @p orphans.
+     */
+    void OrphanChildren(NodeIndex parent, std::vector<NodeIndex>* orphans);
+    
+    /**
+     * Removes the node at @p child from the list of children of the
+     * node at @p parent.
+     */
+    void RemoveChildFromParent(NodeIndex child, NodeIndex parent);
+    
     Edges* _edges;
     Nodes* _nodes;
     vtkTreeType _treeType;
+    ActiveNodes* _activeNodes;
+    
+    // Timestamp of the current adoption pass
+    int _time;
+    
+    // Work queue that is reused to avoid allocations
+    std::vector<NodeIndex> _orphanQueue;
 };
 
 
@@ -0,0 +1,115 @@
+//
+//  ActiveNodesTest.cxx
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 18/07/16.
+//
+//
+
+#include <assert.h>
+#include "Internal/ActiveNodes.h"
+#include "Internal/Nodes.h"
+#include "Internal/Node.h"
+
+
+void testActiveNodesConstructor();
+void testActiveNodesOrder();
+void testActiveNodesNoDuplicates();
+
+
+int main() {
+    testActiveNodesConstructor();
+    testActiveNodesOrder();
+    testActiveNodesNoDuplicates();
+    return 0;
+}
+
+
+Nodes* createNodes() {
+    int dimensions[3] = {2, 3, 4};
+    Nodes* nodes = new Nodes();
+    nodes->SetDimensions(dimensions);
+    nodes->SetConnectivity(SIX);
+    nodes->Update();
+    return nodes;
+}
+
+
+void testActiveNodesConstructor() {
+    Nodes* nodes = createNodes();
+    ActiveNodes* activeNodes = new ActiveNodes(nodes);
+    
+    assert(activeNodes->IsEmpty());
+    assert(activeNodes->GetFront() == NODE_NONE);
+    
+    delete activeNodes;
+    delete nodes;
+}
+
+
+/**
+ * Nodes should come out in the order in which they were pushed
+ * and should be marked inactive once popped.
+ */
+void testActiveNodesOrder() {
+    Nodes* nodes = createNodes();
+    ActiveNodes* activeNodes = new ActiveNodes(nodes);
+    
+    activeNodes->Push((NodeIndex)5);
+    activeNodes->Push((NodeIndex)2);
+    activeNodes->Push((NodeIndex)7);
+    assert(nodes->GetNode(5).active);
+    assert(nodes->GetNode(2).active);
+    assert(nodes->GetNode(7).active);
+    
+    assert(activeNodes->GetFront() == 5);
+    activeNodes->Pop();
+    assert(!nodes->GetNode(5).active);
+    assert(activeNodes->GetFront() == 2);
+    
+    // Pushing after popping should append to the end
+    activeNodes->Push((NodeIndex)5);
+    activeNodes->Pop();
+    assert(activeNodes->GetFront() == 7);
+    activeNodes->Pop();
+    assert(activeNodes->GetFront() == 5);
+    activeNodes->Pop();
+    assert(activeNodes->IsEmpty());
+    
+    delete activeNodes;
+    delete nodes;
+}
+
+
+/**
+ * Pushing a node that is already active should not change the list.
+ */
+void testActiveNodesNoDuplicates() {
+    Nodes* nodes = createNodes();
+    ActiveNodes* activeNodes = new ActiveNodes(nodes);
+    ActiveNodes* otherActiveNodes = new ActiveNodes(nodes);
+    
+    activeNodes->Push((NodeIndex)3);
+    activeNodes->Push((NodeIndex)4);
+    activeNodes->Push((NodeIndex)3);
+    otherActiveNodes->Push((NodeIndex)4);
+    assert(otherActiveNodes->IsEmpty());
+    
+    assert(activeNodes->GetFront() == 3);
+    activeNodes->Pop();
+    assert(activeNodes->GetFront() == 4);
+    activeNodes->Pop();
+    assert(activeNodes->IsEmpty());
+    
+    activeNodes->Push((NodeIndex)1);
+    activeNodes->Push((NodeIndex)0);
+    activeNodes->Clear();
+    assert(activeNodes->IsEmpty());
+    assert(!nodes->GetNode(1).active);
+    assert(!nodes->GetNode(0).active);
+    
+    delete otherActiveNodes;
+    delete activeNodes;
+    delete nodes;
+}
+
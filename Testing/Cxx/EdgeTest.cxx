@@ -33,12 +33,13 @@ void testEdgeStruct() {
     NodeIndex node0 = (NodeIndex)0;
     NodeIndex node1 = (NodeIndex)1;
     
-    Edge edge = Edge(NODE_SINK, node1);
+    int residuals[2] = {0, 0};
+    Edge edge = Edge(NODE_SINK, node1, residuals);
     assert(edge.isTerminal());
     assert(edge.flowFromNode(node0) == 0);
     assert(edge.capacityFromNode(node0) == 0);
     
-    edge = Edge(node0, node1);
+    edge = Edge(node0, node1, residuals);
     assert(!edge.isTerminal());
     
     edge.setCapacity(5);
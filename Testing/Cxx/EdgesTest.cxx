@@ -7,9 +7,11 @@
 //
 
 #include <assert.h>
+#include <vector>
 #include "Internal/Edges.h"
 #include "Internal/Nodes.h"
 #include "Internal/Edge.h"
+#include "Internal/NeighbourIterator.h"
 
 
 void testEdgesConstructor();
@@ -23,6 +25,9 @@ void testCreateEdges();
 void testIndexForEdgeFromNodeToNode();
 void testEdgeFromNodeToNode();
 void testEdgeFromNodeToNodeWithConnectivity(Edges*);
+void testArcFromNodeToNode();
+void testResetFlow();
+void testEdgesWithBand();
 
 
 int main() {
@@ -36,6 +41,9 @@ int main() {
     testCreateEdges();
     testIndexForEdgeFromNodeToNode();
     testEdgeFromNodeToNode();
+    testArcFromNodeToNode();
+    testResetFlow();
+    testEdgesWithBand();
     return 0;
 }
 
@@ -77,18 +85,18 @@ void testEdgesUpdate() {
     Edges* edges = new Edges();
     edges->SetNodes(nodes);
 
-    assert(edges->GetEdge((EdgeIndex)0) == NULL);
+    assert(!edges->GetEdge((EdgeIndex)0).isValid());
 
     edges->Update();
 
-    Edge* someEdge = edges->GetEdge((EdgeIndex)0);
-    assert(someEdge != NULL);
-    assert(edges->GetEdge(EDGE_NONE) == NULL);
-    assert(edges->GetEdge((EdgeIndex)300) == NULL);
+    Edge someEdge = edges->GetEdge((EdgeIndex)0);
+    assert(someEdge.isValid());
+    assert(!edges->GetEdge(EDGE_NONE).isValid());
+    assert(!edges->GetEdge((EdgeIndex)300).isValid());
     
-    someEdge->setCapacity(1);
+    someEdge.setCapacity(1);
     
-    assert(edges->GetEdge((EdgeIndex)0)->capacityFromNode((NodeIndex)0) == 1);
+    assert(edges->GetEdge((EdgeIndex)0).capacityFromNode((NodeIndex)0) == 1);
     
     delete edges;
     delete nodes;
@@ -109,7 +117,7 @@ void testEdgesReset() {
     edges->Reset();
     
     assert(edges->GetNodes() == NULL);
-    assert(edges->GetEdge((EdgeIndex)0) == NULL);
+    assert(!edges->GetEdge((EdgeIndex)0).isValid());
     
     // Make sure that calling Update on a reset edges object
     // will not fail
@@ -132,13 +140,14 @@ void testEdgesDoubleUpdate() {
     edges->SetNodes(nodes);
     edges->Update();
     
-    Edge* edge = edges->GetEdge((EdgeIndex)0);
+    Edge edge = edges->GetEdge((EdgeIndex)0);
+    edge.setCapacity(3);
     
     edges->Update();
-    Edge* sameEdge = edges->GetEdge((EdgeIndex)0);
+    Edge sameEdge = edges->GetEdge((EdgeIndex)0);
     
-    // Should be the exact same object
-    assert(edge == sameEdge);
+    // Should point to the exact same storage
+    assert(sameEdge.capacityFromNode(sameEdge.node1()) == 3);
     
     delete edges;
     delete nodes;
@@ -166,9 +175,9 @@ void testCreateEdges() {
     
     Edges* edges = new Edges();
     edges->SetNodes(nodes);
-    std::vector<Edge*>* edgesVector = edges->CreateEdgesForNodes(nodes);
+    edges->CreateEdgesForNodes(nodes);
     
-    assert(edgesVector->size() == 2);
+    assert(edges->GetSize() == 2);
     
     dimensions[0] = 2;
     dimensions[1] = 1;
@@ -182,25 +191,25 @@ void testCreateEdges() {
     edges->SetNodes(nodes);
     edges->Update();
     
-    edgesVector = edges->CreateEdgesForNodes(nodes);
+    edges->CreateEdgesForNodes(nodes);
     int numberOfNodes = dimensions[0] * dimensions[1] * dimensions[2];
     int numberOfEdges = numberOfNodes * 2 + numberOfNodes * (26);
-    assert(edgesVector->size() == 5);
+    assert(edges->GetSize() == 5);
     
     nodes->Reset();
     nodes->SetDimensions(dimensions);
     nodes->SetConnectivity(EIGHTEEN);
     nodes->Update();
 
-    assert(edgesVector->size() == 5);
+    assert(edges->GetSize() == 5);
     
     nodes->Reset();
     nodes->SetDimensions(dimensions);
     nodes->SetConnectivity(SIX);
     nodes->Update();
-    edgesVector = edges->CreateEdgesForNodes(nodes);
+    edges->CreateEdgesForNodes(nodes);
     numberOfEdges = numberOfNodes * 2 + numberOfNodes * (6);
-    assert(edgesVector->size() == 5);
+    assert(edges->GetSize() == 5);
     
     dimensions[0] = 2;
     dimensions[1] = 2;
@@ -210,24 +219,24 @@ void testCreateEdges() {
     nodes->SetDimensions(dimensions);
     nodes->SetConnectivity(TWENTYSIX);
     nodes->Update();
-    edgesVector = edges->CreateEdgesForNodes(nodes);
+    edges->CreateEdgesForNodes(nodes);
     
-    assert(edgesVector->size() == 14);
+    assert(edges->GetSize() == 14);
     
     nodes->Reset();
     nodes->SetDimensions(dimensions);
     nodes->SetConnectivity(EIGHTEEN);
     nodes->Update();
     
-    assert(edgesVector->size() == 14);
+    assert(edges->GetSize() == 14);
     
     nodes->Reset();
     nodes->SetDimensions(dimensions);
     nodes->SetConnectivity(SIX);
     nodes->Update();
-    edgesVector = edges->CreateEdgesForNodes(nodes);
+    edges->CreateEdgesForNodes(nodes);
     
-    assert(edgesVector->size() == 12);
+    assert(edges->GetSize() == 12);
     
     dimensions[0] = 2;
     dimensions[1] = 3;
@@ -237,9 +246,9 @@ void testCreateEdges() {
     nodes->SetDimensions(dimensions);
     nodes->SetConnectivity(TWENTYSIX);
     nodes->Update();
-    edgesVector = edges->CreateEdgesForNodes(nodes);
+    edges->CreateEdgesForNodes(nodes);
     
-    assert(edgesVector->size() == 23);
+    assert(edges->GetSize() == 23);
     
     dimensions[0] = 20;
     dimensions[1] = 33;
@@ -249,9 +258,9 @@ void testCreateEdges() {
     nodes->SetDimensions(dimensions);
     nodes->SetConnectivity(TWENTYSIX);
     nodes->Update();
-    edgesVector = edges->CreateEdgesForNodes(nodes);
+    edges->CreateEdgesForNodes(nodes);
 
-    assert(edgesVector->size() == 107522);
+    assert(edges->GetSize() == 107522);
     
     delete edges;
     delete nodes;
@@ -382,46 +391,197 @@ void testEdgeFromNodeToNode() {
  * Tests getting the edge between two nodes for the specified connectivity.
  */
 void testEdgeFromNodeToNodeWithConnectivity(Edges* edges) {
-    Edge* edge = edges->EdgeFromNodeToNode((NodeIndex)0, (NodeIndex)1);
-    assert(edge->node1() == 0);
-    assert(edge->node2() == 1);
+    Edge edge = edges->EdgeFromNodeToNode((NodeIndex)0, (NodeIndex)1);
+    assert(edge.node1() == 0);
+    assert(edge.node2() == 1);
     
     edge = edges->EdgeFromNodeToNode((NodeIndex)1, (NodeIndex)0);
-    assert(edge->node1() == 0);
-    assert(edge->node2() == 1);
+    assert(edge.node1() == 0);
+    assert(edge.node2() == 1);
     
     edge = edges->EdgeFromNodeToNode((NodeIndex)NODE_SOURCE, (NodeIndex)80);
-    assert(edge->node1() == NODE_SOURCE);
-    assert(edge->node2() == (NodeIndex)80);
+    assert(edge.node1() == NODE_SOURCE);
+    assert(edge.node2() == (NodeIndex)80);
     
     edge = edges->EdgeFromNodeToNode((NodeIndex)80, (NodeIndex)NODE_SOURCE);
-    assert(edge->node1() == NODE_SOURCE);
-    assert(edge->node2() == (NodeIndex)80);
+    assert(edge.node1() == NODE_SOURCE);
+    assert(edge.node2() == (NodeIndex)80);
     
     edge = edges->EdgeFromNodeToNode((NodeIndex)80, (NodeIndex)81);
-    assert(edge->node1() == (NodeIndex)80);
-    assert(edge->node2() == (NodeIndex)81);
+    assert(edge.node1() == (NodeIndex)80);
+    assert(edge.node2() == (NodeIndex)81);
     
     edge = edges->EdgeFromNodeToNode((NodeIndex)81, (NodeIndex)80);
-    assert(edge->node1() == (NodeIndex)80);
-    assert(edge->node2() == (NodeIndex)81);
+    assert(edge.node1() == (NodeIndex)80);
+    assert(edge.node2() == (NodeIndex)81);
     
     edge = edges->EdgeFromNodeToNode((NodeIndex)80, NODE_SINK);
-    assert(edge->node1() == (NodeIndex)80);
-    assert(edge->node2() == NODE_SINK);
+    assert(edge.node1() == (NodeIndex)80);
+    assert(edge.node2() == NODE_SINK);
     
     edge = edges->EdgeFromNodeToNode(NODE_SINK, (NodeIndex)80);
-    assert(edge->node1() == (NodeIndex)80);
-    assert(edge->node2() == NODE_SINK);
+    assert(edge.node1() == (NodeIndex)80);
+    assert(edge.node2() == NODE_SINK);
     
     edge = edges->EdgeFromNodeToNode((NodeIndex)80, (NodeIndex)79);
-    assert(edge->node1() == (NodeIndex)79);
-    assert(edge->node2() == (NodeIndex)80);
+    assert(edge.node1() == (NodeIndex)79);
+    assert(edge.node2() == (NodeIndex)80);
     
     edge = edges->EdgeFromNodeToNode((NodeIndex)79, (NodeIndex)80);
-    assert(edge->node1() == (NodeIndex)79);
-    assert(edge->node2() == (NodeIndex)80);
+    assert(edge.node1() == (NodeIndex)79);
+    assert(edge.node2() == (NodeIndex)80);
     
     edge = edges->EdgeFromNodeToNode((NodeIndex)0, (NodeIndex)100);
-    assert(edge == NULL);
+    assert(!edge.isValid());
+}
+
+
+/**
+ * Arcs should match the direction of the edge accessors and
+ * pushing flow through an arc should show up in the edge.
+ */
+void testArcFromNodeToNode() {
+    int dimensions[3] = {3, 3, 3};
+    Nodes* nodes = new Nodes();
+    nodes->SetDimensions(dimensions);
+    nodes->SetConnectivity(SIX);
+    nodes->Update();
+    
+    Edges* edges = new Edges();
+    edges->SetNodes(nodes);
+    edges->Update();
+    
+    NodeIndex node0 = (NodeIndex)4;
+    NodeIndex node1 = (NodeIndex)13;
+    NodeIndex pairs[3][2] = {
+        {NODE_SOURCE, node0},
+        {node0, NODE_SINK},
+        {node0, node1}
+    };
+    for (int i = 0; i < 3; ++i) {
+        NodeIndex from = pairs[i][0];
+        NodeIndex to = pairs[i][1];
+        ArcIndex arc = edges->ArcFromNodeToNode(from, to);
+        ArcIndex reverseArc = edges->ArcFromNodeToNode(to, from);
+        assert(arc != ARC_NONE);
+        assert((arc ^ 1) == reverseArc);
+        assert(arc / 2 == edges->IndexForEdgeFromNodeToNode(from, to));
+        
+        Edge edge = edges->EdgeFromNodeToNode(from, to);
+        edge.setCapacity(5);
+        assert(edges->ResidualCapacityForArc(arc) == 5);
+        
+        edges->PushFlowThroughArc(arc, 2);
+        assert(edges->ResidualCapacityForArc(arc) == 3);
+        assert(edges->ResidualCapacityForArc(reverseArc) == 7);
+        assert(edge.flowFromNode(from) == 2);
+        assert(edge.capacityFromNode(from) == 3);
+    }
+    
+    // Nodes that are not connected have no arc
+    assert(edges->ArcFromNodeToNode((NodeIndex)0, (NodeIndex)4) == ARC_NONE);
+    
+    delete edges;
+    delete nodes;
+}
+
+
+void testResetFlow() {
+    int dimensions[3] = {3, 3, 3};
+    Nodes* nodes = new Nodes();
+    nodes->SetDimensions(dimensions);
+    nodes->SetConnectivity(SIX);
+    nodes->Update();
+    
+    Edges* edges = new Edges();
+    edges->SetNodes(nodes);
+    edges->Update();
+    
+    NodeIndex node0 = (NodeIndex)4;
+    NodeIndex node1 = (NodeIndex)13;
+    Edge edge = edges->EdgeFromNodeToNode(node0, node1);
+    edge.setCapacity(5);
+    ArcIndex arc = edges->ArcFromNodeToNode(node1, node0);
+    edges->PushFlowThroughArc(arc, 4);
+    assert(edge.flowFromNode(node1) == 4);
+    
+    edges->ResetFlow();
+    assert(edge.flowFromNode(node1) == 0);
+    assert(edge.capacityFromNode(node0) == 5);
+    assert(edge.capacityFromNode(node1) == 5);
+    
+    delete edges;
+    delete nodes;
+}
+
+
+/**
+ * Tests the edges of nodes that only cover a band: every node has
+ * edges to the terminals and to its neighbours in the band, and
+ * every edge index is used exactly once.
+ */
+void testEdgesWithBand() {
+    int dimensions[3] = {4, 5, 6};
+    std::vector<char> band(4 * 5 * 6, 0);
+    for (int voxel = 0; voxel < (int)band.size(); ++voxel) {
+        band[voxel] = (voxel % 7) % 3 != 0;
+    }
+    
+    vtkConnectivity connectivities[3] = {SIX, EIGHTEEN, TWENTYSIX};
+    for (int c = 0; c < 3; ++c) {
+        Nodes* nodes = new Nodes();
+        nodes->SetDimensions(dimensions);
+        nodes->SetBand(band);
+        nodes->SetConnectivity(connectivities[c]);
+        nodes->Update();
+        
+        Edges* edges = new Edges();
+        edges->SetNodes(nodes);
+        edges->Update();
+        
+        // Edges to the neighbours are counted from both of their nodes
+        EdgeIndex numberOfEdges = 0;
+        for (int index = 0; index < nodes->GetSize(); ++index) {
+            numberOfEdges += 2;
+            for (NeighbourIterator it(nodes, (NodeIndex)index); !it.IsAtEnd(); it.Next()) {
+                numberOfEdges += it.GetIndex() > index ? 1 : 0;
+            }
+        }
+        assert(edges->GetSize() == numberOfEdges);
+        
+        std::vector<int> found(numberOfEdges, 0);
+        for (int index = 0; index < nodes->GetSize(); ++index) {
+            NodeIndex node = (NodeIndex)index;
+            EdgeIndex first = edges->FirstEdgeIndexForNode(node);
+            assert(edges->IndexForEdgeFromNodeToNode(NODE_SOURCE, node) == first);
+            assert(edges->IndexForEdgeFromNodeToNode(node, NODE_SINK) == first + 1);
+            assert(edges->GetEdge(first).node1() == NODE_SOURCE);
+            assert(edges->GetEdge(first).node2() == node);
+            assert(edges->GetEdge(first + 1).node2() == NODE_SINK);
+            found[first] += 1;
+            found[first + 1] += 1;
+            for (NeighbourIterator it(nodes, node); !it.IsAtEnd(); it.Next()) {
+                NodeIndex neighbour = it.GetIndex();
+                EdgeIndex edgeIndex = edges->IndexForEdgeFromNodeToNode(node, neighbour);
+                assert(edgeIndex >= 0);
+                assert(edgeIndex == edges->IndexForEdgeFromNodeToNode(neighbour, node));
+                if (neighbour < node) {
+                    continue;
+                }
+                Edge edge = edges->GetEdge(edgeIndex);
+                assert(edge.node1() == node);
+                assert(edge.node2() == neighbour);
+                found[edgeIndex] += 1;
+            }
+        }
+        for (EdgeIndex i = 0; i < numberOfEdges; ++i) {
+            assert(found[i] == 1);
+        }
+        
+        // Nodes of which the voxels are no neighbours have no edge
+        assert(edges->IndexForEdgeFromNodeToNode((NodeIndex)0, (NodeIndex)(nodes->GetSize() - 1)) == EDGE_NONE);
+        
+        delete edges;
+        delete nodes;
+    }
 }
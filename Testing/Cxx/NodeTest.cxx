@@ -8,25 +8,73 @@
 
 #include <assert.h>
 #include "Internal/Node.h"
+#include "Internal/Nodes.h"
 
 
 void testNodeConstructor();
+void testNodeAccessor();
 
 
 int main() {
     testNodeConstructor();
+    testNodeAccessor();
     return 0;
 }
 
 
+/**
+ * Tests the default values of a newly created node.
+ */
 void testNodeConstructor() {
-    Node* node = new Node();
+    int dimensions[3] = {2, 2, 2};
+    Nodes* nodes = new Nodes();
+    nodes->SetDimensions(dimensions);
+    nodes->SetConnectivity(SIX);
+    nodes->Update();
     
-    assert(node->active == false);
-    assert(node->depthInTree == -1);
-    assert(node->tree == TREE_NONE);
-    assert(node->parent == NODE_NONE);
-    assert(node->orphan == false);
+    Node node = nodes->GetNode(0);
     
-    delete node;
+    assert(node.active == false);
+    assert(node.nextActive == NODE_NONE);
+    assert(node.parentArc == ARC_NONE);
+    assert(node.firstChild == NODE_NONE);
+    assert(node.nextSibling == NODE_NONE);
+    assert(node.depthInTree == -1);
+    assert(node.timestamp == 0);
+    assert(node.tree == TREE_NONE);
+    assert(node.parent == NODE_NONE);
+    assert(node.orphan == false);
+    
+    delete nodes;
+}
+
+
+/**
+ * Tests that changes made through a Node are stored in the
+ * Nodes object and are visible through other accessors.
+ */
+void testNodeAccessor() {
+    int dimensions[3] = {2, 2, 2};
+    Nodes* nodes = new Nodes();
+    nodes->SetDimensions(dimensions);
+    nodes->SetConnectivity(SIX);
+    nodes->Update();
+    
+    Node node = nodes->GetNode(3);
+    node.tree = TREE_SINK;
+    node.parent = (NodeIndex)2;
+    node.depthInTree = 4;
+    node.active = true;
+    
+    Node sameNode = nodes->GetNode(3);
+    assert(sameNode.tree == TREE_SINK);
+    assert(sameNode.parent == (NodeIndex)2);
+    assert(sameNode.depthInTree == 4);
+    assert(sameNode.active);
+    
+    Node otherNode = nodes->GetNode(2);
+    assert(otherNode.tree == TREE_NONE);
+    assert(otherNode.parent == NODE_NONE);
+    
+    delete nodes;
 }
\ No newline at end of file
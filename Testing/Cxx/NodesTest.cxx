@@ -7,7 +7,10 @@
 //
 
 #include <assert.h>
+#include <cstddef>
+#include <vector>
 #include "Internal/Nodes.h"
+#include "Internal/NeighbourIterator.h"
 
 
 void testNodesConstructor();
@@ -21,6 +24,9 @@ void testIsValidCoordinate();
 void testIndexForCoordinate();
 void testCoordinateForIndex();
 void testIndicesForNeighbours();
+void testNeighbourIterator();
+void testFixedNeighbourIterator();
+void testBand();
 
 
 int main() {
@@ -35,6 +41,9 @@ int main() {
     testIndexForCoordinate();
     testCoordinateForIndex();
     testIndicesForNeighbours();
+    testNeighbourIterator();
+    testFixedNeighbourIterator();
+    testBand();
     return 0;
 }
 
@@ -84,7 +93,7 @@ void testNodesUpdate() {
     
     Nodes* nodes = new Nodes();
     
-    assert(nodes->GetNode(0) == NULL);
+    assert(!nodes->IsValidIndex(0));
     
     nodes->SetDimensions(dimensions);
     nodes->SetConnectivity(SIX);
@@ -92,14 +101,14 @@ void testNodesUpdate() {
 
     assert(nodes->GetSize() == 27);
     
-    Node* someNode = nodes->GetNode(0);
-    assert(someNode != NULL);
-    assert(nodes->GetNode(-1) == NULL);
-    assert(nodes->GetNode(27) == NULL);
+    assert(nodes->IsValidIndex(0));
+    assert(!nodes->IsValidIndex(-1));
+    assert(!nodes->IsValidIndex(27));
     
-    someNode->depthInTree = 1;
+    Node someNode = nodes->GetNode(0);
+    someNode.depthInTree = 1;
     
-    assert(nodes->GetNode(0)->depthInTree == 1);
+    assert(nodes->GetNode(0).depthInTree == 1);
     
     delete nodes;
 }
@@ -116,7 +125,7 @@ void testNodesReset() {
     
     assert(nodes->GetConnectivity() == UNCONNECTED);
     assert(nodes->GetDimensions() == NULL);
-    assert(nodes->GetNode(0) == NULL);
+    assert(!nodes->IsValidIndex(0));
     assert(nodes->GetSize() == 0);
     assert(nodes->IsNodeAtOffsetConnected(0, 0, 0) == false);
     
@@ -226,21 +235,30 @@ void testIsNodeAtOffsetConnected() {
 /**
  * Tests the creation of nodes for different dimensions.
  * - CreateNodesForDimensions
+ * - GetNode
  */
 void testCreateNodes() {
     int dimensions[3] = {3, 3, 2};
     
     Nodes* nodes = new Nodes();
-    std::vector<Node*>* nodesVector = nodes->CreateNodesForDimensions(dimensions);
+    nodes->CreateNodesForDimensions(dimensions);
     
-    assert(nodesVector->size() == 18);
+    assert(nodes->GetSize() == 18);
+    
+    Node node = nodes->GetNode(17);
+    assert(node.tree == TREE_NONE);
+    assert(node.parent == NODE_NONE);
+    assert(node.depthInTree == -1);
+    assert(!node.active);
+    assert(!node.orphan);
+    assert(!node.seedPoint);
     
     dimensions[0] = 5;
     dimensions[1] = 2;
     dimensions[2] = 7;
     
-    std::vector<Node*>* moreNodes = nodes->CreateNodesForDimensions(dimensions);
-    assert(moreNodes->size() == 70);
+    nodes->CreateNodesForDimensions(dimensions);
+    assert(nodes->GetSize() == 70);
     
     delete nodes;
 }
@@ -407,3 +425,165 @@ void testIndicesForNeighbours() {
     
     delete nodes;
 }
+
+
+/**
+ * Compares the neighbours visited by the iterator with
+ * all valid and connected coordinates around each node.
+ */
+void testNeighbourIterator() {
+    Nodes* nodes = new Nodes();
+    
+    int dimensions[3] = {4, 3, 1};
+    vtkConnectivity connectivities[3] = {SIX, EIGHTEEN, TWENTYSIX};
+    for (int d = 0; d < 2; ++d) {
+        nodes->SetDimensions(dimensions);
+        for (int c = 0; c < 3; ++c) {
+            nodes->SetConnectivity(connectivities[c]);
+            int numberOfNodes = dimensions[0] * dimensions[1] * dimensions[2];
+            for (int index = 0; index < numberOfNodes; ++index) {
+                int coordinate[3];
+                nodes->GetCoordinateForIndex((NodeIndex)index, coordinate);
+                NeighbourIterator it(nodes, (NodeIndex)index);
+                for (int z = -1; z < 2; ++z) {
+                    for (int y = -1; y < 2; ++y) {
+                        for (int x = -1; x < 2; ++x) {
+                            int coord[3] = {coordinate[0] + x, coordinate[1] + y, coordinate[2] + z};
+                            if (nodes->IsNodeAtOffsetConnected(x, y, z)
+                                && nodes->IsValidCoordinate(coord)) {
+                                assert(!it.IsAtEnd());
+                                assert(it.GetIndex() == nodes->GetIndexForCoordinate(coord));
+                                it.Next();
+                            }
+                        }
+                    }
+                }
+                assert(it.IsAtEnd());
+            }
+        }
+        dimensions[2] = 5;
+    }
+    
+    delete nodes;
+}
+
+
+/**
+ * Asserts that FixedNeighbourIterator visits the same
+ * neighbours as NeighbourIterator for every node.
+ */
+template <vtkConnectivity Connectivity>
+void compareNeighbourIterators(Nodes* nodes) {
+    nodes->SetConnectivity(Connectivity);
+    for (int index = 0; index < 4 * 5 * 6; ++index) {
+        NeighbourIterator it(nodes, (NodeIndex)index);
+        FixedNeighbourIterator<Connectivity> fixedIt(nodes, (NodeIndex)index);
+        for (; !it.IsAtEnd(); it.Next(), fixedIt.Next()) {
+            assert(!fixedIt.IsAtEnd());
+            assert(it.GetIndex() == fixedIt.GetIndex());
+        }
+        assert(fixedIt.IsAtEnd());
+    }
+}
+
+void testFixedNeighbourIterator() {
+    Nodes* nodes = new Nodes();
+    
+    int dimensions[3] = {4, 5, 6};
+    nodes->SetDimensions(dimensions);
+    compareNeighbourIterators<SIX>(nodes);
+    compareNeighbourIterators<EIGHTEEN>(nodes);
+    compareNeighbourIterators<TWENTYSIX>(nodes);
+    
+    delete nodes;
+}
+
+
+/**
+ * Tests nodes that only cover a band of voxels.
+ * - SetBand
+ * - IndexForVoxel and VoxelForIndex
+ * - NeighbourIterator and FixedNeighbourIterator skip the voxels
+ *   outside the band
+ */
+template <vtkConnectivity Connectivity>
+void compareNeighboursInBand(Nodes* nodes, Nodes* grid, const std::vector<char>& band) {
+    nodes->SetConnectivity(Connectivity);
+    grid->SetConnectivity(Connectivity);
+    for (int index = 0; index < nodes->GetSize(); ++index) {
+        NeighbourIterator it(nodes, (NodeIndex)index);
+        FixedNeighbourIterator<Connectivity> fixedIt(nodes, (NodeIndex)index);
+        for (NeighbourIterator gridIt(grid, (NodeIndex)nodes->VoxelForIndex((NodeIndex)index)); !gridIt.IsAtEnd(); gridIt.Next()) {
+            if (!band[gridIt.GetIndex()]) {
+                continue;
+            }
+            assert(!it.IsAtEnd());
+            assert(!fixedIt.IsAtEnd());
+            assert(nodes->VoxelForIndex(it.GetIndex()) == gridIt.GetIndex());
+            assert(fixedIt.GetIndex() == it.GetIndex());
+            it.Next();
+            fixedIt.Next();
+        }
+        assert(it.IsAtEnd());
+        assert(fixedIt.IsAtEnd());
+    }
+}
+
+void testBand() {
+    int dimensions[3] = {4, 5, 6};
+    std::vector<char> band(4 * 5 * 6, 0);
+    int numberOfNodes = 0;
+    for (int voxel = 0; voxel < (int)band.size(); ++voxel) {
+        band[voxel] = (voxel % 7) % 3 != 0;
+        numberOfNodes += band[voxel];
+    }
+    
+    Nodes* nodes = new Nodes();
+    nodes->SetDimensions(dimensions);
+    assert(!nodes->HasBand());
+    nodes->SetBand(band);
+    nodes->SetConnectivity(SIX);
+    nodes->Update();
+    assert(nodes->HasBand());
+    assert(nodes->GetSize() == numberOfNodes);
+    
+    // The nodes are numbered in the order of their voxels
+    int index = 0;
+    for (int voxel = 0; voxel < (int)band.size(); ++voxel) {
+        int coordinate[3];
+        coordinate[0] = voxel % 4;
+        coordinate[1] = (voxel / 4) % 5;
+        coordinate[2] = voxel / 20;
+        if (!band[voxel]) {
+            assert(nodes->IndexForVoxel(voxel) == NODE_NONE);
+            assert(nodes->GetIndexForCoordinate(coordinate) == NODE_NONE);
+            continue;
+        }
+        assert(nodes->IndexForVoxel(voxel) == index);
+        assert(nodes->VoxelForIndex((NodeIndex)index) == voxel);
+        assert(nodes->GetIndexForCoordinate(coordinate) == index);
+        int nodeCoordinate[3];
+        assert(nodes->GetCoordinateForIndex((NodeIndex)index, nodeCoordinate));
+        assert(nodeCoordinate[0] == coordinate[0]);
+        assert(nodeCoordinate[1] == coordinate[1]);
+        assert(nodeCoordinate[2] == coordinate[2]);
+        ++index;
+    }
+    int coordinate[3];
+    assert(!nodes->GetCoordinateForIndex((NodeIndex)numberOfNodes, coordinate));
+    
+    Nodes* grid = new Nodes();
+    grid->SetDimensions(dimensions);
+    compareNeighboursInBand<SIX>(nodes, grid, band);
+    compareNeighboursInBand<EIGHTEEN>(nodes, grid, band);
+    compareNeighboursInBand<TWENTYSIX>(nodes, grid, band);
+    
+    // New dimensions clear the band
+    nodes->SetDimensions(dimensions);
+    assert(!nodes->HasBand());
+    nodes->Update();
+    assert(nodes->GetSize() == 4 * 5 * 6);
+    
+    delete grid;
+    delete nodes;
+}
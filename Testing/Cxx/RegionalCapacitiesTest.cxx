@@ -0,0 +1,86 @@
+//
+//  RegionalCapacitiesTest.cxx
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 20/07/16.
+//
+//
+
+#include <assert.h>
+#include <stdlib.h>
+#include <vector>
+#include "Internal/RegionalCapacities.h"
+
+
+void testExtremeExponents();
+void testAgainstReference();
+void testBatchSizes();
+
+
+int main() {
+    testExtremeExponents();
+    testAgainstReference();
+    testBatchSizes();
+    return 0;
+}
+
+
+void testExtremeExponents() {
+    float exponents[5] = {0.0f, -1.0e-8f, -87.0f, -100.0f, -1.0e30f};
+    int capacities[5];
+    RegionalCapacities::Calculate(exponents, 5, capacities);
+
+    assert(capacities[0] == 256);
+    assert(capacities[1] == 256);
+    assert(capacities[2] == 1);
+    assert(capacities[3] == 1);
+    assert(capacities[4] == 1);
+}
+
+
+/**
+ * The approximation may only differ 1 from the reference and
+ * should do so rarely.
+ */
+void testAgainstReference() {
+    int count = 100000;
+    std::vector<float> exponents(count);
+    for (int i = 0; i < count; ++i) {
+        exponents[i] = -20.0f * (float)i / (float)count;
+    }
+    std::vector<int> capacities(count);
+    std::vector<int> references(count);
+    RegionalCapacities::Calculate(&exponents[0], count, &capacities[0]);
+    RegionalCapacities::CalculateReference(&exponents[0], count, &references[0]);
+
+    int numberOfDifferences = 0;
+    for (int i = 0; i < count; ++i) {
+        int difference = capacities[i] - references[i];
+        assert(difference >= -1 && difference <= 1);
+        if (difference != 0) {
+            ++numberOfDifferences;
+        }
+    }
+    assert(numberOfDifferences < count / 1000);
+}
+
+
+/**
+ * The vectorised code and the code for the remaining exponents
+ * should give exactly the same capacities.
+ */
+void testBatchSizes() {
+    int count = 37;
+    std::vector<float> exponents(count);
+    for (int i = 0; i < count; ++i) {
+        exponents[i] = -(float)(rand() % 10000) / 1000.0f;
+    }
+    std::vector<int> capacities(count);
+    RegionalCapacities::Calculate(&exponents[0], count, &capacities[0]);
+
+    for (int i = 0; i < count; ++i) {
+        int capacity = 0;
+        RegionalCapacities::Calculate(&exponents[i], 1, &capacity);
+        assert(capacity == capacities[i]);
+    }
+}
@@ -13,14 +13,20 @@
 #include "Internal/Edges.h"
 #include "Internal/Nodes.h"
 #include "Internal/Edge.h"
+#include "Internal/ActiveNodes.h"
 
 
 void testTreeConstructor();
 void testTreeProperties();
 void testAddToParent();
-void testPathToRoot(vtkTreeType);
+void testMaxFlowToRoot(vtkTreeType);
 void testPushFlow(vtkTreeType);
 void testAdopt(vtkTreeType type);
+void testChildLists();
+void testAdoptLongChain();
+void testAddChildToRoot();
+void testAdoptByDistance(int maximumDepth);
+void testAdoptByDistanceWithoutDescendants();
 
 
 /**
@@ -59,12 +65,18 @@ int main() {
     testTreeConstructor();
     testTreeProperties();
     testAddToParent();
-    testPathToRoot(TREE_SOURCE);
-    testPathToRoot(TREE_SINK);
+    testMaxFlowToRoot(TREE_SOURCE);
+    testMaxFlowToRoot(TREE_SINK);
     testPushFlow(TREE_SOURCE);
     testPushFlow(TREE_SINK);
     testAdopt(TREE_SOURCE);
     testAdopt(TREE_SINK);
+    testChildLists();
+    testAdoptLongChain();
+    testAddChildToRoot();
+    testAdoptByDistance(4);
+    testAdoptByDistance(3);
+    testAdoptByDistanceWithoutDescendants();
     return 0;
 }
 
@@ -96,57 +108,57 @@ void testAddToParent() {
     
     Edges* edges = tree->GetEdges();
     Nodes* nodes = edges->GetNodes();
-    Node* node = nodes->GetNode(0);
+    Node node = nodes->GetNode(0);
 
-    assert(node->parent == NODE_NONE);
-    assert(node->depthInTree == -1);
-    assert(node->tree == TREE_NONE);
+    assert(node.parent == NODE_NONE);
+    assert(node.depthInTree == -1);
+    assert(node.tree == TREE_NONE);
     
     tree->AddChildToParent((NodeIndex)0, NODE_SOURCE);
     
-    assert(node->parent == NODE_SOURCE);
-    assert(node->depthInTree == 1);
-    assert(node->tree == TREE_SOURCE);
+    assert(node.parent == NODE_SOURCE);
+    assert(node.depthInTree == 1);
+    assert(node.tree == TREE_SOURCE);
 
     tree->AddChildToParent((NodeIndex)1, (NodeIndex)0);
     
-    Node* someChild = nodes->GetNode(1);
-    assert(someChild->parent == (NodeIndex)0);
-    assert(someChild->depthInTree == 2);
-    assert(someChild->tree == TREE_SOURCE);
+    Node someChild = nodes->GetNode(1);
+    assert(someChild.parent == (NodeIndex)0);
+    assert(someChild.depthInTree == 2);
+    assert(someChild.tree == TREE_SOURCE);
     
     NodeIndex firstIndex = (NodeIndex)31;
     NodeIndex secondIndex = (NodeIndex)30;
-    Node* firstChild = nodes->GetNode(firstIndex);
-    Node* secondChild = nodes->GetNode(secondIndex);
+    Node firstChild = nodes->GetNode(firstIndex);
+    Node secondChild = nodes->GetNode(secondIndex);
     
     tree->AddChildToParent(firstIndex, (NodeIndex)1);
     
-    assert(firstChild->parent == (NodeIndex)1);
-    assert(firstChild->depthInTree == 3);
-    assert(firstChild->tree == TREE_SOURCE);
+    assert(firstChild.parent == (NodeIndex)1);
+    assert(firstChild.depthInTree == 3);
+    assert(firstChild.tree == TREE_SOURCE);
     
     tree->AddChildToParent(secondIndex, firstIndex);
     
-    assert(secondChild->parent == firstIndex);
-    assert(secondChild->depthInTree == 4);
+    assert(secondChild.parent == firstIndex);
+    assert(secondChild.depthInTree == 4);
     
     tree->AddChildToParent(firstIndex, NODE_SOURCE);
     
-    assert(firstChild->parent == NODE_SOURCE);
-    assert(firstChild->depthInTree == 1);
-    assert(firstChild->tree == TREE_SOURCE);
+    assert(firstChild.parent == NODE_SOURCE);
+    assert(firstChild.depthInTree == 1);
+    assert(firstChild.tree == TREE_SOURCE);
     
-    // Test whether the depth has updated when the firstIndex
-    // node was added as a child of a terminal node
-    assert(secondChild->parent == firstIndex);
-    assert(secondChild->depthInTree == 2);
+    // The depth of the children of the firstIndex node is not
+    // updated eagerly, it is verified lazily during adoption
+    assert(secondChild.parent == firstIndex);
+    assert(secondChild.depthInTree == 4);
     
     clearTestData(tree);
 }
 
 
-void testPathToRoot(vtkTreeType type) {
+void testMaxFlowToRoot(vtkTreeType type) {
     Tree* tree = createTestData(type);
     
     Edges* edges = tree->GetEdges();
@@ -156,42 +168,38 @@ void testPathToRoot(vtkTreeType type) {
     NodeIndex nodeIndex1 = (NodeIndex)1;
     NodeIndex nodeIndex2 = (NodeIndex)2;
     
-    Node* node2 = nodes->GetNode(nodeIndex2);
+    Node node2 = nodes->GetNode(nodeIndex2);
     
     tree->AddChildToParent(nodeIndex0, (NodeIndex)type);
     tree->AddChildToParent(nodeIndex1, nodeIndex0);
     tree->AddChildToParent(nodeIndex2, nodeIndex1);
     
-    assert(node2->depthInTree == 3);
+    assert(node2.depthInTree == 3);
     
-    Edge* edgeRoot0 = edges->EdgeFromNodeToNode((NodeIndex)type, nodeIndex0);
-    Edge* edge01 = edges->EdgeFromNodeToNode(nodeIndex0, nodeIndex1);
-    Edge* edge12 = edges->EdgeFromNodeToNode(nodeIndex1, nodeIndex2);
+    Edge edgeRoot0 = edges->EdgeFromNodeToNode((NodeIndex)type, nodeIndex0);
+    Edge edge01 = edges->EdgeFromNodeToNode(nodeIndex0, nodeIndex1);
+    Edge edge12 = edges->EdgeFromNodeToNode(nodeIndex1, nodeIndex2);
     
-    edgeRoot0->setCapacity(5);
-    edge01->setCapacity(4);
-    edge12->setCapacity(3);
+    edgeRoot0.setCapacity(5);
+    edge01.setCapacity(4);
+    edge12.setCapacity(3);
     
-    int maxFlow = -1;
-    std::vector<EdgeIndex> path = tree->PathToRoot(nodeIndex0, &maxFlow);
-    
-    assert(path.size() == 1);
+    int maxFlow = tree->MaxFlowToRoot(nodeIndex0, 10);
     assert(maxFlow == 5);
     
-    maxFlow = -1;
-    path = tree->PathToRoot(nodeIndex1, &maxFlow);
-    
-    assert(path.size() == 2);
+    maxFlow = tree->MaxFlowToRoot(nodeIndex1, 10);
     assert(maxFlow == 4);
     
-    maxFlow = -1;
-    path = tree->PathToRoot(nodeIndex2, &maxFlow);
-    
-    assert(path.size() == 3);
+    maxFlow = tree->MaxFlowToRoot(nodeIndex2, 10);
     assert(maxFlow == 3);
+    
+    // A smaller flow limits the result
+    maxFlow = tree->MaxFlowToRoot(nodeIndex2, 2);
+    assert(maxFlow == 2);
 
-    path = tree->PathToRoot((NodeIndex)type, &maxFlow);
-    assert(path.size() == 0);
+    // The root has no path
+    maxFlow = tree->MaxFlowToRoot((NodeIndex)type, 7);
+    assert(maxFlow == 7);
     
     clearTestData(tree);
 }
@@ -210,29 +218,33 @@ void testPushFlow(vtkTreeType type) {
     tree->AddChildToParent(nodeIndex1, nodeIndex0);
     tree->AddChildToParent(nodeIndex2, nodeIndex1);
     
-    Edge* edgeRoot0 = edges->EdgeFromNodeToNode((NodeIndex)type, nodeIndex0);
-    Edge* edge01 = edges->EdgeFromNodeToNode(nodeIndex0, nodeIndex1);
-    Edge* edge12 = edges->EdgeFromNodeToNode(nodeIndex1, nodeIndex2);
+    Edge edgeRoot0 = edges->EdgeFromNodeToNode((NodeIndex)type, nodeIndex0);
+    Edge edge01 = edges->EdgeFromNodeToNode(nodeIndex0, nodeIndex1);
+    Edge edge12 = edges->EdgeFromNodeToNode(nodeIndex1, nodeIndex2);
     
-    edgeRoot0->setCapacity(5);
-    edge01->setCapacity(4);
-    edge12->setCapacity(3);
+    edgeRoot0.setCapacity(5);
+    edge01.setCapacity(4);
+    edge12.setCapacity(3);
     
-    int maxFlow = -1;
-    std::vector<EdgeIndex> path = tree->PathToRoot(nodeIndex2, &maxFlow);
+    int maxFlow = tree->MaxFlowToRoot(nodeIndex2, 10);
     
     assert(maxFlow == 3);
     
-    Node* node2 = edges->GetNodes()->GetNode(nodeIndex2);
-    assert(!node2->orphan);
+    Node node2 = edges->GetNodes()->GetNode(nodeIndex2);
+    assert(!node2.orphan);
 
     std::vector<NodeIndex>* orphans = new std::vector<NodeIndex>();
-    tree->PushFlowThroughPath(path, maxFlow, orphans);
+    tree->PushFlowToRoot(nodeIndex2, maxFlow, orphans);
     
     assert(orphans->size() == 1);
-    assert(node2->orphan);
+    assert(node2.orphan);
     
-    path = tree->PathToRoot(nodeIndex2, &maxFlow);
+    // The flow went through the edges in the direction of the tree
+    NodeIndex pushFrom = type == TREE_SOURCE ? nodeIndex0 : nodeIndex1;
+    assert(edge01.capacityFromNode(pushFrom) == 1);
+    assert(edge01.flowFromNode(pushFrom) == 3);
+    
+    maxFlow = tree->MaxFlowToRoot(nodeIndex2, maxFlow);
     
     assert(maxFlow == 0);
     
@@ -257,41 +269,274 @@ void testAdopt(vtkTreeType type) {
     tree->AddChildToParent(nodeIndex1, nodeIndex0);
     tree->AddChildToParent(nodeIndex2, nodeIndex1);
     
-    Edge* edgeRoot0 = edges->EdgeFromNodeToNode((NodeIndex)type, nodeIndex0);
-    Edge* edgeRoot1 = edges->EdgeFromNodeToNode((NodeIndex)type, nodeIndex1);
-    Edge* edge01 = edges->EdgeFromNodeToNode(nodeIndex0, nodeIndex1);
-    Edge* edge12 = edges->EdgeFromNodeToNode(nodeIndex1, nodeIndex2);
+    Edge edgeRoot0 = edges->EdgeFromNodeToNode((NodeIndex)type, nodeIndex0);
+    Edge edgeRoot1 = edges->EdgeFromNodeToNode((NodeIndex)type, nodeIndex1);
+    Edge edge01 = edges->EdgeFromNodeToNode(nodeIndex0, nodeIndex1);
+    Edge edge12 = edges->EdgeFromNodeToNode(nodeIndex1, nodeIndex2);
     
-    edgeRoot0->setCapacity(3);
-    edgeRoot1->setCapacity(1);
-    edge01->setCapacity(4);
-    edge12->setCapacity(5);
+    edgeRoot0.setCapacity(3);
+    edgeRoot1.setCapacity(1);
+    edge01.setCapacity(4);
+    edge12.setCapacity(5);
     
-    int maxFlow = -1;
-    std::vector<EdgeIndex> path = tree->PathToRoot(nodeIndex2, &maxFlow);
+    int maxFlow = tree->MaxFlowToRoot(nodeIndex2, 10);
     std::vector<NodeIndex>* orphans = new std::vector<NodeIndex>();
-    tree->PushFlowThroughPath(path, maxFlow, orphans);
+    tree->PushFlowToRoot(nodeIndex2, maxFlow, orphans);
     
     NodeIndex orphanIndex = orphans->at(0);
     assert(orphanIndex == nodeIndex0);
     
-    Node* node0 = edges->GetNodes()->GetNode(nodeIndex0);
-    Node* node1 = edges->GetNodes()->GetNode(nodeIndex1);
+    Node node0 = edges->GetNodes()->GetNode(nodeIndex0);
+    Node node1 = edges->GetNodes()->GetNode(nodeIndex1);
     
-    assert(node1->parent == nodeIndex0);
-    assert(node0->orphan);
+    assert(node1.parent == nodeIndex0);
+    assert(node0.orphan);
     
     tree->Adopt(orphanIndex);
     
-    assert(!node0->orphan);
-    assert(node0->parent == NODE_NONE);
-    assert(node1->parent != nodeIndex0);
-    assert(node1->parent == (NodeIndex)type);
-    assert(node1->depthInTree == 1);
+    assert(!node0.orphan);
+    assert(node0.parent == NODE_NONE);
+    assert(node1.parent != nodeIndex0);
+    assert(node1.parent == (NodeIndex)type);
+    assert(node1.depthInTree == 1);
 
-    edgeRoot1->addFlowFromNode(type == TREE_SOURCE ? edgeRoot1->rootNode() : edgeRoot1->nonRootNode(), 1);
-    assert(edgeRoot1->isSaturatedFromNode(type == TREE_SOURCE ? edgeRoot1->rootNode() : edgeRoot1->nonRootNode()));
+    edgeRoot1.addFlowFromNode(type == TREE_SOURCE ? edgeRoot1.rootNode() : edgeRoot1.nonRootNode(), 1);
+    assert(edgeRoot1.isSaturatedFromNode(type == TREE_SOURCE ? edgeRoot1.rootNode() : edgeRoot1.nonRootNode()));
     
     clearTestData(tree);
     delete orphans;
 }
+
+
+/**
+ * Tests that the children of a node are linked from the node
+ * and that moving a child removes it from its former parent.
+ */
+void testChildLists() {
+    Tree* tree = createTestData(TREE_SOURCE);
+    
+    Nodes* nodes = tree->GetNodes();
+    NodeIndex parentIndex = (NodeIndex)931;
+    NodeIndex otherParentIndex = (NodeIndex)902;
+    NodeIndex childIndex0 = (NodeIndex)930;
+    NodeIndex childIndex1 = (NodeIndex)901;
+    Node parent = nodes->GetNode(parentIndex);
+    Node otherParent = nodes->GetNode(otherParentIndex);
+    
+    tree->AddChildToParent(parentIndex, NODE_SOURCE);
+    tree->AddChildToParent(otherParentIndex, NODE_SOURCE);
+    tree->AddChildToParent(childIndex0, parentIndex);
+    tree->AddChildToParent(childIndex1, parentIndex);
+    
+    // Children are added to the front of the list
+    assert(parent.firstChild == childIndex1);
+    assert(nodes->GetNode(childIndex1).nextSibling == childIndex0);
+    assert(nodes->GetNode(childIndex0).nextSibling == NODE_NONE);
+    
+    tree->AddChildToParent(childIndex1, otherParentIndex);
+    assert(parent.firstChild == childIndex0);
+    assert(otherParent.firstChild == childIndex1);
+    assert(nodes->GetNode(childIndex1).nextSibling == NODE_NONE);
+    
+    clearTestData(tree);
+}
+
+
+/**
+ * Tests that a chain that is much longer than the recursion depth
+ * that could be handled on the stack is adopted in one go.
+ */
+void testAdoptLongChain() {
+    Tree* tree = createTestData(TREE_SINK);
+    
+    Edges* edges = tree->GetEdges();
+    Nodes* nodes = tree->GetNodes();
+    
+    // Snake through all the nodes, so that every node
+    // except the first is a child of the previous one
+    int size = nodes->GetSize();
+    int dimensions[3] = {30, 30, 30};
+    NodeIndex previous = NODE_SINK;
+    for (int z = 0; z < dimensions[2]; ++z) {
+        for (int y = 0; y < dimensions[1]; ++y) {
+            for (int x = 0; x < dimensions[0]; ++x) {
+                int coordinate[3] = {
+                    (y % 2 == 0) ? x : dimensions[0] - 1 - x,
+                    (z % 2 == 0) ? y : dimensions[1] - 1 - y,
+                    z
+                };
+                NodeIndex index = nodes->GetIndexForCoordinate(coordinate);
+                edges->EdgeFromNodeToNode(index, previous).setCapacity(1);
+                tree->AddChildToParent(index, previous);
+                previous = index;
+            }
+        }
+    }
+    assert(nodes->GetNode(previous).depthInTree == size);
+    
+    // Cut the chain at the root: all nodes should become free
+    NodeIndex first = nodes->GetNode(previous).parent;
+    while (first >= 0 && nodes->GetNode(first).parent >= 0) {
+        first = nodes->GetNode(first).parent;
+    }
+    std::vector<NodeIndex> orphans;
+    tree->PushFlowToRoot(first, 1, &orphans);
+    assert(orphans.size() == 1);
+    
+    tree->Adopt(first);
+    for (int i = 0; i < size; ++i) {
+        Node node = nodes->GetNode(i);
+        assert(node.tree == TREE_NONE);
+        assert(!node.orphan);
+        assert(node.parent == NODE_NONE);
+    }
+    
+    clearTestData(tree);
+}
+
+
+/**
+ * Moving a node from the sink tree to the root of the source tree
+ * should turn its children in the sink tree into orphans.
+ */
+void testAddChildToRoot() {
+    Tree* sinkTree = createTestData(TREE_SINK);
+    Tree* sourceTree = new Tree(TREE_SOURCE, sinkTree->GetEdges());
+    Nodes* nodes = sinkTree->GetNodes();
+    
+    NodeIndex parentIndex = (NodeIndex)0;
+    NodeIndex nodeIndex = (NodeIndex)1;
+    NodeIndex childIndex = (NodeIndex)2;
+    sinkTree->AddChildToParent(parentIndex, NODE_SINK);
+    sinkTree->AddChildToParent(nodeIndex, parentIndex);
+    sinkTree->AddChildToParent(childIndex, nodeIndex);
+    
+    std::vector<NodeIndex> orphans;
+    sourceTree->AddChildToRoot(nodeIndex, &orphans);
+    
+    Node node = nodes->GetNode(nodeIndex);
+    assert(node.tree == TREE_SOURCE);
+    assert(node.parent == NODE_SOURCE);
+    assert(node.depthInTree == 1);
+    assert(node.firstChild == NODE_NONE);
+    assert(nodes->GetNode(parentIndex).firstChild == NODE_NONE);
+    
+    Node child = nodes->GetNode(childIndex);
+    assert(orphans.size() == 1);
+    assert(orphans[0] == childIndex);
+    assert(child.orphan);
+    assert(child.tree == TREE_SINK);
+    assert(child.parent == NODE_NONE);
+    
+    // Within the same tree, the children stay attached
+    orphans.clear();
+    sourceTree->AddChildToParent(childIndex, nodeIndex);
+    sourceTree->AddChildToRoot(nodeIndex, &orphans);
+    assert(orphans.empty());
+    assert(nodes->GetNode(nodeIndex).firstChild == childIndex);
+    
+    delete sourceTree;
+    clearTestData(sinkTree);
+}
+
+
+/**
+ * Tests whether an orphan that can't find a parent one level up moves
+ * down the tree and takes its children along, and whether nodes that
+ * would end up deeper than the maximum depth become free.
+ */
+void testAdoptByDistance(int maximumDepth) {
+    Tree* tree = createTestData(TREE_SOURCE);
+    Edges* edges = tree->GetEdges();
+    Nodes* nodes = edges->GetNodes();
+    ActiveNodes* activeNodes = new ActiveNodes(nodes);
+    tree->SetActiveNodes(activeNodes);
+    
+    // Two branches: 0 -> 1 -> 2 along x and 30 -> 31 next to it
+    NodeIndex nodeIndex0 = (NodeIndex)0;
+    NodeIndex nodeIndex1 = (NodeIndex)1;
+    NodeIndex nodeIndex2 = (NodeIndex)2;
+    NodeIndex nodeIndex30 = (NodeIndex)30;
+    NodeIndex nodeIndex31 = (NodeIndex)31;
+    edges->EdgeFromNodeToNode(NODE_SOURCE, nodeIndex0).setCapacity(3);
+    edges->EdgeFromNodeToNode(NODE_SOURCE, nodeIndex30).setCapacity(3);
+    edges->EdgeFromNodeToNode(nodeIndex30, nodeIndex31).setCapacity(3);
+    edges->EdgeFromNodeToNode(nodeIndex31, nodeIndex1).setCapacity(3);
+    edges->EdgeFromNodeToNode(nodeIndex1, nodeIndex2).setCapacity(3);
+    tree->AddChildToParent(nodeIndex0, NODE_SOURCE);
+    tree->AddChildToParent(nodeIndex1, nodeIndex0);
+    tree->AddChildToParent(nodeIndex2, nodeIndex1);
+    tree->AddChildToParent(nodeIndex30, NODE_SOURCE);
+    tree->AddChildToParent(nodeIndex31, nodeIndex30);
+    
+    // The edge between 0 and 1 has no capacity, so 1 is an orphan
+    Node node1 = nodes->GetNode(nodeIndex1);
+    Node node2 = nodes->GetNode(nodeIndex2);
+    node1.orphan = true;
+    std::vector<NodeIndex> orphans(1, nodeIndex1);
+    tree->AdoptByDistance<SIX>(&orphans, maximumDepth);
+    
+    // 31 is the only parent left, one level deeper than 0
+    assert(node1.tree == TREE_SOURCE);
+    assert(node1.parent == nodeIndex31);
+    assert(node1.depthInTree == 3);
+    assert(!node1.orphan);
+    assert(nodes->GetNode(nodeIndex0).firstChild == NODE_NONE);
+    if (maximumDepth >= 4) {
+        assert(node2.tree == TREE_SOURCE);
+        assert(node2.parent == nodeIndex1);
+        assert(node2.depthInTree == 4);
+        assert(node1.active);
+    } else {
+        // 2 would end up too deep and 1 can grow into it again
+        assert(node2.tree == TREE_NONE);
+        assert(node2.parent == NODE_NONE);
+        assert(node1.firstChild == NODE_NONE);
+        assert(node1.active);
+    }
+    
+    delete activeNodes;
+    clearTestData(tree);
+}
+
+
+/**
+ * Tests whether an orphan whose only neighbour with residual capacity
+ * is its own child becomes free right away, instead of taking the child
+ * as parent and moving down with it until the maximum depth.
+ */
+void testAdoptByDistanceWithoutDescendants() {
+    Tree* tree = createTestData(TREE_SOURCE);
+    Edges* edges = tree->GetEdges();
+    Nodes* nodes = edges->GetNodes();
+    ActiveNodes* activeNodes = new ActiveNodes(nodes);
+    tree->SetActiveNodes(activeNodes);
+    
+    NodeIndex nodeIndex0 = (NodeIndex)0;
+    NodeIndex nodeIndex1 = (NodeIndex)1;
+    NodeIndex nodeIndex2 = (NodeIndex)2;
+    edges->EdgeFromNodeToNode(NODE_SOURCE, nodeIndex0).setCapacity(3);
+    edges->EdgeFromNodeToNode(nodeIndex1, nodeIndex2).setCapacity(3);
+    tree->AddChildToParent(nodeIndex0, NODE_SOURCE);
+    tree->AddChildToParent(nodeIndex1, nodeIndex0);
+    tree->AddChildToParent(nodeIndex2, nodeIndex1);
+    
+    Node node1 = nodes->GetNode(nodeIndex1);
+    Node node2 = nodes->GetNode(nodeIndex2);
+    node1.orphan = true;
+    std::vector<NodeIndex> orphans(1, nodeIndex1);
+    tree->AdoptByDistance<SIX>(&orphans, 10);
+    
+    assert(node1.tree == TREE_NONE);
+    assert(node1.parent == NODE_NONE);
+    assert(!node1.orphan);
+    assert(node2.tree == TREE_NONE);
+    assert(node2.parent == NODE_NONE);
+    assert(!node2.orphan);
+    // The orphan never moved down; only its child can grow into it
+    assert(!node1.active);
+    assert(node2.active);
+    
+    delete activeNodes;
+    clearTestData(tree);
+}
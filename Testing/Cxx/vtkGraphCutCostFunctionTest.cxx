@@ -0,0 +1,245 @@
+//
+//  vtkGraphCutCostFunctionTest.cxx
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 22/07/16.
+//
+//
+
+#include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "vtkGraphCut.h"
+#include "vtkGraphCutCostFunctionSimple.h"
+#include "vtkGraphCutCostFunctionImages.h"
+
+
+/**
+ * Cost function that ties every voxel to the source, so that only the
+ * background points end up in the background.
+ */
+class vtkGraphCutCostFunctionForeground : public vtkGraphCutCostFunction
+{
+public:
+	static vtkGraphCutCostFunctionForeground* New();
+
+	virtual void CalculateTerminalCapacities(vtkIdType firstIndex, int count, int* sourceCapacities, int* sinkCapacities) {
+		std::fill(sourceCapacities, sourceCapacities + count, 1000);
+		std::fill(sinkCapacities, sinkCapacities + count, 0);
+	}
+};
+
+vtkStandardNewMacro(vtkGraphCutCostFunctionForeground);
+
+
+void testBatches();
+void testCustomCostFunction();
+void testCapacityImages();
+
+
+int main() {
+	testBatches();
+	testCustomCostFunction();
+	testCapacityImages();
+	return 0;
+}
+
+
+/**
+ * Tests whether a batch of capacities is the same as the capacities
+ * that are calculated one by one.
+ */
+void testBatches() {
+	int scalarTypes[2] = {VTK_DOUBLE, VTK_UNSIGNED_CHAR};
+	for (int t = 0; t < 2; ++t) {
+		vtkImageData* input = vtkImageData::New();
+		input->SetDimensions(7, 3, 2);
+		input->AllocateScalars(scalarTypes[t], 1);
+		for (int z = 0; z < 2; z++) {
+			for (int y = 0; y < 3; y++) {
+				for (int x = 0; x < 7; x++) {
+					input->SetScalarComponentFromDouble(x, y, z, 0, rand() % 100);
+				}
+			}
+		}
+		vtkPoints* foregroundPoints = vtkPoints::New();
+		foregroundPoints->SetNumberOfPoints(1);
+		foregroundPoints->SetPoint(0, 0, 0, 0);
+		vtkPoints* backgroundPoints = vtkPoints::New();
+		backgroundPoints->SetNumberOfPoints(1);
+		backgroundPoints->SetPoint(0, 6, 2, 1);
+
+		vtkGraphCutCostFunctionSimple* costFunction = vtkGraphCutCostFunctionSimple::New();
+		costFunction->SetInput(input);
+		costFunction->SetSeedPoints(foregroundPoints, backgroundPoints);
+		costFunction->Update();
+
+		int count = 7 * 3 * 2 - 8;
+		std::vector<int> sourceCapacities(count);
+		std::vector<int> sinkCapacities(count);
+		std::vector<int> capacities(count);
+		costFunction->CalculateTerminalCapacities(0, count, &sourceCapacities[0], &sinkCapacities[0]);
+		costFunction->CalculateRegionalCapacities(0, count, 8, &capacities[0]);
+		for (int i = 0; i < count; ++i) {
+			int sourceCapacity = 0;
+			int sinkCapacity = 0;
+			int capacity = 0;
+			costFunction->CalculateTerminalCapacities(i, 1, &sourceCapacity, &sinkCapacity);
+			costFunction->CalculateRegionalCapacities(i, 1, 8, &capacity);
+			assert(sourceCapacity == sourceCapacities[i]);
+			assert(sinkCapacity == sinkCapacities[i]);
+			assert(capacity == capacities[i]);
+			assert(capacity > 0);
+		}
+
+		costFunction->Delete();
+		foregroundPoints->Delete();
+		backgroundPoints->Delete();
+		input->Delete();
+	}
+}
+
+
+/**
+ * Tests whether the graph cut uses the capacities of the cost function
+ * that is set.
+ */
+void testCustomCostFunction() {
+	int dimensions[3] = {4, 5, 6};
+	vtkImageData* input = vtkImageData::New();
+	input->SetDimensions(dimensions);
+	input->AllocateScalars(VTK_DOUBLE, 1);
+
+	vtkPoints* foregroundPoints = vtkPoints::New();
+	foregroundPoints->SetNumberOfPoints(1);
+	foregroundPoints->SetPoint(0, 0, 0, 0);
+	vtkPoints* backgroundPoints = vtkPoints::New();
+	backgroundPoints->SetNumberOfPoints(1);
+	backgroundPoints->SetPoint(0, 3, 4, 5);
+
+	vtkGraphCutCostFunction* costFunction = vtkGraphCutCostFunctionForeground::New();
+	vtkGraphCut* graphCut = vtkGraphCut::New();
+	graphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
+	graphCut->SetInput(input);
+	graphCut->SetCostFunction(costFunction);
+	graphCut->SetConnectivity(SIX);
+	graphCut->Update();
+
+	vtkImageData* output = graphCut->GetOutput();
+	for (int z = 0; z < dimensions[2]; z++) {
+		for (int y = 0; y < dimensions[1]; y++) {
+			for (int x = 0; x < dimensions[0]; x++) {
+				bool background = x == 3 && y == 4 && z == 5;
+				assert(output->GetScalarComponentAsFloat(x, y, z, 0) == (background ? -1.0 : 1.0));
+			}
+		}
+	}
+
+	graphCut->Delete();
+	costFunction->Delete();
+	foregroundPoints->Delete();
+	backgroundPoints->Delete();
+	input->Delete();
+}
+
+
+/**
+ * Tests whether the capacities are read from the capacity images. The
+ * input itself has the same intensity everywhere, so it can't be used
+ * to calculate any capacities.
+ */
+void testCapacityImages() {
+	int dimensions[3] = {4, 5, 6};
+	vtkImageData* input = vtkImageData::New();
+	input->SetDimensions(dimensions);
+	input->AllocateScalars(VTK_DOUBLE, 1);
+
+	// The left half prefers the source, the right half the sink. The
+	// costs span the whole range of the type, like those of a classifier.
+	vtkImageData* sourceImage = vtkImageData::New();
+	sourceImage->SetDimensions(dimensions);
+	sourceImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+	vtkImageData* sinkImage = vtkImageData::New();
+	sinkImage->SetDimensions(dimensions);
+	sinkImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+	// There is a strong boundary at the third column
+	vtkImageData* boundaryImage = vtkImageData::New();
+	boundaryImage->SetDimensions(dimensions);
+	boundaryImage->AllocateScalars(VTK_FLOAT, 1);
+	for (int z = 0; z < dimensions[2]; z++) {
+		for (int y = 0; y < dimensions[1]; y++) {
+			for (int x = 0; x < dimensions[0]; x++) {
+				sourceImage->SetScalarComponentFromDouble(x, y, z, 0, x < 2 ? 255 : 0);
+				sinkImage->SetScalarComponentFromDouble(x, y, z, 0, x < 2 ? 0 : 255);
+				boundaryImage->SetScalarComponentFromDouble(x, y, z, 0, x == 2 ? 1.0 : 0.0);
+			}
+		}
+	}
+
+	vtkPoints* foregroundPoints = vtkPoints::New();
+	foregroundPoints->SetNumberOfPoints(1);
+	foregroundPoints->SetPoint(0, 0, 2, 3);
+	vtkPoints* backgroundPoints = vtkPoints::New();
+	backgroundPoints->SetNumberOfPoints(1);
+	backgroundPoints->SetPoint(0, 3, 2, 3);
+
+	vtkGraphCut* graphCut = vtkGraphCut::New();
+	graphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
+	graphCut->SetInput(input);
+	graphCut->SetSourceCapacityImage(sourceImage);
+	graphCut->SetSinkCapacityImage(sinkImage);
+	graphCut->SetBoundaryImage(boundaryImage);
+	graphCut->SetConnectivity(SIX);
+	assert(graphCut->GetSourceCapacityImage() == sourceImage);
+	assert(graphCut->GetSinkCapacityImage() == sinkImage);
+	assert(graphCut->GetBoundaryImage() == boundaryImage);
+	graphCut->Update();
+
+	vtkImageData* output = graphCut->GetOutput();
+	for (int z = 0; z < dimensions[2]; z++) {
+		for (int y = 0; y < dimensions[1]; y++) {
+			for (int x = 0; x < dimensions[0]; x++) {
+				assert(output->GetScalarComponentAsFloat(x, y, z, 0) == (x < 2 ? 1.0 : -1.0));
+			}
+		}
+	}
+
+	graphCut->Reset();
+	assert(graphCut->GetSourceCapacityImage() == NULL);
+	assert(graphCut->GetSinkCapacityImage() == NULL);
+	assert(graphCut->GetBoundaryImage() == NULL);
+
+	// The largest cost of any integer type gives the same capacity as
+	// the strongest edge between voxels, without overflowing
+	vtkImageData* intImage = vtkImageData::New();
+	intImage->SetDimensions(dimensions);
+	intImage->AllocateScalars(VTK_INT, 1);
+	intImage->SetScalarComponentFromDouble(0, 0, 0, 0, std::numeric_limits<int>::max());
+	intImage->SetScalarComponentFromDouble(1, 0, 0, 0, -1);
+	intImage->SetScalarComponentFromDouble(2, 0, 0, 0, 0);
+	vtkGraphCutCostFunctionImages* costFunction = vtkGraphCutCostFunctionImages::New();
+	costFunction->SetInput(input);
+	costFunction->SetSourceCapacityImage(intImage);
+	costFunction->SetSinkCapacityImage(sourceImage);
+	costFunction->Update();
+	int sourceCapacities[3];
+	int sinkCapacities[3];
+	costFunction->CalculateTerminalCapacities(0, 3, sourceCapacities, sinkCapacities);
+	assert(sourceCapacities[0] == 256);
+	assert(sourceCapacities[1] == 1);
+	assert(sourceCapacities[2] == 1);
+	assert(sinkCapacities[0] == 256);
+	assert(sinkCapacities[2] == 1);
+	costFunction->Delete();
+	intImage->Delete();
+
+	graphCut->Delete();
+	foregroundPoints->Delete();
+	backgroundPoints->Delete();
+	boundaryImage->Delete();
+	sinkImage->Delete();
+	sourceImage->Delete();
+	input->Delete();
+}
@@ -15,15 +15,37 @@
 void testGraphCutReset();
 void testBasicRunThrough();
 void testCostFunctionSimple();
+void testChangingSeedPoints();
+void testIncrementalSeedPoints();
+void testScalarTypes();
+void testModifiedInputs();
+void testOutputReuse();
+void testSolvers();
+void testParallelGrowth();
+void testMultiResolution();
+void testMultiResolutionBand();
 
 // Convenience method for creating a simple dataset.
 vtkImageData* createTestImageData(int dimensions[3]);
+// Asserts that two outputs with the given dimensions hold the same labels.
+void assertSameLabels(vtkImageData* output, vtkImageData* expectedOutput, int dimensions[3]);
+// Asserts that two outputs with the given dimensions have the same foreground.
+void assertSameForeground(vtkImageData* output, vtkImageData* expectedOutput, int dimensions[3]);
 
 
 int main(int argc, char const *argv[]) {
     testGraphCutReset();
     testBasicRunThrough();
     testCostFunctionSimple();
+    testChangingSeedPoints();
+    testIncrementalSeedPoints();
+    testScalarTypes();
+    testModifiedInputs();
+    testOutputReuse();
+    testSolvers();
+    testParallelGrowth();
+    testMultiResolution();
+    testMultiResolutionBand();
     return 0;
 }
 
@@ -43,6 +65,28 @@ vtkImageData* createTestImageData(int dimensions[3]) {
 }
 
 
+void assertSameLabels(vtkImageData* output, vtkImageData* expectedOutput, int dimensions[3]) {
+    for (int z = 0; z < dimensions[2]; z++) {
+        for (int y = 0; y < dimensions[1]; y++) {
+            for (int x = 0; x < dimensions[0]; x++) {
+                assert(output->GetScalarComponentAsFloat(x, y, z, 0) == expectedOutput->GetScalarComponentAsFloat(x, y, z, 0));
+            }
+        }
+    }
+}
+
+
+void assertSameForeground(vtkImageData* output, vtkImageData* expectedOutput, int dimensions[3]) {
+    for (int z = 0; z < dimensions[2]; z++) {
+        for (int y = 0; y < dimensions[1]; y++) {
+            for (int x = 0; x < dimensions[0]; x++) {
+                assert((output->GetScalarComponentAsFloat(x, y, z, 0) == 1.0) == (expectedOutput->GetScalarComponentAsFloat(x, y, z, 0) == 1.0));
+            }
+        }
+    }
+}
+
+
 /**
  * Tests the default state of a new vtkGraphCut object and tests whether
  * the Reset function resets all the cached data.
@@ -66,6 +110,7 @@ void testGraphCutReset() {
     assert(graphCut->GetInput() == NULL);
     assert(graphCut->GetCostFunction() == NULL);
     assert(graphCut->GetConnectivity() == UNCONNECTED);
+    assert(graphCut->GetSolver() == BOYKOV_KOLMOGOROV);
     assert(graphCut->GetOutput() == NULL);
     
     vtkPoints* foregroundPoints = vtkPoints::New();
@@ -76,6 +121,11 @@ void testGraphCutReset() {
     assert(graphCut->GetConnectivity() == UNCONNECTED);
     
     graphCut->SetConnectivity(TWENTYSIX);
+    graphCut->SetSolver(PUSH_RELABEL);
+    graphCut->SetNumberOfRegions(4);
+    graphCut->SetParallelGrowth(true);
+    graphCut->SetNumberOfLevels(3);
+    graphCut->SetBandWidth(5);
     graphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
     
     vtkGraphCutCostFunction* costFunction = vtkGraphCutCostFunctionSimple::New();
@@ -91,6 +141,11 @@ void testGraphCutReset() {
     assert(graphCut->GetInput() == imageData);
     assert(graphCut->GetCostFunction() == costFunction);
     assert(graphCut->GetConnectivity() == TWENTYSIX);
+    assert(graphCut->GetSolver() == PUSH_RELABEL);
+    assert(graphCut->GetNumberOfRegions() == 4);
+    assert(graphCut->GetParallelGrowth());
+    assert(graphCut->GetNumberOfLevels() == 3);
+    assert(graphCut->GetBandWidth() == 5);
     
     graphCut->Reset();
     
@@ -99,6 +154,11 @@ void testGraphCutReset() {
     assert(graphCut->GetInput() == NULL);
     assert(graphCut->GetCostFunction() == NULL);
     assert(graphCut->GetConnectivity() == UNCONNECTED);
+    assert(graphCut->GetSolver() == BOYKOV_KOLMOGOROV);
+    assert(graphCut->GetNumberOfRegions() == 0);
+    assert(!graphCut->GetParallelGrowth());
+    assert(graphCut->GetNumberOfLevels() == 1);
+    assert(graphCut->GetBandWidth() == 2);
     assert(graphCut->GetOutput() == NULL);
     
     graphCut->Delete();
@@ -155,7 +215,7 @@ void testCostFunctionSimple() {
     foregroundPoints->SetPoint(0, 0, 0, 0);
     vtkPoints* backgroundPoints = vtkPoints::New();
     backgroundPoints->SetNumberOfPoints(1);
-    foregroundPoints->SetPoint(0, 1, 1, 1);
+    backgroundPoints->SetPoint(0, 1, 1, 1);
 
     vtkGraphCut* graphCut = vtkGraphCut::New();
     graphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
@@ -188,7 +248,6 @@ void testCostFunctionSimple() {
 
     float outputPoint1 = output->GetScalarComponentAsFloat(0, 0, 0, 0);
     float outputPoint2 = output->GetScalarComponentAsFloat(1, 1, 1, 0);
-    // FIXME: make sure the tests work with the following asserts
     assert(outputPoint2 < outputPoint1);
     assert(outputPoint2 == -1.0);
     assert(outputPoint1 == 1.0);
@@ -201,3 +260,718 @@ void testCostFunctionSimple() {
     backgroundPoints->Delete();
     input->Delete();
 }
+
+
+/**
+ * Tests whether seed points that are added or removed after an
+ * update are respected by the next update.
+ * - AddSeedPoints
+ * - RemoveSeedPoints
+ */
+void testChangingSeedPoints() {
+    int dimensions[3] = {5, 6, 7};
+    vtkImageData* input = createTestImageData(dimensions);
+
+    vtkPoints* foregroundPoints = vtkPoints::New();
+    foregroundPoints->SetNumberOfPoints(1);
+    foregroundPoints->SetPoint(0, 0, 0, 0);
+    vtkPoints* backgroundPoints = vtkPoints::New();
+    backgroundPoints->SetNumberOfPoints(1);
+    backgroundPoints->SetPoint(0, 4, 5, 6);
+
+    vtkGraphCut* graphCut = vtkGraphCut::New();
+    graphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
+    graphCut->SetInput(input);
+    graphCut->SetConnectivity(SIX);
+
+    // Points are matched by their voxels before the first update too
+    vtkPoints* otherPoints = vtkPoints::New();
+    otherPoints->SetNumberOfPoints(1);
+    otherPoints->SetPoint(0, 2, 2, 2);
+    graphCut->AddSeedPoints(NULL, otherPoints);
+    assert(backgroundPoints->GetNumberOfPoints() == 2);
+    graphCut->RemoveSeedPoints(NULL, otherPoints);
+    assert(backgroundPoints->GetNumberOfPoints() == 1);
+    otherPoints->Delete();
+
+    graphCut->Update();
+
+    vtkPoints* addedPoints = vtkPoints::New();
+    addedPoints->SetNumberOfPoints(2);
+    addedPoints->SetPoint(0, 1, 0, 0);
+    addedPoints->SetPoint(1, 3, 3, 3);
+    graphCut->AddSeedPoints(NULL, addedPoints);
+    assert(backgroundPoints->GetNumberOfPoints() == 3);
+
+    graphCut->Update();
+
+    vtkImageData* output = graphCut->GetOutput();
+    assert(output->GetScalarComponentAsFloat(0, 0, 0, 0) == 1.0);
+    assert(output->GetScalarComponentAsFloat(1, 0, 0, 0) == -1.0);
+    assert(output->GetScalarComponentAsFloat(3, 3, 3, 0) == -1.0);
+    assert(output->GetScalarComponentAsFloat(4, 5, 6, 0) == -1.0);
+
+    graphCut->RemoveSeedPoints(NULL, addedPoints);
+    assert(backgroundPoints->GetNumberOfPoints() == 1);
+    graphCut->AddSeedPoints(addedPoints, NULL);
+    assert(foregroundPoints->GetNumberOfPoints() == 3);
+
+    graphCut->Update();
+
+    output = graphCut->GetOutput();
+    assert(output->GetScalarComponentAsFloat(0, 0, 0, 0) == 1.0);
+    assert(output->GetScalarComponentAsFloat(1, 0, 0, 0) == 1.0);
+    assert(output->GetScalarComponentAsFloat(3, 3, 3, 0) == 1.0);
+    assert(output->GetScalarComponentAsFloat(4, 5, 6, 0) == -1.0);
+
+    // Adding the seed points themselves changes nothing, adding them
+    // to the other set adds each of them once
+    graphCut->AddSeedPoints(graphCut->GetForegroundPoints(), NULL);
+    assert(foregroundPoints->GetNumberOfPoints() == 3);
+    graphCut->AddSeedPoints(backgroundPoints, foregroundPoints);
+    assert(foregroundPoints->GetNumberOfPoints() == 4);
+    assert(backgroundPoints->GetNumberOfPoints() == 5);
+
+    graphCut->Delete();
+    addedPoints->Delete();
+    foregroundPoints->Delete();
+    backgroundPoints->Delete();
+    input->Delete();
+}
+
+
+/**
+ * Tests whether updates after adding or removing seed points give the
+ * same foreground as solving from scratch. The capacities are read from
+ * images, so they don't depend on the statistics of the seed points.
+ * Only the foreground is unique: which of the other nodes end up in the
+ * sink tree instead of free depends on the order in which the trees grew.
+ * One voxel ends up in both sets of seed points, where the background
+ * point counts, and is then removed from the foreground points.
+ */
+void testIncrementalSeedPoints() {
+    int dimensions[3] = {12, 10, 8};
+    vtkConnectivity connectivities[3] = {SIX, EIGHTEEN, TWENTYSIX};
+    vtkImageData* input = createTestImageData(dimensions);
+    vtkImageData* images[3];
+    for (int t = 0; t < 3; ++t) {
+        images[t] = vtkImageData::New();
+        images[t]->SetDimensions(dimensions);
+        images[t]->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+        for (int z = 0; z < dimensions[2]; z++) {
+            for (int y = 0; y < dimensions[1]; y++) {
+                for (int x = 0; x < dimensions[0]; x++) {
+                    images[t]->SetScalarComponentFromDouble(x, y, z, 0, rand() % 256);
+                }
+            }
+        }
+    }
+
+    // Every step adds (1) or removes (-1) a fore- (0) or background (1)
+    // point
+    const int numberOfSteps = 6;
+    int changes[numberOfSteps] = {1, 1, -1, 1, -1, -1};
+    int sets[numberOfSteps] = {0, 1, 0, 1, 0, 1};
+    double points[numberOfSteps][3] = {{6, 5, 4}, {3, 3, 3}, {6, 5, 4}, {2, 2, 2}, {2, 2, 2}, {3, 3, 3}};
+
+    for (int c = 0; c < 3; ++c) {
+        vtkPoints* seedPoints[2];
+        for (int s = 0; s < 2; ++s) {
+            seedPoints[s] = vtkPoints::New();
+        }
+        seedPoints[0]->InsertNextPoint(2, 2, 2);
+        seedPoints[0]->InsertNextPoint(9, 2, 2);
+        seedPoints[1]->InsertNextPoint(9, 7, 5);
+
+        vtkGraphCut* graphCut = vtkGraphCut::New();
+        graphCut->SetSeedPoints(seedPoints[0], seedPoints[1]);
+        graphCut->SetInput(input);
+        graphCut->SetConnectivity(connectivities[c]);
+        graphCut->SetSourceCapacityImage(images[0]);
+        graphCut->SetSinkCapacityImage(images[1]);
+        graphCut->SetBoundaryImage(images[2]);
+        graphCut->Update();
+
+        vtkPoints* changedPoints = vtkPoints::New();
+        changedPoints->SetNumberOfPoints(1);
+        for (int step = 0; step < numberOfSteps; ++step) {
+            changedPoints->SetPoint(0, points[step][0], points[step][1], points[step][2]);
+            vtkPoints* foreground = sets[step] == 0 ? changedPoints : NULL;
+            vtkPoints* background = sets[step] == 1 ? changedPoints : NULL;
+            if (changes[step] > 0) {
+                graphCut->AddSeedPoints(foreground, background);
+            } else {
+                graphCut->RemoveSeedPoints(foreground, background);
+            }
+            graphCut->Update();
+
+            // Solves the same seed points from scratch
+            vtkPoints* freshPoints[2];
+            for (int s = 0; s < 2; ++s) {
+                freshPoints[s] = vtkPoints::New();
+                for (vtkIdType i = 0; i < seedPoints[s]->GetNumberOfPoints(); ++i) {
+                    double* point = seedPoints[s]->GetPoint(i);
+                    freshPoints[s]->InsertNextPoint(point[0], point[1], point[2]);
+                }
+            }
+            vtkGraphCut* freshGraphCut = vtkGraphCut::New();
+            freshGraphCut->SetSeedPoints(freshPoints[0], freshPoints[1]);
+            freshGraphCut->SetInput(input);
+            freshGraphCut->SetConnectivity(connectivities[c]);
+            freshGraphCut->SetSourceCapacityImage(images[0]);
+            freshGraphCut->SetSinkCapacityImage(images[1]);
+            freshGraphCut->SetBoundaryImage(images[2]);
+            freshGraphCut->Update();
+
+            assertSameForeground(graphCut->GetOutput(), freshGraphCut->GetOutput(), dimensions);
+            if (step == 4) {
+                assert(graphCut->GetOutput()->GetScalarComponentAsFloat(2, 2, 2, 0) == -1.0);
+            }
+
+            freshGraphCut->Delete();
+            freshPoints[0]->Delete();
+            freshPoints[1]->Delete();
+        }
+
+        changedPoints->Delete();
+        graphCut->Delete();
+        seedPoints[0]->Delete();
+        seedPoints[1]->Delete();
+    }
+
+    for (int t = 0; t < 3; ++t) {
+        images[t]->Delete();
+    }
+    input->Delete();
+}
+
+
+/**
+ * Tests whether inputs with integer scalars and more than one
+ * component are segmented.
+ */
+void testScalarTypes() {
+    int scalarTypes[2] = {VTK_UNSIGNED_CHAR, VTK_UNSIGNED_SHORT};
+    for (int t = 0; t < 2; ++t) {
+        vtkImageData* input = vtkImageData::New();
+        input->SetDimensions(4, 5, 6);
+        input->AllocateScalars(scalarTypes[t], 2);
+        for (int z = 0; z < 6; z++) {
+            for (int y = 0; y < 5; y++) {
+                for (int x = 0; x < 4; x++) {
+                    // The left half is dark, the right half is bright
+                    double intensity = x < 2 ? 10 + rand() % 10 : 200 + rand() % 10;
+                    input->SetScalarComponentFromDouble(x, y, z, 0, intensity);
+                    input->SetScalarComponentFromDouble(x, y, z, 1, intensity);
+                }
+            }
+        }
+
+        vtkPoints* foregroundPoints = vtkPoints::New();
+        foregroundPoints->SetNumberOfPoints(1);
+        foregroundPoints->SetPoint(0, 0, 2, 3);
+        vtkPoints* backgroundPoints = vtkPoints::New();
+        backgroundPoints->SetNumberOfPoints(1);
+        backgroundPoints->SetPoint(0, 3, 2, 3);
+
+        vtkGraphCut* graphCut = vtkGraphCut::New();
+        graphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
+        graphCut->SetInput(input);
+        graphCut->SetConnectivity(SIX);
+        graphCut->Update();
+
+        vtkImageData* output = graphCut->GetOutput();
+        assert(output->GetScalarComponentAsFloat(0, 2, 3, 0) == 1.0);
+        assert(output->GetScalarComponentAsFloat(3, 2, 3, 0) == -1.0);
+
+        graphCut->Delete();
+        foregroundPoints->Delete();
+        backgroundPoints->Delete();
+        input->Delete();
+    }
+}
+
+
+/**
+ * Tests whether updates take changes into account that are made to
+ * the seed points and the input after they were set, once they are
+ * marked as modified. The result should be the same as that of a
+ * new graph cut.
+ */
+void testModifiedInputs() {
+    int dimensions[3] = {5, 6, 7};
+    vtkImageData* input = createTestImageData(dimensions);
+
+    vtkPoints* foregroundPoints = vtkPoints::New();
+    foregroundPoints->SetNumberOfPoints(1);
+    foregroundPoints->SetPoint(0, 0, 0, 0);
+    vtkPoints* backgroundPoints = vtkPoints::New();
+    backgroundPoints->SetNumberOfPoints(1);
+    backgroundPoints->SetPoint(0, 4, 5, 6);
+
+    vtkGraphCut* graphCut = vtkGraphCut::New();
+    graphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
+    graphCut->SetInput(input);
+    graphCut->SetConnectivity(SIX);
+    graphCut->Update();
+
+    for (int step = 0; step < 3; ++step) {
+        if (step == 0) {
+            // Move the seed points
+            foregroundPoints->SetPoint(0, 1, 2, 3);
+            foregroundPoints->Modified();
+            backgroundPoints->SetPoint(0, 4, 0, 0);
+            backgroundPoints->Modified();
+        } else if (step == 1) {
+            // Change the intensities
+            for (int x = 0; x < dimensions[0]; x++) {
+                input->SetScalarComponentFromDouble(x, 2, 3, 0, 99);
+            }
+            input->Modified();
+        }
+        // The last step changes nothing
+        graphCut->Update();
+
+        vtkGraphCut* newGraphCut = vtkGraphCut::New();
+        newGraphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
+        newGraphCut->SetInput(input);
+        newGraphCut->SetConnectivity(SIX);
+        newGraphCut->Update();
+
+        vtkImageData* output = graphCut->GetOutput();
+        vtkImageData* expectedOutput = newGraphCut->GetOutput();
+        assertSameLabels(output, expectedOutput, dimensions);
+        newGraphCut->Delete();
+    }
+
+    graphCut->Delete();
+    foregroundPoints->Delete();
+    backgroundPoints->Delete();
+    input->Delete();
+}
+
+
+/**
+ * Tests whether the output is reused by consecutive updates and
+ * whether an output that is set beforehand is written to.
+ */
+void testOutputReuse() {
+    int dimensions[3] = {5, 6, 7};
+    vtkImageData* input = createTestImageData(dimensions);
+
+    vtkPoints* foregroundPoints = vtkPoints::New();
+    foregroundPoints->SetNumberOfPoints(1);
+    foregroundPoints->SetPoint(0, 0, 0, 0);
+    vtkPoints* backgroundPoints = vtkPoints::New();
+    backgroundPoints->SetNumberOfPoints(1);
+    backgroundPoints->SetPoint(0, 4, 5, 6);
+
+    vtkGraphCut* graphCut = vtkGraphCut::New();
+    graphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
+    graphCut->SetInput(input);
+    graphCut->SetConnectivity(SIX);
+    graphCut->Update();
+
+    vtkImageData* output = graphCut->GetOutput();
+    assert(output->GetScalarType() == VTK_CHAR);
+    foregroundPoints->SetPoint(0, 1, 2, 3);
+    foregroundPoints->Modified();
+    graphCut->Update();
+    assert(graphCut->GetOutput() == output);
+    assert(output->GetScalarComponentAsFloat(1, 2, 3, 0) == 1.0);
+    assert(output->GetScalarComponentAsFloat(4, 5, 6, 0) == -1.0);
+
+    // The graph cut lets go of its own output when another one is set
+    output->Register(NULL);
+
+    // An unsigned char image holds the background label as 255
+    vtkImageData* preallocatedOutput = vtkImageData::New();
+    preallocatedOutput->SetDimensions(dimensions);
+    preallocatedOutput->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    void* scalars = preallocatedOutput->GetScalarPointer();
+    graphCut->SetOutput(preallocatedOutput);
+    graphCut->Update();
+    assert(graphCut->GetOutput() == preallocatedOutput);
+    assert(preallocatedOutput->GetScalarPointer() == scalars);
+    for (int z = 0; z < dimensions[2]; z++) {
+        for (int y = 0; y < dimensions[1]; y++) {
+            for (int x = 0; x < dimensions[0]; x++) {
+                float label = output->GetScalarComponentAsFloat(x, y, z, 0);
+                float value = preallocatedOutput->GetScalarComponentAsFloat(x, y, z, 0);
+                assert(value == (label == -1.0 ? 255.0 : label));
+            }
+        }
+    }
+
+    // An output that doesn't fit the input is allocated again
+    vtkImageData* smallOutput = vtkImageData::New();
+    smallOutput->SetDimensions(1, 1, 1);
+    smallOutput->AllocateScalars(VTK_DOUBLE, 1);
+    graphCut->SetOutput(smallOutput);
+    graphCut->Update();
+    assert(smallOutput->GetScalarType() == VTK_CHAR);
+    assert(smallOutput->GetDimensions()[0] == dimensions[0]);
+    assert(smallOutput->GetScalarComponentAsFloat(4, 5, 6, 0) == -1.0);
+
+    graphCut->Delete();
+    output->Delete();
+    smallOutput->Delete();
+    preallocatedOutput->Delete();
+    foregroundPoints->Delete();
+    backgroundPoints->Delete();
+    input->Delete();
+}
+
+
+/**
+ * Tests whether the push-relabel, the incremental breadth-first search
+ * and the parallel push-relabel solvers give the same labels as the
+ * augmenting path solver, for every connectivity. The second input
+ * has very little contrast, which gives long augmenting paths.
+ */
+void testSolvers() {
+    int dimensions[3] = {9, 8, 7};
+    vtkConnectivity connectivities[3] = {SIX, EIGHTEEN, TWENTYSIX};
+    for (int contrast = 0; contrast < 2; ++contrast) {
+        vtkImageData* input = createTestImageData(dimensions);
+        if (contrast == 1) {
+            for (int z = 0; z < dimensions[2]; z++) {
+                for (int y = 0; y < dimensions[1]; y++) {
+                    for (int x = 0; x < dimensions[0]; x++) {
+                        input->SetScalarComponentFromDouble(x, y, z, 0, 50 + rand() % 3);
+                    }
+                }
+            }
+        }
+
+        vtkPoints* foregroundPoints = vtkPoints::New();
+        foregroundPoints->SetNumberOfPoints(2);
+        foregroundPoints->SetPoint(0, 0, 0, 0);
+        foregroundPoints->SetPoint(1, 2, 3, 1);
+        vtkPoints* backgroundPoints = vtkPoints::New();
+        backgroundPoints->SetNumberOfPoints(2);
+        backgroundPoints->SetPoint(0, 8, 7, 6);
+        backgroundPoints->SetPoint(1, 6, 2, 5);
+
+        vtkSolverType solvers[3] = {PUSH_RELABEL, INCREMENTAL_BREADTH_FIRST_SEARCH, PARALLEL_PUSH_RELABEL};
+        for (int i = 0; i < 9; ++i) {
+            int c = i % 3;
+            vtkSolverType solver = solvers[i / 3];
+            vtkGraphCut* graphCut = vtkGraphCut::New();
+            graphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
+            graphCut->SetInput(input);
+            graphCut->SetConnectivity(connectivities[c]);
+            graphCut->Update();
+
+            vtkGraphCut* otherGraphCut = vtkGraphCut::New();
+            otherGraphCut->SetSeedPoints(foregroundPoints, backgroundPoints);
+            otherGraphCut->SetInput(input);
+            otherGraphCut->SetConnectivity(connectivities[c]);
+            otherGraphCut->SetSolver(solver);
+            // Three slabs of two or three slices
+            otherGraphCut->SetNumberOfRegions(3);
+            otherGraphCut->Update();
+
+            vtkImageData* output = otherGraphCut->GetOutput();
+            vtkImageData* expectedOutput = graphCut->GetOutput();
+            assertSameLabels(output, expectedOutput, dimensions);
+
+            // Switching solvers on the same graph cut gives the same labels
+            graphCut->SetSolver(solver);
+            graphCut->Update();
+            graphCut->SetSolver(BOYKOV_KOLMOGOROV);
+            graphCut->Update();
+            output = graphCut->GetOutput();
+            expectedOutput = otherGraphCut->GetOutput();
+            assertSameLabels(output, expectedOutput, dimensions);
+
+            otherGraphCut->Delete();
+            graphCut->Delete();
+        }
+
+        foregroundPoints->Delete();
+        backgroundPoints->Delete();
+        input->Delete();
+    }
+}
+
+
+/**
+ * Tests whether growing the trees in parallel gives the same labels as
+ * growing them one node at a time, also when the trees of the last
+ * update are used again after adding seed points. The volume is large
+ * enough for the batches to be split over threads.
+ */
+void testParallelGrowth() {
+    int dimensions[3] = {24, 20, 16};
+    vtkConnectivity connectivities[3] = {SIX, EIGHTEEN, TWENTYSIX};
+    vtkImageData* input = createTestImageData(dimensions);
+
+    vtkPoints* addedPoints = vtkPoints::New();
+    addedPoints->SetNumberOfPoints(2);
+    addedPoints->SetPoint(0, 23, 19, 15);
+    addedPoints->SetPoint(1, 5, 15, 3);
+
+    for (int c = 0; c < 3; ++c) {
+        // Points are added to the seed points of a graph cut, so both
+        // graph cuts get their own
+        vtkGraphCut* graphCuts[2];
+        vtkPoints* foregroundPoints[2];
+        vtkPoints* backgroundPoints[2];
+        for (int g = 0; g < 2; ++g) {
+            foregroundPoints[g] = vtkPoints::New();
+            foregroundPoints[g]->SetNumberOfPoints(1);
+            foregroundPoints[g]->SetPoint(0, 12, 10, 8);
+            backgroundPoints[g] = vtkPoints::New();
+            backgroundPoints[g]->SetNumberOfPoints(1);
+            backgroundPoints[g]->SetPoint(0, 0, 0, 0);
+            graphCuts[g] = vtkGraphCut::New();
+            graphCuts[g]->SetSeedPoints(foregroundPoints[g], backgroundPoints[g]);
+            graphCuts[g]->SetInput(input);
+            graphCuts[g]->SetConnectivity(connectivities[c]);
+        }
+        graphCuts[1]->SetParallelGrowth(true);
+
+        for (int update = 0; update < 2; ++update) {
+            for (int g = 0; g < 2; ++g) {
+                if (update == 1) {
+                    graphCuts[g]->AddSeedPoints(NULL, addedPoints);
+                }
+                graphCuts[g]->Update();
+            }
+
+            vtkImageData* output = graphCuts[1]->GetOutput();
+            vtkImageData* expectedOutput = graphCuts[0]->GetOutput();
+            assertSameLabels(output, expectedOutput, dimensions);
+        }
+
+        for (int g = 0; g < 2; ++g) {
+            graphCuts[g]->Delete();
+            foregroundPoints[g]->Delete();
+            backgroundPoints[g]->Delete();
+        }
+    }
+
+    addedPoints->Delete();
+    input->Delete();
+}
+
+
+/**
+ * Tests the multi-resolution mode against a segmentation at full
+ * resolution. On an input with a clear object a narrow band is enough
+ * to give the same labels, also after seed points are added and after
+ * going back to a single level.
+ */
+void testMultiResolution() {
+    int dimensions[3] = {24, 20, 16};
+    vtkConnectivity connectivities[3] = {SIX, EIGHTEEN, TWENTYSIX};
+    // The seed points all have different intensities, so the variances
+    // of the seed points are not zero
+    vtkImageData* input = createTestImageData(dimensions);
+    for (int z = 0; z < dimensions[2]; z++) {
+        for (int y = 0; y < dimensions[1]; y++) {
+            for (int x = 0; x < dimensions[0]; x++) {
+                int distance = (x - 12) * (x - 12) + (y - 10) * (y - 10) + (z - 8) * (z - 8);
+                input->SetScalarComponentFromDouble(x, y, z, 0, (distance < 36 ? 200 : 50) + (x + 2 * y + 3 * z) % 7);
+            }
+        }
+    }
+
+    // The foreground point is moved, since the variances of two seed
+    // points of nearly the same intensity give extreme capacities
+    vtkPoints* removedPoints = vtkPoints::New();
+    removedPoints->SetNumberOfPoints(1);
+    removedPoints->SetPoint(0, 12, 10, 8);
+    vtkPoints* addedPoints = vtkPoints::New();
+    addedPoints->SetNumberOfPoints(1);
+    addedPoints->SetPoint(0, 13, 9, 7);
+
+    for (int i = 0; i < 6; ++i) {
+        int c = i % 3;
+        vtkGraphCut* graphCuts[2];
+        vtkPoints* foregroundPoints[2];
+        vtkPoints* backgroundPoints[2];
+        for (int g = 0; g < 2; ++g) {
+            foregroundPoints[g] = vtkPoints::New();
+            foregroundPoints[g]->SetNumberOfPoints(1);
+            foregroundPoints[g]->SetPoint(0, 12, 10, 8);
+            backgroundPoints[g] = vtkPoints::New();
+            backgroundPoints[g]->SetNumberOfPoints(1);
+            backgroundPoints[g]->SetPoint(0, 0, 0, 0);
+            graphCuts[g] = vtkGraphCut::New();
+            graphCuts[g]->SetSeedPoints(foregroundPoints[g], backgroundPoints[g]);
+            graphCuts[g]->SetInput(input);
+            graphCuts[g]->SetConnectivity(connectivities[c]);
+        }
+        graphCuts[1]->SetNumberOfLevels(2 + i / 3);
+        graphCuts[1]->SetBandWidth(2);
+
+        for (int update = 0; update < 3; ++update) {
+            if (update == 1) {
+                for (int g = 0; g < 2; ++g) {
+                    graphCuts[g]->RemoveSeedPoints(removedPoints, NULL);
+                    graphCuts[g]->AddSeedPoints(addedPoints, NULL);
+                }
+                // Every update with more than one level calculates the
+                // terminal capacities with the statistics of the new
+                // seed points, which an incremental update does not
+                foregroundPoints[0]->Modified();
+            } else if (update == 2) {
+                graphCuts[1]->SetNumberOfLevels(1);
+            }
+            for (int g = 0; g < 2; ++g) {
+                graphCuts[g]->Update();
+            }
+
+            vtkImageData* output = graphCuts[1]->GetOutput();
+            vtkImageData* expectedOutput = graphCuts[0]->GetOutput();
+            int* outputDimensions = output->GetDimensions();
+            assert(outputDimensions[0] == dimensions[0]);
+            assert(outputDimensions[1] == dimensions[1]);
+            assert(outputDimensions[2] == dimensions[2]);
+            assertSameLabels(output, expectedOutput, dimensions);
+        }
+
+        for (int g = 0; g < 2; ++g) {
+            graphCuts[g]->Delete();
+            foregroundPoints[g]->Delete();
+            backgroundPoints[g]->Delete();
+        }
+    }
+
+    // Capacity images that cut the sphere in two are followed at the
+    // coarse level as well, and the cost function that the coarse level
+    // shares is pointed back at the input
+    vtkImageData* capacityImages[2];
+    for (int t = 0; t < 2; ++t) {
+        capacityImages[t] = vtkImageData::New();
+        capacityImages[t]->SetDimensions(dimensions);
+        capacityImages[t]->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+        for (int z = 0; z < dimensions[2]; z++) {
+            for (int y = 0; y < dimensions[1]; y++) {
+                for (int x = 0; x < dimensions[0]; x++) {
+                    capacityImages[t]->SetScalarComponentFromDouble(x, y, z, 0, (x < 9) == (t == 0) ? 255 : 0);
+                }
+            }
+        }
+    }
+    vtkGraphCutCostFunctionSimple* costFunction = vtkGraphCutCostFunctionSimple::New();
+    vtkPoints* foregroundPoints = vtkPoints::New();
+    foregroundPoints->SetNumberOfPoints(1);
+    foregroundPoints->SetPoint(0, 0, 0, 0);
+    vtkPoints* backgroundPoints = vtkPoints::New();
+    backgroundPoints->SetNumberOfPoints(1);
+    backgroundPoints->SetPoint(0, 23, 19, 15);
+    vtkGraphCut* graphCuts[2];
+    for (int g = 0; g < 2; ++g) {
+        graphCuts[g] = vtkGraphCut::New();
+        graphCuts[g]->SetSeedPoints(foregroundPoints, backgroundPoints);
+        graphCuts[g]->SetInput(input);
+        graphCuts[g]->SetConnectivity(SIX);
+        graphCuts[g]->SetSourceCapacityImage(capacityImages[0]);
+        graphCuts[g]->SetSinkCapacityImage(capacityImages[1]);
+    }
+    graphCuts[1]->SetCostFunction(costFunction);
+    graphCuts[1]->SetNumberOfLevels(2);
+    for (int g = 0; g < 2; ++g) {
+        graphCuts[g]->Update();
+    }
+    assert(costFunction->GetInput() == input);
+    assertSameLabels(graphCuts[1]->GetOutput(), graphCuts[0]->GetOutput(), dimensions);
+    assert(graphCuts[0]->GetOutput()->GetScalarComponentAsDouble(8, 10, 8, 0) == 1);
+    assert(graphCuts[0]->GetOutput()->GetScalarComponentAsDouble(9, 10, 8, 0) == -1);
+
+    for (int g = 0; g < 2; ++g) {
+        graphCuts[g]->Delete();
+        capacityImages[g]->Delete();
+    }
+    costFunction->Delete();
+    foregroundPoints->Delete();
+    backgroundPoints->Delete();
+    removedPoints->Delete();
+    addedPoints->Delete();
+    input->Delete();
+}
+
+
+/**
+ * Tests that the band of a finer level is solved as part of the whole
+ * input with every solver. The voxels around the boundary cost nothing
+ * for either terminal, so the band only finds its labels through the
+ * edges to the voxels outside of it, which keep their coarse labels.
+ */
+void testMultiResolutionBand() {
+    int dimensions[3] = {24, 20, 16};
+    vtkImageData* input = createTestImageData(dimensions);
+    
+    // A weak boundary at x = 12, of which the voxels lean towards the
+    // foreground, between voxels that only pay for a terminal near the
+    // sides of the volume
+    vtkImageData* images[3];
+    for (int i = 0; i < 3; ++i) {
+        images[i] = vtkImageData::New();
+        images[i]->SetDimensions(dimensions);
+        images[i]->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+        for (int z = 0; z < dimensions[2]; z++) {
+            for (int y = 0; y < dimensions[1]; y++) {
+                for (int x = 0; x < dimensions[0]; x++) {
+                    double value = 0;
+                    if (i == 0) {
+                        value = x < 2 ? 255 : (x == 12 ? 128 : 0);
+                    } else if (i == 1) {
+                        value = x >= 22 ? 255 : 0;
+                    } else {
+                        value = x == 12 ? 255 : 0;
+                    }
+                    images[i]->SetScalarComponentFromDouble(x, y, z, 0, value);
+                }
+            }
+        }
+    }
+    vtkPoints* foregroundPoints = vtkPoints::New();
+    foregroundPoints->SetNumberOfPoints(1);
+    foregroundPoints->SetPoint(0, 0, 0, 0);
+    vtkPoints* backgroundPoints = vtkPoints::New();
+    backgroundPoints->SetNumberOfPoints(1);
+    backgroundPoints->SetPoint(0, 23, 19, 15);
+    
+    vtkConnectivity connectivities[3] = {SIX, EIGHTEEN, TWENTYSIX};
+    vtkSolverType solvers[4] = {BOYKOV_KOLMOGOROV, PUSH_RELABEL, INCREMENTAL_BREADTH_FIRST_SEARCH, PARALLEL_PUSH_RELABEL};
+    for (int i = 0; i < 12; ++i) {
+        vtkGraphCut* graphCuts[2];
+        for (int g = 0; g < 2; ++g) {
+            graphCuts[g] = vtkGraphCut::New();
+            graphCuts[g]->SetSeedPoints(foregroundPoints, backgroundPoints);
+            graphCuts[g]->SetInput(input);
+            graphCuts[g]->SetConnectivity(connectivities[i % 3]);
+            graphCuts[g]->SetSourceCapacityImage(images[0]);
+            graphCuts[g]->SetSinkCapacityImage(images[1]);
+            graphCuts[g]->SetBoundaryImage(images[2]);
+        }
+        graphCuts[1]->SetSolver(solvers[i / 3]);
+        graphCuts[1]->SetNumberOfRegions(3);
+        graphCuts[1]->SetNumberOfLevels(2);
+        graphCuts[1]->SetBandWidth(2);
+        for (int g = 0; g < 2; ++g) {
+            graphCuts[g]->Update();
+        }
+        
+        vtkImageData* output = graphCuts[1]->GetOutput();
+        assertSameLabels(output, graphCuts[0]->GetOutput(), dimensions);
+        for (int x = 0; x < dimensions[0]; ++x) {
+            assert(output->GetScalarComponentAsDouble(x, 10, 8, 0) == (x <= 12 ? 1 : -1));
+        }
+        
+        for (int g = 0; g < 2; ++g) {
+            graphCuts[g]->Delete();
+        }
+    }
+    
+    for (int i = 0; i < 3; ++i) {
+        images[i]->Delete();
+    }
+    foregroundPoints->Delete();
+    backgroundPoints->Delete();
+    input->Delete();
+}
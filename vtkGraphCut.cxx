@@ -31,6 +31,10 @@ vtkImageData* vtkGraphCut::GetOutput() {
     return _graphCut->GetOutput();
 }
 
+void vtkGraphCut::SetOutput(vtkImageData* imageData) {
+    _graphCut->SetOutput(imageData);
+}
+
 void vtkGraphCut::SetInput(vtkImageData* imageData) {
     _graphCut->SetInput(imageData);
 }
@@ -43,6 +47,14 @@ void vtkGraphCut::SetSeedPoints(vtkPoints* foreground, vtkPoints* background) {
     _graphCut->SetSeedPoints(foreground, background);
 }
 
+void vtkGraphCut::AddSeedPoints(vtkPoints* foreground, vtkPoints* background) {
+    _graphCut->AddSeedPoints(foreground, background);
+}
+
+void vtkGraphCut::RemoveSeedPoints(vtkPoints* foreground, vtkPoints* background) {
+    _graphCut->RemoveSeedPoints(foreground, background);
+}
+
 vtkPoints* vtkGraphCut::GetForegroundPoints() {
     return _graphCut->GetForegroundPoints();
 }
@@ -59,6 +71,30 @@ vtkGraphCutCostFunction* vtkGraphCut::GetCostFunction() {
     return _graphCut->GetCostFunction();
 }
 
+void vtkGraphCut::SetSourceCapacityImage(vtkImageData* imageData) {
+    _graphCut->SetSourceCapacityImage(imageData);
+}
+
+vtkImageData* vtkGraphCut::GetSourceCapacityImage() {
+    return _graphCut->GetSourceCapacityImage();
+}
+
+void vtkGraphCut::SetSinkCapacityImage(vtkImageData* imageData) {
+    _graphCut->SetSinkCapacityImage(imageData);
+}
+
+vtkImageData* vtkGraphCut::GetSinkCapacityImage() {
+    return _graphCut->GetSinkCapacityImage();
+}
+
+void vtkGraphCut::SetBoundaryImage(vtkImageData* imageData) {
+    _graphCut->SetBoundaryImage(imageData);
+}
+
+vtkImageData* vtkGraphCut::GetBoundaryImage() {
+    return _graphCut->GetBoundaryImage();
+}
+
 void vtkGraphCut::SetConnectivity(vtkConnectivity connectivity) {
     _graphCut->SetConnectivity(connectivity);
 }
@@ -67,6 +103,46 @@ vtkConnectivity vtkGraphCut::GetConnectivity() {
     return _graphCut->GetConnectivity();
 }
 
+void vtkGraphCut::SetSolver(vtkSolverType solver) {
+    _graphCut->SetSolver(solver);
+}
+
+vtkSolverType vtkGraphCut::GetSolver() {
+    return _graphCut->GetSolver();
+}
+
+void vtkGraphCut::SetNumberOfRegions(int numberOfRegions) {
+    _graphCut->SetNumberOfRegions(numberOfRegions);
+}
+
+int vtkGraphCut::GetNumberOfRegions() {
+    return _graphCut->GetNumberOfRegions();
+}
+
+void vtkGraphCut::SetParallelGrowth(bool parallelGrowth) {
+    _graphCut->SetParallelGrowth(parallelGrowth);
+}
+
+bool vtkGraphCut::GetParallelGrowth() {
+    return _graphCut->GetParallelGrowth();
+}
+
+void vtkGraphCut::SetNumberOfLevels(int numberOfLevels) {
+    _graphCut->SetNumberOfLevels(numberOfLevels);
+}
+
+int vtkGraphCut::GetNumberOfLevels() {
+    return _graphCut->GetNumberOfLevels();
+}
+
+void vtkGraphCut::SetBandWidth(int bandWidth) {
+    _graphCut->SetBandWidth(bandWidth);
+}
+
+int vtkGraphCut::GetBandWidth() {
+    return _graphCut->GetBandWidth();
+}
+
 // Protected
 
 vtkGraphCut::vtkGraphCut() {
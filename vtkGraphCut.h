@@ -53,13 +53,69 @@ public:
 	void Update();
 
 	vtkImageData* GetOutput();
+	/**
+	 * Sets an image that the labels are written to, so that the same
+	 * image is reused by every update. See vtkGraphCutProtected.
+	 */
+	void SetOutput(vtkImageData*);
 	void SetInput(vtkImageData *);
 	vtkImageData* GetInput();
 	void SetSeedPoints(vtkPoints *foreground, vtkPoints *background);
+	/**
+	 * Adds or removes seed points after an update. The next update
+	 * continues from the previous result instead of starting over.
+	 */
+	void AddSeedPoints(vtkPoints *foreground, vtkPoints *background);
+	void RemoveSeedPoints(vtkPoints *foreground, vtkPoints *background);
 	void SetCostFunction(vtkGraphCutCostFunction*);
 	vtkGraphCutCostFunction* GetCostFunction();
+	/**
+	 * Optional images with precomputed terminal costs and boundary
+	 * strengths that are used instead of the cost function. See
+	 * vtkGraphCutCostFunctionImages.
+	 */
+	void SetSourceCapacityImage(vtkImageData*);
+	vtkImageData* GetSourceCapacityImage();
+	void SetSinkCapacityImage(vtkImageData*);
+	vtkImageData* GetSinkCapacityImage();
+	void SetBoundaryImage(vtkImageData*);
+	vtkImageData* GetBoundaryImage();
     void SetConnectivity(vtkConnectivity);
     vtkConnectivity GetConnectivity();
+	/**
+	 * Selects the max-flow algorithm: BOYKOV_KOLMOGOROV (default),
+	 * PUSH_RELABEL, INCREMENTAL_BREADTH_FIRST_SEARCH or
+	 * PARALLEL_PUSH_RELABEL. See vtkSolverType.
+	 */
+	void SetSolver(vtkSolverType);
+	vtkSolverType GetSolver();
+	/**
+	 * Number of slabs that PARALLEL_PUSH_RELABEL solves in parallel,
+	 * 0 (default) to pick one from the size of the volume. The number
+	 * of threads is set with vtkSMPTools::Initialize.
+	 */
+	void SetNumberOfRegions(int);
+	int GetNumberOfRegions();
+	/**
+	 * Grows the source and sink trees of BOYKOV_KOLMOGOROV at the same
+	 * time on the threads of vtkSMPTools. Gives the same segmentation.
+	 * Off by default.
+	 */
+	void SetParallelGrowth(bool);
+	bool GetParallelGrowth();
+	/**
+	 * Number of resolutions to segment at, 1 (default) for full
+	 * resolution only. Each level halves the input and only segments
+	 * the band around the boundary of the coarser level again.
+	 */
+	void SetNumberOfLevels(int);
+	int GetNumberOfLevels();
+	/**
+	 * Voxels on either side of a coarse boundary that are segmented
+	 * again at the finer level. 2 by default.
+	 */
+	void SetBandWidth(int);
+	int GetBandWidth();
 
 	vtkPoints* GetForegroundPoints();
 	vtkPoints* GetBackgroundPoints();
@@ -7,8 +7,7 @@
 //
 
 #include "vtkGraphCutCostFunction.h"
-#include "Internal/Node.h"
-#include "Internal/Edge.h"
+#include <algorithm>
 
 
 vtkStandardNewMacro(vtkGraphCutCostFunction);
@@ -18,20 +17,43 @@ void vtkGraphCutCostFunction::PrintSelf(ostream& os, vtkIndent indent) {
 	Superclass::PrintSelf(os, indent);
 }
 
-void vtkGraphCutCostFunction::Reset() { }
+void vtkGraphCutCostFunction::Reset() {
+	_input = NULL;
+	_foregroundPoints = NULL;
+	_backgroundPoints = NULL;
+}
+
 void vtkGraphCutCostFunction::Update() { }
-void vtkGraphCutCostFunction::SetNodes(std::vector<Node>* nodes) {
-	
+
+void vtkGraphCutCostFunction::SetInput(vtkImageData* imageData) {
+	_input = imageData;
 }
-void vtkGraphCutCostFunction::SetEdges(std::vector<Edge>* edges) {
-	
+
+vtkImageData* vtkGraphCutCostFunction::GetInput() {
+	return _input;
 }
-void vtkGraphCutCostFunction::SetInput(vtkImageData* imageData) {
-	
+
+void vtkGraphCutCostFunction::SetSeedPoints(vtkPoints* foreground, vtkPoints* background) {
+	_foregroundPoints = foreground;
+	_backgroundPoints = background;
+}
+
+void vtkGraphCutCostFunction::CalculateTerminalCapacities(vtkIdType firstIndex, int count, int* sourceCapacities, int* sinkCapacities) {
+	std::fill(sourceCapacities, sourceCapacities + count, 1);
+	std::fill(sinkCapacities, sinkCapacities + count, 1);
+}
+
+void vtkGraphCutCostFunction::CalculateRegionalCapacities(vtkIdType firstIndex, int count, vtkIdType offset, int* capacities) {
+	std::fill(capacities, capacities + count, 1);
 }
 
 
 #pragma mark - Protected
 
-vtkGraphCutCostFunction::vtkGraphCutCostFunction() { }
+vtkGraphCutCostFunction::vtkGraphCutCostFunction() {
+	_input = NULL;
+	_foregroundPoints = NULL;
+	_backgroundPoints = NULL;
+}
+
 vtkGraphCutCostFunction::~vtkGraphCutCostFunction() { }
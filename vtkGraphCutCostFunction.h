@@ -10,15 +10,27 @@
 #define __vtkGraphCutCostFunction_h
 
 
-class Edge;
-class Node;
-
-
 #include <vtkObjectFactory.h>
 #include <vtkImageData.h>
-#include <vector>
+#include <vtkPoints.h>
 
 
+/**
+ * vtkGraphCutCostFunction calculates the capacities of the edges of the
+ * graph that vtkGraphCut builds for its input. The capacities are asked
+ * for in batches: the terminal edges of a run of consecutive voxels, or
+ * the edges between a run of consecutive voxels and the voxels that lie
+ * a fixed offset further in the input. One call thus covers a whole row
+ * of the volume, so implementations can vectorise their calculations.
+ *
+ * The graph cut sets the input and the seed points and calls Update
+ * before it asks for any capacities. The Calculate methods are called
+ * from several threads at once, so they should not change the state of
+ * the cost function.
+ *
+ * The base class gives every edge a capacity of 1. Subclasses implement
+ * an actual cost function.
+ */
 class VTK_EXPORT vtkGraphCutCostFunction : public vtkObject
 {
 public:
@@ -26,18 +38,43 @@ public:
 	void PrintSelf(ostream& os, vtkIndent indent);
 
 	virtual void Reset();
+
+	/**
+	 * Prepares the calculation of the capacities for the current input
+	 * and seed points, for instance by gathering statistics.
+	 */
 	virtual void Update();
 
-	// TODO: design API for cost function: what should it do? Does it need
-	// the following methods at all? Or should it work in a more functional
-	// manor?
-	virtual void SetNodes(std::vector<Node>* nodes);
-	virtual void SetEdges(std::vector<Edge>* edges);
+	/**
+	 * The input and the seed points are set by the graph cut. Changes to
+	 * them are tracked by the graph cut itself, so these don't modify
+	 * the cost function.
+	 */
 	virtual void SetInput(vtkImageData*);
+	vtkImageData* GetInput();
+	virtual void SetSeedPoints(vtkPoints* foreground, vtkPoints* background);
+
+	/**
+	 * Fills @p sourceCapacities and @p sinkCapacities with the capacities
+	 * of the edges from the source to the @p count voxels that start at
+	 * @p firstIndex and of the edges from these voxels to the sink.
+	 */
+	virtual void CalculateTerminalCapacities(vtkIdType firstIndex, int count, int* sourceCapacities, int* sinkCapacities);
+
+	/**
+	 * Fills @p capacities with the capacities of the edges between the
+	 * @p count voxels that start at @p firstIndex and the voxels that lie
+	 * @p offset further in the input.
+	 */
+	virtual void CalculateRegionalCapacities(vtkIdType firstIndex, int count, vtkIdType offset, int* capacities);
 
 protected:
 	vtkGraphCutCostFunction();
 	~vtkGraphCutCostFunction();
+
+	vtkImageData* _input;
+	vtkPoints* _foregroundPoints;
+	vtkPoints* _backgroundPoints;
 };
 
 #endif // __vtkGraphCutCostFunction_h
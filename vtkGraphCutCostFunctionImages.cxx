@@ -0,0 +1,240 @@
+//
+//  vtkGraphCutCostFunctionImages.cxx
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 23/07/16.
+//
+//
+
+#include "vtkGraphCutCostFunctionImages.h"
+#include <algorithm>
+#include <limits>
+
+
+/**
+ * Turns the cost of a terminal edge into a capacity. Like boundary
+ * strengths, integer costs are scaled by the maximum of their type and
+ * all costs are clamped between 0 and 1, so the capacities are as
+ * large as those of the edges between voxels at most.
+ */
+template <class T>
+static int CapacityForCost(T cost) {
+	double maximum = std::numeric_limits<T>::is_integer ? (double)std::numeric_limits<T>::max() : 1.0;
+	double fraction = std::min(std::max((double)cost / maximum, 0.0), 1.0);
+	return (int)(255.0 * fraction) + 1;
+}
+
+
+/**
+ * Turns the strength of a boundary into the capacity of an edge.
+ */
+template <class T>
+static int CapacityForBoundaryStrength(T strength) {
+	double maximum = std::numeric_limits<T>::is_integer ? (double)std::numeric_limits<T>::max() : 1.0;
+	double fraction = std::min(std::max((double)strength / maximum, 0.0), 1.0);
+	return (int)(255.0 * (1.0 - fraction)) + 1;
+}
+
+
+#pragma mark - Public
+
+
+vtkStandardNewMacro(vtkGraphCutCostFunctionImages);
+
+void vtkGraphCutCostFunctionImages::PrintSelf(ostream& os, vtkIndent indent) {
+	Superclass::PrintSelf(os, indent);
+}
+
+void vtkGraphCutCostFunctionImages::Reset() {
+	vtkGraphCutCostFunction::Reset();
+	SetSourceCapacityImage(NULL);
+	SetSinkCapacityImage(NULL);
+	SetBoundaryImage(NULL);
+	SetFallbackCostFunction(NULL);
+	_useSourceCapacityImage = false;
+	_useSinkCapacityImage = false;
+	_useBoundaryImage = false;
+}
+
+void vtkGraphCutCostFunctionImages::Update() {
+	_useSourceCapacityImage = IsImageUsable(_sourceCapacityImage);
+	_useSinkCapacityImage = IsImageUsable(_sinkCapacityImage);
+	_useBoundaryImage = IsImageUsable(_boundaryImage);
+
+	// The fallback only has to prepare when some capacities come from it
+	bool useFallback = !_useSourceCapacityImage || !_useSinkCapacityImage || !_useBoundaryImage;
+	if (useFallback && _fallbackCostFunction) {
+		_fallbackCostFunction->Update();
+	}
+}
+
+void vtkGraphCutCostFunctionImages::SetInput(vtkImageData* imageData) {
+	vtkGraphCutCostFunction::SetInput(imageData);
+	if (_fallbackCostFunction) {
+		_fallbackCostFunction->SetInput(imageData);
+	}
+}
+
+void vtkGraphCutCostFunctionImages::SetSeedPoints(vtkPoints* foreground, vtkPoints* background) {
+	vtkGraphCutCostFunction::SetSeedPoints(foreground, background);
+	if (_fallbackCostFunction) {
+		_fallbackCostFunction->SetSeedPoints(foreground, background);
+	}
+}
+
+void vtkGraphCutCostFunctionImages::CalculateTerminalCapacities(vtkIdType firstIndex, int count, int* sourceCapacities, int* sinkCapacities) {
+	if (!_useSourceCapacityImage || !_useSinkCapacityImage) {
+		if (_fallbackCostFunction) {
+			_fallbackCostFunction->CalculateTerminalCapacities(firstIndex, count, sourceCapacities, sinkCapacities);
+		} else {
+			vtkGraphCutCostFunction::CalculateTerminalCapacities(firstIndex, count, sourceCapacities, sinkCapacities);
+		}
+	}
+	if (_useSourceCapacityImage) {
+		ReadTerminalCapacities(_sourceCapacityImage, firstIndex, count, sourceCapacities);
+	}
+	if (_useSinkCapacityImage) {
+		ReadTerminalCapacities(_sinkCapacityImage, firstIndex, count, sinkCapacities);
+	}
+}
+
+void vtkGraphCutCostFunctionImages::CalculateRegionalCapacities(vtkIdType firstIndex, int count, vtkIdType offset, int* capacities) {
+	if (!_useBoundaryImage) {
+		if (_fallbackCostFunction) {
+			_fallbackCostFunction->CalculateRegionalCapacities(firstIndex, count, offset, capacities);
+		} else {
+			vtkGraphCutCostFunction::CalculateRegionalCapacities(firstIndex, count, offset, capacities);
+		}
+		return;
+	}
+	void* scalars = _boundaryImage->GetScalarPointer();
+	switch (_boundaryImage->GetScalarType()) {
+		vtkTemplateMacro(ReadRegionalCapacities(static_cast<VTK_TT*>(scalars), firstIndex, count, offset, capacities));
+	}
+}
+
+vtkMTimeType vtkGraphCutCostFunctionImages::GetMTime() {
+	vtkMTimeType result = vtkGraphCutCostFunction::GetMTime();
+	vtkImageData* images[3] = {_sourceCapacityImage, _sinkCapacityImage, _boundaryImage};
+	for (int i = 0; i < 3; ++i) {
+		if (images[i]) {
+			result = std::max(result, images[i]->GetMTime());
+		}
+	}
+	if (_fallbackCostFunction) {
+		result = std::max(result, _fallbackCostFunction->GetMTime());
+	}
+	return result;
+}
+
+void vtkGraphCutCostFunctionImages::SetSourceCapacityImage(vtkImageData* imageData) {
+	if (imageData != _sourceCapacityImage) {
+		_sourceCapacityImage = imageData;
+		Modified();
+	}
+}
+
+vtkImageData* vtkGraphCutCostFunctionImages::GetSourceCapacityImage() {
+	return _sourceCapacityImage;
+}
+
+void vtkGraphCutCostFunctionImages::SetSinkCapacityImage(vtkImageData* imageData) {
+	if (imageData != _sinkCapacityImage) {
+		_sinkCapacityImage = imageData;
+		Modified();
+	}
+}
+
+vtkImageData* vtkGraphCutCostFunctionImages::GetSinkCapacityImage() {
+	return _sinkCapacityImage;
+}
+
+void vtkGraphCutCostFunctionImages::SetBoundaryImage(vtkImageData* imageData) {
+	if (imageData != _boundaryImage) {
+		_boundaryImage = imageData;
+		Modified();
+	}
+}
+
+vtkImageData* vtkGraphCutCostFunctionImages::GetBoundaryImage() {
+	return _boundaryImage;
+}
+
+void vtkGraphCutCostFunctionImages::SetFallbackCostFunction(vtkGraphCutCostFunction* costFunction) {
+	if (costFunction != _fallbackCostFunction) {
+		_fallbackCostFunction = costFunction;
+		if (_fallbackCostFunction) {
+			_fallbackCostFunction->SetInput(_input);
+			_fallbackCostFunction->SetSeedPoints(_foregroundPoints, _backgroundPoints);
+		}
+		Modified();
+	}
+}
+
+vtkGraphCutCostFunction* vtkGraphCutCostFunctionImages::GetFallbackCostFunction() {
+	return _fallbackCostFunction;
+}
+
+bool vtkGraphCutCostFunctionImages::HasImages() {
+	return _sourceCapacityImage || _sinkCapacityImage || _boundaryImage;
+}
+
+
+#pragma mark - Protected
+
+
+vtkGraphCutCostFunctionImages::vtkGraphCutCostFunctionImages() {
+	_sourceCapacityImage = NULL;
+	_sinkCapacityImage = NULL;
+	_boundaryImage = NULL;
+	_fallbackCostFunction = NULL;
+	_useSourceCapacityImage = false;
+	_useSinkCapacityImage = false;
+	_useBoundaryImage = false;
+}
+
+vtkGraphCutCostFunctionImages::~vtkGraphCutCostFunctionImages() { }
+
+/**
+ * Returns true when @p image is set and has the dimensions of the
+ * input and a single component.
+ */
+bool vtkGraphCutCostFunctionImages::IsImageUsable(vtkImageData* image) {
+	if (!image || !_input) {
+		return false;
+	}
+	int* dimensions = image->GetDimensions();
+	int* inputDimensions = _input->GetDimensions();
+	if (dimensions[0] != inputDimensions[0]
+		|| dimensions[1] != inputDimensions[1]
+		|| dimensions[2] != inputDimensions[2]
+		|| image->GetNumberOfScalarComponents() != 1) {
+		vtkWarningMacro(<< "Image does not match the dimensions of the input or has more than one component. Ignoring image.");
+		return false;
+	}
+	return true;
+}
+
+void vtkGraphCutCostFunctionImages::ReadTerminalCapacities(vtkImageData* image, vtkIdType firstIndex, int count, int* capacities) {
+	void* scalars = image->GetScalarPointer();
+	switch (image->GetScalarType()) {
+		vtkTemplateMacro(ReadTerminalCapacities(static_cast<VTK_TT*>(scalars), firstIndex, count, capacities));
+	}
+}
+
+template <class T>
+void vtkGraphCutCostFunctionImages::ReadTerminalCapacities(T* scalars, vtkIdType firstIndex, int count, int* capacities) {
+	const T* costs = scalars + firstIndex;
+	for (int i = 0; i < count; ++i) {
+		capacities[i] = CapacityForCost(costs[i]);
+	}
+}
+
+template <class T>
+void vtkGraphCutCostFunctionImages::ReadRegionalCapacities(T* scalars, vtkIdType firstIndex, int count, vtkIdType offset, int* capacities) {
+	const T* strengths = scalars + firstIndex;
+	const T* neighbourStrengths = strengths + offset;
+	for (int i = 0; i < count; ++i) {
+		capacities[i] = CapacityForBoundaryStrength(std::max(strengths[i], neighbourStrengths[i]));
+	}
+}
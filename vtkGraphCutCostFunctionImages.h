@@ -0,0 +1,96 @@
+//
+//  vtkGraphCutCostFunctionImages.h
+//  vtkGraphCut
+//
+//  Created by Berend Klein Haneveld on 23/07/16.
+//
+//
+
+#ifndef __vtkGraphCutCostFunctionImages_h
+#define __vtkGraphCutCostFunctionImages_h
+
+#include <vtkObjectFactory.h>
+#include "vtkGraphCutCostFunction.h"
+
+/**
+ * vtkGraphCutCostFunctionImages reads the capacities from images that
+ * were calculated beforehand, for instance by a classifier. The scalars
+ * of the images are read directly, so they are neither copied nor
+ * converted to another type first. The images should have the same
+ * dimensions as the input and a single component.
+ *
+ * - The source and sink capacity images hold the costs of the terminal
+ *   edges of each voxel, between 0 and 1 for floating point scalars
+ *   and between 0 and the maximum of the type for integer scalars.
+ *   Integer costs are divided by that maximum and costs outside of
+ *   the range are clamped. A terminal edge gets the capacity
+ *   (int)(255 * cost) + 1.
+ * - The boundary image holds the strength of a boundary at each voxel,
+ *   between 0 and 1 for floating point scalars and between 0 and the
+ *   maximum of the type for integer scalars. The strength of the edge
+ *   between two voxels is the largest of their strengths. The edge gets
+ *   the capacity (int)(255 * (1 - strength)) + 1.
+ *
+ * The capacities for which no image is set are asked from the fallback
+ * cost function. When all images are set the fallback is not used at
+ * all, so no statistics of the input are gathered.
+ */
+class VTK_EXPORT vtkGraphCutCostFunctionImages : public vtkGraphCutCostFunction
+{
+public:
+	static vtkGraphCutCostFunctionImages* New();
+	void PrintSelf(ostream& os, vtkIndent indent);
+
+	virtual void Reset();
+	virtual void Update();
+
+	virtual void SetInput(vtkImageData*);
+	virtual void SetSeedPoints(vtkPoints* foreground, vtkPoints* background);
+
+	virtual void CalculateTerminalCapacities(vtkIdType firstIndex, int count, int* sourceCapacities, int* sinkCapacities);
+	virtual void CalculateRegionalCapacities(vtkIdType firstIndex, int count, vtkIdType offset, int* capacities);
+
+	/**
+	 * Returns the latest modification time of the cost function, its
+	 * images and its fallback cost function.
+	 */
+	virtual vtkMTimeType GetMTime();
+
+	void SetSourceCapacityImage(vtkImageData*);
+	vtkImageData* GetSourceCapacityImage();
+	void SetSinkCapacityImage(vtkImageData*);
+	vtkImageData* GetSinkCapacityImage();
+	void SetBoundaryImage(vtkImageData*);
+	vtkImageData* GetBoundaryImage();
+	void SetFallbackCostFunction(vtkGraphCutCostFunction*);
+	vtkGraphCutCostFunction* GetFallbackCostFunction();
+
+	/**
+	 * Returns true when at least one of the images is set.
+	 */
+	bool HasImages();
+
+protected:
+	vtkGraphCutCostFunctionImages();
+	~vtkGraphCutCostFunctionImages();
+
+	bool IsImageUsable(vtkImageData* image);
+	void ReadTerminalCapacities(vtkImageData* image, vtkIdType firstIndex, int count, int* capacities);
+
+	template <class T>
+	void ReadTerminalCapacities(T* scalars, vtkIdType firstIndex, int count, int* capacities);
+	template <class T>
+	void ReadRegionalCapacities(T* scalars, vtkIdType firstIndex, int count, vtkIdType offset, int* capacities);
+
+	vtkImageData* _sourceCapacityImage;
+	vtkImageData* _sinkCapacityImage;
+	vtkImageData* _boundaryImage;
+	vtkGraphCutCostFunction* _fallbackCostFunction;
+
+	// Which of the images are used, as decided by Update
+	bool _useSourceCapacityImage;
+	bool _useSinkCapacityImage;
+	bool _useBoundaryImage;
+};
+
+#endif // __vtkGraphCutCostFunctionImages_h
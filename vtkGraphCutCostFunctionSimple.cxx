@@ -7,6 +7,125 @@
 //
 
 #include "vtkGraphCutCostFunctionSimple.h"
+#include <vtkSMPTools.h>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include "Internal/RegionalCapacities.h"
+#include "vtkGraphCutHelperFunctions.h"
+
+
+// Largest range of component sums for which capacity tables are used
+static const long MaximumTableSize = 1 << 20;
+
+// Number of exponents that are calculated at once without tables
+static const int ChunkSize = 256;
+
+
+/**
+ * Converts a capacity from the cost function to an integer capacity.
+ */
+static int QuantisedCapacity(double capacity) {
+	return (int)(255.0 * capacity) + 1;
+}
+
+
+/**
+ * Running statistics of intensities. Values are added with Welford's
+ * method, so a single pass is enough, and statistics of different
+ * parts of the volume can be merged.
+ */
+struct IntensityStatistics
+{
+	IntensityStatistics()
+		: count(0)
+		, mean(0.0)
+		, sumOfSquares(0.0)
+		, minimum(VTK_DOUBLE_MAX)
+		, maximum(VTK_DOUBLE_MIN)
+	{
+	}
+
+	void Add(double intensity) {
+		++count;
+		double delta = intensity - mean;
+		mean += delta / (double)count;
+		sumOfSquares += delta * (intensity - mean);
+		minimum = std::min(minimum, intensity);
+		maximum = std::max(maximum, intensity);
+	}
+
+	void Merge(const IntensityStatistics& other) {
+		if (other.count == 0) {
+			return;
+		}
+		vtkIdType total = count + other.count;
+		double delta = other.mean - mean;
+		mean += delta * (double)other.count / (double)total;
+		sumOfSquares += other.sumOfSquares + delta * delta * (double)count * (double)other.count / (double)total;
+		count = total;
+		minimum = std::min(minimum, other.minimum);
+		maximum = std::max(maximum, other.maximum);
+	}
+
+	vtkIdType count;
+	double mean;
+	// Sum of the squared differences from the mean
+	double sumOfSquares;
+	double minimum;
+	double maximum;
+};
+
+
+/**
+ * Gathers the statistics of every slice of the volume in its own
+ * IntensityStatistics, for use with vtkSMPTools.
+ */
+template <class T>
+class IntensityStatisticsFunctor
+{
+public:
+	IntensityStatisticsFunctor(const T* scalars, int numberOfComponents, vtkIdType sliceSize, IntensityStatistics* sliceStatistics)
+		: _scalars(scalars)
+		, _numberOfComponents(numberOfComponents)
+		, _sliceSize(sliceSize)
+		, _sliceStatistics(sliceStatistics)
+	{
+	}
+
+	void operator()(vtkIdType beginSlice, vtkIdType endSlice) {
+		for (vtkIdType z = beginSlice; z < endSlice; ++z) {
+			IntensityStatistics& statistics = _sliceStatistics[z];
+			vtkIdType endIndex = (z + 1) * _sliceSize;
+			for (vtkIdType index = z * _sliceSize; index < endIndex; ++index) {
+				statistics.Add(vtkGraphCutHelper::GetIntensityForVoxel(_scalars, _numberOfComponents, index));
+			}
+		}
+	}
+
+private:
+	const T* _scalars;
+	int _numberOfComponents;
+	vtkIdType _sliceSize;
+	IntensityStatistics* _sliceStatistics;
+};
+
+
+/**
+ * Returns the index of the voxel of @p point in an image with the given
+ * @p dimensions or -1 when the point lies outside of the image.
+ */
+static vtkIdType IndexForPoint(double* point, int* dimensions) {
+	int coordinate[3];
+	for (int d = 0; d < 3; ++d) {
+		coordinate[d] = (int)point[d];
+		if (coordinate[d] < 0 || coordinate[d] >= dimensions[d]) {
+			return -1;
+		}
+	}
+	return coordinate[0] + (vtkIdType)dimensions[0] * (coordinate[1] + (vtkIdType)dimensions[1] * coordinate[2]);
+}
+
 
 #pragma mark - Public
 
@@ -15,47 +134,238 @@ vtkStandardNewMacro(vtkGraphCutCostFunctionSimple);
 
 void vtkGraphCutCostFunctionSimple::PrintSelf(ostream& os, vtkIndent indent) {
 	Superclass::PrintSelf(os, indent);
-}	
+}
 
 void vtkGraphCutCostFunctionSimple::Reset() {
-	_nodes = NULL;
-	_edges = NULL;
-	_imageData = NULL;
+	vtkGraphCutCostFunction::Reset();
+	_statisticsMTime = 0;
+	_valid = false;
+	_useTables = false;
+	_sourceCapacities.clear();
+	_sinkCapacities.clear();
+	_regionalCapacities.clear();
 }
 
 void vtkGraphCutCostFunctionSimple::Update() {
-	if (!_nodes) {
-		vtkWarningMacro(<< "No nodes are set for cost function.");
+	if (!_input) {
+		vtkWarningMacro(<< "No image data is set for cost function.");
 		return;
 	}
 
-	if (!_edges) {
-		vtkWarningMacro(<< "No edges are set for cost function.");
+	if (!_foregroundPoints || !_backgroundPoints) {
+		vtkWarningMacro(<< "No seed points are set for cost function.");
 		return;
 	}
 
-	if (!_imageData) {
-		vtkWarningMacro(<< "No image data is set for cost function.");
-		return;
+	void* scalars = _input->GetScalarPointer();
+	switch (_input->GetScalarType()) {
+		vtkTemplateMacro(Update(static_cast<VTK_TT*>(scalars)));
+		default:
+			vtkErrorMacro(<< "Unsupported scalar type of the input image data.");
 	}
-
 }
 
-void vtkGraphCutCostFunctionSimple::SetNodes(std::vector<Node>* nodes) {
-	vtkGraphCutCostFunction::SetNodes(nodes);
+void vtkGraphCutCostFunctionSimple::CalculateTerminalCapacities(vtkIdType firstIndex, int count, int* sourceCapacities, int* sinkCapacities) {
+	if (!_valid) {
+		std::fill(sourceCapacities, sourceCapacities + count, 0);
+		std::fill(sinkCapacities, sinkCapacities + count, 0);
+		return;
+	}
+	void* scalars = _input->GetScalarPointer();
+	switch (_input->GetScalarType()) {
+		vtkTemplateMacro(CalculateTerminalCapacities(static_cast<VTK_TT*>(scalars), firstIndex, count, sourceCapacities, sinkCapacities));
+	}
 }
 
-void vtkGraphCutCostFunctionSimple::SetEdges(std::vector<Edge>* edges) {
-	vtkGraphCutCostFunction::SetEdges(edges);
+void vtkGraphCutCostFunctionSimple::CalculateRegionalCapacities(vtkIdType firstIndex, int count, vtkIdType offset, int* capacities) {
+	if (!_valid) {
+		std::fill(capacities, capacities + count, 0);
+		return;
+	}
+	void* scalars = _input->GetScalarPointer();
+	switch (_input->GetScalarType()) {
+		vtkTemplateMacro(CalculateRegionalCapacities(static_cast<VTK_TT*>(scalars), firstIndex, count, offset, capacities));
+	}
 }
 
-void vtkGraphCutCostFunctionSimple::SetInput(vtkImageData* imageData) {
-	vtkGraphCutCostFunction::SetInput(imageData);
+Nodestatistics vtkGraphCutCostFunctionSimple::GetStatistics() {
+	return _statistics;
 }
 
 
 #pragma mark - Protected
 
 
-vtkGraphCutCostFunctionSimple::vtkGraphCutCostFunctionSimple() { }
+vtkGraphCutCostFunctionSimple::vtkGraphCutCostFunctionSimple() {
+	_statisticsMTime = 0;
+	_valid = false;
+	_useTables = false;
+	_minimumSum = 0;
+}
+
 vtkGraphCutCostFunctionSimple::~vtkGraphCutCostFunctionSimple() { }
+
+/**
+ * The statistics of the whole input are only calculated again when the
+ * input was modified.
+ */
+template <class T>
+void vtkGraphCutCostFunctionSimple::Update(T* scalars) {
+	if (_input->GetMTime() != _statisticsMTime) {
+		UpdateStatistics(scalars);
+		_statisticsMTime = _input->GetMTime();
+	}
+	if (_valid) {
+		UpdateSeedStatistics(scalars);
+		UpdateTables(scalars);
+	}
+}
+
+/**
+ * Calculates the minimum, maximum, mean and variance of the intensities
+ * of the whole input.
+ */
+template <class T>
+void vtkGraphCutCostFunctionSimple::UpdateStatistics(T* scalars) {
+	int* dimensions = _input->GetDimensions();
+	int numberOfComponents = _input->GetNumberOfScalarComponents();
+	vtkIdType sliceSize = (vtkIdType)dimensions[0] * dimensions[1];
+
+	// Every slice gets its own statistics, which are merged in order
+	// afterwards, so the result doesn't depend on the number of threads
+	std::vector<IntensityStatistics> sliceStatistics(dimensions[2]);
+	IntensityStatisticsFunctor<T> statisticsFunctor(scalars, numberOfComponents, sliceSize, &sliceStatistics[0]);
+	vtkSMPTools::For(0, dimensions[2], statisticsFunctor);
+	IntensityStatistics statistics;
+	for (int z = 0; z < dimensions[2]; ++z) {
+		statistics.Merge(sliceStatistics[z]);
+	}
+	_statistics.minimum = statistics.minimum;
+	_statistics.maximum = statistics.maximum;
+	_statistics.mean = statistics.mean;
+	_statistics.variance = sqrt(statistics.sumOfSquares / (double)(statistics.count - 1));
+
+	_valid = _statistics.minimum != _statistics.maximum;
+	if (!_valid) {
+		vtkWarningMacro("Warning: all nodes have the same intensity.");
+	}
+}
+
+/**
+ * Calculates the mean and variance of the intensities of the fore- and
+ * background points.
+ */
+template <class T>
+void vtkGraphCutCostFunctionSimple::UpdateSeedStatistics(T* scalars) {
+	int* dimensions = _input->GetDimensions();
+	int numberOfComponents = _input->GetNumberOfScalarComponents();
+	vtkPoints* seedPoints[2] = {_foregroundPoints, _backgroundPoints};
+	double means[2] = {0.0, 0.0};
+	double variances[2] = {0.0, 0.0};
+
+	for (int s = 0; s < 2; ++s) {
+		int numberOfPoints = seedPoints[s]->GetNumberOfPoints();
+		for (int i = 0; i < numberOfPoints; ++i) {
+			vtkIdType index = IndexForPoint(seedPoints[s]->GetPoint(i), dimensions);
+			if (index < 0) {
+				continue;
+			}
+			double intensity = vtkGraphCutHelper::GetIntensityForVoxel(scalars, numberOfComponents, index);
+			means[s] += intensity / (double)numberOfPoints;
+			variances[s] += (intensity * intensity) / (double)numberOfPoints;
+		}
+		variances[s] -= (means[s] * means[s]);
+		variances[s] = sqrt(variances[s]);
+
+		if (numberOfPoints == 1) {
+			variances[s] = _statistics.variance;
+		}
+	}
+
+	_statistics.foregroundMean = means[0];
+	_statistics.foregroundVariance = variances[0];
+	_statistics.backgroundMean = means[1];
+	_statistics.backgroundVariance = variances[1];
+}
+
+/**
+ * Fills the capacity tables when the input has integer scalars with a
+ * small enough range.
+ */
+template <class T>
+void vtkGraphCutCostFunctionSimple::UpdateTables(T* scalars) {
+	int numberOfComponents = _input->GetNumberOfScalarComponents();
+	_minimumSum = (long)floor(_statistics.minimum * numberOfComponents + 0.5);
+	long maximumSum = (long)floor(_statistics.maximum * numberOfComponents + 0.5);
+	_useTables = std::numeric_limits<T>::is_integer && sizeof(T) <= sizeof(int)
+		&& maximumSum - _minimumSum < MaximumTableSize;
+	if (!_useTables) {
+		_sourceCapacities.clear();
+		_sinkCapacities.clear();
+		_regionalCapacities.clear();
+		return;
+	}
+
+	double factor = -1.0 / (2.0 * _statistics.variance * _statistics.variance);
+	int tableSize = (int)(maximumSum - _minimumSum) + 1;
+	_sourceCapacities.resize(tableSize);
+	_sinkCapacities.resize(tableSize);
+	_regionalCapacities.resize(tableSize);
+	std::vector<float> exponents(tableSize);
+	for (int i = 0; i < tableSize; ++i) {
+		double intensity = (double)(_minimumSum + i) / (double)numberOfComponents;
+		_sourceCapacities[i] = QuantisedCapacity(vtkGraphCutHelper::CalculateTerminalCapacity(intensity, _statistics.foregroundMean, _statistics.foregroundVariance));
+		_sinkCapacities[i] = QuantisedCapacity(vtkGraphCutHelper::CalculateTerminalCapacity(intensity, _statistics.backgroundMean, _statistics.backgroundVariance));
+		double difference = (double)i / (double)numberOfComponents;
+		exponents[i] = (float)(difference * difference * factor);
+	}
+	RegionalCapacities::Calculate(&exponents[0], tableSize, &_regionalCapacities[0]);
+}
+
+template <class T>
+void vtkGraphCutCostFunctionSimple::CalculateTerminalCapacities(T* scalars, vtkIdType firstIndex, int count, int* sourceCapacities, int* sinkCapacities) {
+	int numberOfComponents = _input->GetNumberOfScalarComponents();
+	for (int i = 0; i < count; ++i) {
+		vtkIdType index = firstIndex + i;
+		if (_useTables) {
+			long sum = vtkGraphCutHelper::GetComponentSumForVoxel(scalars, numberOfComponents, index);
+			sourceCapacities[i] = _sourceCapacities[sum - _minimumSum];
+			sinkCapacities[i] = _sinkCapacities[sum - _minimumSum];
+		} else {
+			double intensity = vtkGraphCutHelper::GetIntensityForVoxel(scalars, numberOfComponents, index);
+			sourceCapacities[i] = QuantisedCapacity(vtkGraphCutHelper::CalculateTerminalCapacity(intensity, _statistics.foregroundMean, _statistics.foregroundVariance));
+			sinkCapacities[i] = QuantisedCapacity(vtkGraphCutHelper::CalculateTerminalCapacity(intensity, _statistics.backgroundMean, _statistics.backgroundVariance));
+		}
+	}
+}
+
+/**
+ * The exponents are calculated in chunks first, so that they can be
+ * turned into capacities with the vectorised code of RegionalCapacities.
+ */
+template <class T>
+void vtkGraphCutCostFunctionSimple::CalculateRegionalCapacities(T* scalars, vtkIdType firstIndex, int count, vtkIdType offset, int* capacities) {
+	int numberOfComponents = _input->GetNumberOfScalarComponents();
+	if (_useTables) {
+		for (int i = 0; i < count; ++i) {
+			vtkIdType index = firstIndex + i;
+			long difference = vtkGraphCutHelper::GetComponentSumForVoxel(scalars, numberOfComponents, index)
+				- vtkGraphCutHelper::GetComponentSumForVoxel(scalars, numberOfComponents, index + offset);
+			capacities[i] = _regionalCapacities[difference < 0 ? -difference : difference];
+		}
+		return;
+	}
+
+	double factor = -1.0 / (2.0 * _statistics.variance * _statistics.variance);
+	float exponents[ChunkSize];
+	for (int start = 0; start < count; start += ChunkSize) {
+		int chunkCount = std::min(ChunkSize, count - start);
+		for (int i = 0; i < chunkCount; ++i) {
+			vtkIdType index = firstIndex + start + i;
+			double difference = vtkGraphCutHelper::GetIntensityForVoxel(scalars, numberOfComponents, index)
+				- vtkGraphCutHelper::GetIntensityForVoxel(scalars, numberOfComponents, index + offset);
+			exponents[i] = (float)(difference * difference * factor);
+		}
+		RegionalCapacities::Calculate(exponents, chunkCount, capacities + start);
+	}
+}
@@ -10,8 +10,20 @@
 #define __vtkGraphCutCostFunctionSimple_h
 
 #include <vtkObjectFactory.h>
+#include <vector>
 #include "vtkGraphCutCostFunction.h"
+#include "vtkGraphCutDataTypes.h"
 
+/**
+ * vtkGraphCutCostFunctionSimple bases the capacities on the intensities
+ * of the voxels. The capacity of a terminal edge is the distance of the
+ * intensity of the voxel to the mean intensity of the seed points of
+ * that terminal, divided by their variance. The capacity of an edge
+ * between two voxels falls off with the square of the difference of
+ * their intensities, relative to the variance of the whole input.
+ *
+ * This is the cost function that vtkGraphCut uses when none is set.
+ */
 class VTK_EXPORT vtkGraphCutCostFunctionSimple : public vtkGraphCutCostFunction
 {
 public:
@@ -19,19 +31,48 @@ public:
 	void PrintSelf(ostream& os, vtkIndent indent);
 
 	virtual void Reset();
+
+	/**
+	 * Calculates the statistics of the seed points and, when the input
+	 * was modified since the last update, of the whole input.
+	 */
 	virtual void Update();
 
-	virtual void SetNodes(std::vector<Node>* nodes);
-	virtual void SetEdges(std::vector<Edge>* edges);
-	virtual void SetInput(vtkImageData*);
+	virtual void CalculateTerminalCapacities(vtkIdType firstIndex, int count, int* sourceCapacities, int* sinkCapacities);
+	virtual void CalculateRegionalCapacities(vtkIdType firstIndex, int count, vtkIdType offset, int* capacities);
+
+	Nodestatistics GetStatistics();
 
 protected:
 	vtkGraphCutCostFunctionSimple();
 	~vtkGraphCutCostFunctionSimple();
 
-	std::vector<Node>* _nodes;
-	std::vector<Edge>* _edges;
-	vtkImageData* _imageData;
+	template <class T>
+	void Update(T* scalars);
+	template <class T>
+	void UpdateStatistics(T* scalars);
+	template <class T>
+	void UpdateSeedStatistics(T* scalars);
+	template <class T>
+	void UpdateTables(T* scalars);
+	template <class T>
+	void CalculateTerminalCapacities(T* scalars, vtkIdType firstIndex, int count, int* sourceCapacities, int* sinkCapacities);
+	template <class T>
+	void CalculateRegionalCapacities(T* scalars, vtkIdType firstIndex, int count, vtkIdType offset, int* capacities);
+
+	Nodestatistics _statistics;
+	vtkMTimeType _statisticsMTime;
+	// False when all voxels have the same intensity
+	bool _valid;
+
+	// For integer scalars the sum of the components of a voxel has a
+	// small range. The capacities then follow from tables that are
+	// indexed by that sum or by the difference of two sums.
+	bool _useTables;
+	long _minimumSum;
+	std::vector<int> _sourceCapacities;
+	std::vector<int> _sinkCapacities;
+	std::vector<int> _regionalCapacities;
 };
 
 #endif // __vtkGraphCutCostFunctionSimple_h
@@ -9,6 +9,8 @@
 #ifndef __vtkGraphCutDataTypes_h
 #define __vtkGraphCutDataTypes_h
 
+#include <vtkType.h>
+
 
 enum vtkTreeType
 {
@@ -26,10 +28,20 @@ enum NodeIndex
     NODE_NONE = -3,
 };
 
-enum EdgeIndex
-{
-    EDGE_NONE = -1,
-};
+/**
+ * Index of an edge in Edges. Large volumes have more edges than an
+ * int can count, so edge and arc indices are vtkIdTypes.
+ */
+typedef vtkIdType EdgeIndex;
+const EdgeIndex EDGE_NONE = -1;
+
+/**
+ * Index of a directed arc in the residual array of Edges:
+ * arc 2 * e goes from node1 to node2 of edge e and arc
+ * 2 * e + 1 is its reverse.
+ */
+typedef vtkIdType ArcIndex;
+const ArcIndex ARC_NONE = -1;
 
 struct Nodestatistics
 {
@@ -17,4 +17,24 @@ enum vtkConnectivity
     TWENTYSIX = 26
 };
 
+/**
+ * Algorithm that is used to find the maximum flow. BOYKOV_KOLMOGOROV
+ * grows search trees from the terminals and augments along the paths
+ * between them. PUSH_RELABEL pushes flow between neighbouring nodes
+ * and does better when augmenting paths get long, for instance on
+ * volumes with little contrast and 26-connectivity.
+ * INCREMENTAL_BREADTH_FIRST_SEARCH grows the same trees as
+ * BOYKOV_KOLMOGOROV, but layer by layer, so that it only augments
+ * along shortest paths and its running time is more predictable.
+ * PARALLEL_PUSH_RELABEL splits the volume into slabs along z and runs
+ * push-relabel on them on the threads of vtkSMPTools.
+ */
+enum vtkSolverType
+{
+    BOYKOV_KOLMOGOROV = 0,
+    PUSH_RELABEL = 1,
+    INCREMENTAL_BREADTH_FIRST_SEARCH = 2,
+    PARALLEL_PUSH_RELABEL = 3
+};
+
 #endif /* vtkGraphCutDefinitions_h */
@@ -58,16 +58,45 @@ namespace vtkGraphCutHelper
         return GetIntensityForVoxel(imageData, (int)xyz[0], (int)xyz[1], (int)xyz[2]);
     }
     
+    /**
+     * Returns the mean of the components of the voxel at @p index,
+     * read directly from the @p scalars of the image data.
+     */
+    template <class T>
+    double GetIntensityForVoxel(const T* scalars, int numberOfComponents, vtkIdType index) {
+        const T* voxel = scalars + (size_t)index * numberOfComponents;
+        double result = 0.0;
+        for (int i = 0; i < numberOfComponents; i++) {
+            result += (double)voxel[i];
+        }
+        return result / (double)numberOfComponents;
+    }
+    
+    /**
+     * Returns the sum of the components of the voxel at @p index.
+     * For integer scalars this sum is exact, so it can be used as an
+     * index in a table.
+     */
+    template <class T>
+    long GetComponentSumForVoxel(const T* scalars, int numberOfComponents, vtkIdType index) {
+        const T* voxel = scalars + (size_t)index * numberOfComponents;
+        long result = 0;
+        for (int i = 0; i < numberOfComponents; i++) {
+            result += (long)voxel[i];
+        }
+        return result;
+    }
+    
     double CalculateTerminalCapacity(double intensity, double mean, double variance) {
         // The mean and var values have already been normalized. So now the costs are
         // calculated as the absolute difference from the mean devided by the variance
         return fabs(intensity - mean) / variance;
     }
     
-    double CalculateRegionalCapacity(vtkImageData* imageData, Edge* edge, double variance) {
-        assert(!edge->isTerminal());
-        double intensity1 = GetIntensityForVoxel(imageData, edge->node1());
-        double intensity2 = GetIntensityForVoxel(imageData, edge->node2());
+    double CalculateRegionalCapacity(vtkImageData* imageData, Edge edge, double variance) {
+        assert(!edge.isTerminal());
+        double intensity1 = GetIntensityForVoxel(imageData, edge.node1());
+        double intensity2 = GetIntensityForVoxel(imageData, edge.node2());
         
         // TODO: could be expanded with distance information
         double result = exp(- pow(intensity1 - intensity2, 2) / (2 * pow(variance, 2)));
@@ -75,15 +104,15 @@ namespace vtkGraphCutHelper
         return result;
     }
     
-    double CalculateCapacity(vtkImageData* imageData, Edge* edge, Nodestatistics statistics) {
-        if (edge->isTerminal()) {
-            int nodeIndex = edge->nonRootNode();
+    double CalculateCapacity(vtkImageData* imageData, Edge edge, Nodestatistics statistics) {
+        if (edge.isTerminal()) {
+            int nodeIndex = edge.nonRootNode();
             assert(nodeIndex >= 0);
             int coordinate[3] = {0, 0, 0};
             CalculateCoordinateForIndex(nodeIndex, imageData->GetDimensions(), coordinate);
             double intensity = GetIntensityForVoxel(imageData, coordinate);
-            double mean = edge->rootNode() == NODE_SOURCE ? statistics.foregroundMean : statistics.backgroundMean;
-            double variance = edge->rootNode() == NODE_SOURCE ? statistics.foregroundVariance : statistics.backgroundVariance;
+            double mean = edge.rootNode() == NODE_SOURCE ? statistics.foregroundMean : statistics.backgroundMean;
+            double variance = edge.rootNode() == NODE_SOURCE ? statistics.foregroundVariance : statistics.backgroundVariance;
             return CalculateTerminalCapacity(intensity, mean, variance);
         } else {
             return CalculateRegionalCapacity(imageData, edge, statistics.variance);
@@ -9,20 +9,406 @@
 #include "vtkGraphCutProtected.h"
 #include <vtkImageData.h>
 #include <vtkPoints.h>
+#include <vtkSMPTools.h>
 #include "Internal/Node.h"
 #include "Internal/Nodes.h"
+#include "Internal/NeighbourIterator.h"
 #include "Internal/Edge.h"
 #include "Internal/Edges.h"
 #include "Internal/Tree.h"
-#include "Internal/TreeDepthComparator.h"
+#include "Internal/ActiveNodes.h"
+#include "Internal/PushRelabel.h"
+#include "Internal/IncrementalBreadthFirstSearch.h"
+#include "Internal/RegionPushRelabel.h"
+#include "Internal/ConnectivityTraits.h"
 #include <assert.h>
-#include "vtkGraphCutHelperFunctions.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <limits>
 #include "vtkGraphCutCostFunction.h"
+#include "vtkGraphCutCostFunctionSimple.h"
+#include "vtkGraphCutCostFunctionImages.h"
 
 
 vtkStandardNewMacro(vtkGraphCutProtected);
 
 
+// Largest number of active nodes of each tree that are scanned at once
+// during parallel growth
+static const int GrowthBatchSize = 512;
+
+// Smallest number of active nodes that vtkSMPTools hands to a thread
+static const int GrowthGrainSize = 64;
+
+
+/**
+ * Sets the capacities of the terminal edges of the nodes in a range
+ * of slices and of the edges to their neighbours with a higher index,
+ * for use with vtkSMPTools. The capacities are asked from the cost
+ * function in batches: one for the terminal edges of every row of
+ * nodes and one for every row and offset to a neighbour. The largest
+ * regional capacity of each slice is stored in maximumCapacities.
+ * Without calculateRegionalCapacities only the terminal edges are done.
+ * The graph may cover only a box of the input, which starts at the
+ * voxel graphOffset; the cost function is asked for input indices.
+ * When the nodes only cover a band, CalculateBandSlice is used.
+ */
+class EdgeCapacitiesFunctor
+{
+public:
+    void operator()(vtkIdType beginSlice, vtkIdType endSlice) {
+        if (nodes->HasBand()) {
+            for (int z = (int)beginSlice; z < (int)endSlice; ++z) {
+                CalculateBandSlice(z);
+            }
+            return;
+        }
+        std::vector<int> sourceCapacities(dimensions[0]);
+        std::vector<int> sinkCapacities(dimensions[0]);
+        std::vector<int> capacities(dimensions[0]);
+        for (int z = (int)beginSlice; z < (int)endSlice; ++z) {
+            for (int y = 0; y < dimensions[1]; ++y) {
+                int rowIndex = dimensions[0] * (y + dimensions[1] * z);
+                costFunction->CalculateTerminalCapacities(InputIndex(0, y, z), dimensions[0], &sourceCapacities[0], &sinkCapacities[0]);
+                for (int x = 0; x < dimensions[0]; ++x) {
+                    NodeIndex nodeIndex = (NodeIndex)(rowIndex + x);
+                    nodes->GetNode(nodeIndex).seedPoint = false;
+                    edges->EdgeFromNodeToNode(NODE_SOURCE, nodeIndex).setCapacity(sourceCapacities[x]);
+                    edges->EdgeFromNodeToNode(nodeIndex, NODE_SINK).setCapacity(sinkCapacities[x]);
+                }
+            }
+            
+            if (!calculateRegionalCapacities) {
+                continue;
+            }
+            
+            int maximumCapacity = 0;
+            for (int oz = 0; oz <= 1 && z + oz < dimensions[2]; ++oz) {
+                for (int oy = -1; oy <= 1; ++oy) {
+                    for (int ox = -1; ox <= 1; ++ox) {
+                        bool forward = oz > 0 || (oz == 0 && (oy > 0 || (oy == 0 && ox > 0)));
+                        if (!forward || abs(ox) + abs(oy) + abs(oz) > maximumDistance) {
+                            continue;
+                        }
+                        int xBegin = std::max(0, -ox);
+                        int xEnd = std::min(dimensions[0], dimensions[0] - ox);
+                        int count = xEnd - xBegin;
+                        if (count <= 0) {
+                            continue;
+                        }
+                        int offset = ox + dimensions[0] * (oy + dimensions[1] * oz);
+                        vtkIdType inputOffset = ox + (vtkIdType)inputDimensions[0] * (oy + (vtkIdType)inputDimensions[1] * oz);
+                        for (int y = std::max(0, -oy); y < dimensions[1] && y + oy < dimensions[1]; ++y) {
+                            int rowIndex = dimensions[0] * (y + dimensions[1] * z);
+                            costFunction->CalculateRegionalCapacities(InputIndex(xBegin, y, z), count, inputOffset, &capacities[0]);
+                            for (int x = xBegin; x < xEnd; ++x) {
+                                NodeIndex nodeIndex = (NodeIndex)(rowIndex + x);
+                                int capacity = capacities[x - xBegin];
+                                edges->EdgeFromNodeToNode(nodeIndex, (NodeIndex)(nodeIndex + offset)).setCapacity(capacity);
+                                maximumCapacity = std::max(maximumCapacity, capacity);
+                            }
+                        }
+                    }
+                }
+            }
+            maximumCapacities[z] = maximumCapacity;
+        }
+    }
+    
+    /**
+     * Sets the capacities of the nodes of the band in slice @p z and of
+     * all their edges. An edge to a voxel outside the band, which keeps
+     * its coarse label, is added to the terminal edge of that label,
+     * so that cutting it costs the same as in the graph of the whole
+     * input. The cost function is asked for a batch for every run of
+     * nodes in a row. The capacities are always calculated, as they
+     * end up in the terminal edges.
+     */
+    void CalculateBandSlice(int z) {
+        std::vector<int> sourceCapacities(dimensions[0]);
+        std::vector<int> sinkCapacities(dimensions[0]);
+        std::vector<int> capacities(dimensions[0]);
+        int maximumCapacity = 0;
+        for (int y = 0; y < dimensions[1]; ++y) {
+            int rowVoxel = dimensions[0] * (y + dimensions[1] * z);
+            int runEnd = 0;
+            while (runEnd < dimensions[0]) {
+                int runBegin = runEnd;
+                if (nodes->IndexForVoxel(rowVoxel + runBegin) == NODE_NONE) {
+                    ++runEnd;
+                    continue;
+                }
+                while (runEnd < dimensions[0] && nodes->IndexForVoxel(rowVoxel + runEnd) != NODE_NONE) {
+                    ++runEnd;
+                }
+                NodeIndex firstNode = nodes->IndexForVoxel(rowVoxel + runBegin);
+                costFunction->CalculateTerminalCapacities(InputIndex(runBegin, y, z), runEnd - runBegin, &sourceCapacities[0], &sinkCapacities[0]);
+                
+                for (int oz = -1; oz <= 1; ++oz) {
+                    for (int oy = -1; oy <= 1; ++oy) {
+                        for (int ox = -1; ox <= 1; ++ox) {
+                            int distance = abs(ox) + abs(oy) + abs(oz);
+                            if (distance == 0 || distance > maximumDistance) {
+                                continue;
+                            }
+                            // The voxels next to the run that lie in the input
+                            if (y + oy + graphOffset[1] < 0 || y + oy + graphOffset[1] >= inputDimensions[1]
+                                || z + oz + graphOffset[2] < 0 || z + oz + graphOffset[2] >= inputDimensions[2]) {
+                                continue;
+                            }
+                            int xBegin = std::max(runBegin, -ox - graphOffset[0]);
+                            int xEnd = std::min(runEnd, inputDimensions[0] - graphOffset[0] - ox);
+                            if (xEnd <= xBegin) {
+                                continue;
+                            }
+                            // An edge gets the capacity that the cost function
+                            // gives from its node with the lowest index
+                            bool forward = oz > 0 || (oz == 0 && (oy > 0 || (oy == 0 && ox > 0)));
+                            vtkIdType inputOffset = ox + (vtkIdType)inputDimensions[0] * (oy + (vtkIdType)inputDimensions[1] * oz);
+                            if (forward) {
+                                costFunction->CalculateRegionalCapacities(InputIndex(xBegin, y, z), xEnd - xBegin, inputOffset, &capacities[0]);
+                            } else {
+                                costFunction->CalculateRegionalCapacities(InputIndex(xBegin + ox, y + oy, z + oz), xEnd - xBegin, -inputOffset, &capacities[0]);
+                            }
+                            bool neighboursInBox = y + oy >= 0 && y + oy < dimensions[1] && z + oz >= 0 && z + oz < dimensions[2];
+                            for (int x = xBegin; x < xEnd; ++x) {
+                                int capacity = capacities[x - xBegin];
+                                maximumCapacity = std::max(maximumCapacity, capacity);
+                                NodeIndex neighbour = NODE_NONE;
+                                if (neighboursInBox && x + ox >= 0 && x + ox < dimensions[0]) {
+                                    neighbour = nodes->IndexForVoxel(rowVoxel + ox + dimensions[0] * (oy + dimensions[1] * oz) + x);
+                                }
+                                if (neighbour != NODE_NONE) {
+                                    if (forward) {
+                                        edges->EdgeFromNodeToNode((NodeIndex)(firstNode + x - runBegin), neighbour).setCapacity(capacity);
+                                    }
+                                    continue;
+                                }
+                                char label = coarseLabels[InputIndex(x + ox, y + oy, z + oz)];
+                                if (label > 0) {
+                                    sourceCapacities[x - runBegin] += capacity;
+                                } else if (label < 0) {
+                                    sinkCapacities[x - runBegin] += capacity;
+                                }
+                            }
+                        }
+                    }
+                }
+                
+                for (int x = runBegin; x < runEnd; ++x) {
+                    NodeIndex nodeIndex = (NodeIndex)(firstNode + x - runBegin);
+                    nodes->GetNode(nodeIndex).seedPoint = false;
+                    edges->EdgeFromNodeToNode(NODE_SOURCE, nodeIndex).setCapacity(sourceCapacities[x - runBegin]);
+                    edges->EdgeFromNodeToNode(nodeIndex, NODE_SINK).setCapacity(sinkCapacities[x - runBegin]);
+                }
+            }
+        }
+        maximumCapacities[z] = maximumCapacity;
+    }
+    
+    vtkIdType InputIndex(int x, int y, int z) {
+        return x + graphOffset[0] + (vtkIdType)inputDimensions[0]
+            * (y + graphOffset[1] + (vtkIdType)inputDimensions[1] * (z + graphOffset[2]));
+    }
+    
+    vtkGraphCutCostFunction* costFunction;
+    int* dimensions;
+    int* inputDimensions;
+    int* graphOffset;
+    const char* coarseLabels;
+    int maximumDistance;
+    Nodes* nodes;
+    Edges* edges;
+    bool calculateRegionalCapacities;
+    int* maximumCapacities;
+};
+
+
+/**
+ * Writes the labels of the nodes in a range of slices to a buffer with
+ * one byte per voxel of the input, for use with vtkSMPTools. The nodes
+ * start at the voxel graphOffset. Voxels outside of a band have no
+ * node and are skipped.
+ */
+class LabelsFunctor
+{
+public:
+    void operator()(vtkIdType beginSlice, vtkIdType endSlice) {
+        for (int z = (int)beginSlice; z < (int)endSlice; ++z) {
+            for (int y = 0; y < dimensions[1]; ++y) {
+                int rowIndex = dimensions[0] * (y + dimensions[1] * z);
+                char* row = labels + graphOffset[0] + (vtkIdType)inputDimensions[0]
+                    * (y + graphOffset[1] + (vtkIdType)inputDimensions[1] * (z + graphOffset[2]));
+                for (int x = 0; x < dimensions[0]; ++x) {
+                    NodeIndex index = nodes->IndexForVoxel(rowIndex + x);
+                    if (index == NODE_NONE) {
+                        continue;
+                    }
+                    vtkTreeType tree = nodes->TreeForIndex(index);
+                    row[x] = tree == TREE_SOURCE ? 1 : (tree == TREE_SINK ? -1 : 0);
+                }
+            }
+        }
+    }
+    
+    Nodes* nodes;
+    int* dimensions;
+    int* inputDimensions;
+    int* graphOffset;
+    char* labels;
+};
+
+
+/**
+ * Looks through the neighbours of a range of active nodes, for use with
+ * vtkSMPTools during parallel growth. Every neighbour that the tree of
+ * the active node could grow into, because it is free or in the other
+ * tree, is written to the slots of the active node in candidates. The
+ * nodes are only read, so both trees can be scanned at the same time.
+ */
+template <vtkConnectivity Connectivity>
+class GrowthScanFunctor
+{
+public:
+    void operator()(vtkIdType begin, vtkIdType end) {
+        for (vtkIdType i = begin; i < end; ++i) {
+            NodeIndex index = activeNodes[i];
+            vtkTreeType tree = nodes->TreeForIndex(index);
+            NodeIndex* slots = candidates + i * ConnectivityTraits<Connectivity>::NumberOfNeighbours;
+            int count = 0;
+            for (FixedNeighbourIterator<Connectivity> it(nodes, index); !it.IsAtEnd(); it.Next()) {
+                NodeIndex neighbour = it.GetIndex();
+                if (nodes->TreeForIndex(neighbour) == tree) {
+                    continue;
+                }
+                ArcIndex arc = tree == TREE_SOURCE
+                    ? edges->ArcFromNodeToNode(index, neighbour)
+                    : edges->ArcFromNodeToNode(neighbour, index);
+                if (edges->ResidualCapacityForArc(arc) > 0) {
+                    slots[count++] = neighbour;
+                }
+            }
+            numberOfCandidates[i] = count;
+        }
+    }
+    
+    Nodes* nodes;
+    Edges* edges;
+    const NodeIndex* activeNodes;
+    NodeIndex* candidates;
+    int* numberOfCandidates;
+};
+
+
+/**
+ * Averages every block of 2x2x2 voxels of @p scalars, component by
+ * component, into a voxel of @p coarseScalars. The blocks at the far
+ * side of an odd dimension are only one voxel thick.
+ */
+template <class T>
+static void DownsampleScalars(T* scalars, int* dimensions, int numberOfComponents, double* coarseScalars, int* coarseDimensions) {
+    for (int z = 0; z < coarseDimensions[2]; ++z) {
+        for (int y = 0; y < coarseDimensions[1]; ++y) {
+            for (int x = 0; x < coarseDimensions[0]; ++x) {
+                double* coarseVoxel = coarseScalars + numberOfComponents
+                    * (x + (vtkIdType)coarseDimensions[0] * (y + (vtkIdType)coarseDimensions[1] * z));
+                std::fill(coarseVoxel, coarseVoxel + numberOfComponents, 0.0);
+                int count = 0;
+                for (int fz = 2 * z; fz < std::min(2 * z + 2, dimensions[2]); ++fz) {
+                    for (int fy = 2 * y; fy < std::min(2 * y + 2, dimensions[1]); ++fy) {
+                        for (int fx = 2 * x; fx < std::min(2 * x + 2, dimensions[0]); ++fx) {
+                            T* voxel = scalars + numberOfComponents
+                                * (fx + (vtkIdType)dimensions[0] * (fy + (vtkIdType)dimensions[1] * fz));
+                            for (int c = 0; c < numberOfComponents; ++c) {
+                                coarseVoxel[c] += voxel[c];
+                            }
+                            ++count;
+                        }
+                    }
+                }
+                for (int c = 0; c < numberOfComponents; ++c) {
+                    coarseVoxel[c] /= count;
+                }
+            }
+        }
+    }
+}
+
+
+/**
+ * Scales a capacity image down like DownsampleScalars, into values
+ * between 0 and 1 as vtkGraphCutCostFunctionImages reads them from
+ * floating point images. Costs are averaged over a block. Boundary
+ * strengths, with @p useMaximum, take the largest of the block, so
+ * that thin boundaries are kept.
+ */
+template <class T>
+static void DownsampleCapacityScalars(T* scalars, int* dimensions, double* coarseScalars, int* coarseDimensions, bool useMaximum) {
+    double maximum = std::numeric_limits<T>::is_integer ? (double)std::numeric_limits<T>::max() : 1.0;
+    vtkIdType coarseIndex = 0;
+    for (int z = 0; z < coarseDimensions[2]; ++z) {
+        for (int y = 0; y < coarseDimensions[1]; ++y) {
+            for (int x = 0; x < coarseDimensions[0]; ++x, ++coarseIndex) {
+                double sum = 0.0;
+                double largest = 0.0;
+                int count = 0;
+                for (int fz = 2 * z; fz < std::min(2 * z + 2, dimensions[2]); ++fz) {
+                    for (int fy = 2 * y; fy < std::min(2 * y + 2, dimensions[1]); ++fy) {
+                        for (int fx = 2 * x; fx < std::min(2 * x + 2, dimensions[0]); ++fx) {
+                            T scalar = scalars[fx + (vtkIdType)dimensions[0] * (fy + (vtkIdType)dimensions[1] * fz)];
+                            double value = std::min(std::max((double)scalar / maximum, 0.0), 1.0);
+                            sum += value;
+                            largest = std::max(largest, value);
+                            ++count;
+                        }
+                    }
+                }
+                coarseScalars[coarseIndex] = useMaximum ? largest : sum / count;
+            }
+        }
+    }
+}
+
+
+/**
+ * Sets every voxel of @p mask that lies within @p width voxels of a
+ * set voxel along @p axis. Doing this along every axis sets the
+ * voxels within a cube around the set voxels.
+ */
+static void DilateAlongAxis(std::vector<char>& mask, int* dimensions, int axis, int width) {
+    int a = (axis + 1) % 3;
+    int b = (axis + 2) % 3;
+    int length = dimensions[axis];
+    vtkIdType stride = axis == 0 ? 1 : (axis == 1 ? dimensions[0] : (vtkIdType)dimensions[0] * dimensions[1]);
+    std::vector<char> line(length);
+    for (int j = 0; j < dimensions[b]; ++j) {
+        for (int i = 0; i < dimensions[a]; ++i) {
+            int coordinate[3];
+            coordinate[axis] = 0;
+            coordinate[a] = i;
+            coordinate[b] = j;
+            char* first = &mask[coordinate[0] + (vtkIdType)dimensions[0]
+                * (coordinate[1] + (vtkIdType)dimensions[1] * coordinate[2])];
+            
+            // Distances to the nearest set voxel before and after
+            int distance = width + 1;
+            for (int k = 0; k < length; ++k) {
+                distance = first[k * stride] ? 0 : std::min(distance + 1, width + 1);
+                line[k] = distance <= width;
+            }
+            distance = width + 1;
+            for (int k = length - 1; k >= 0; --k) {
+                distance = first[k * stride] ? 0 : std::min(distance + 1, width + 1);
+                line[k] = line[k] || distance <= width;
+            }
+            for (int k = 0; k < length; ++k) {
+                first[k * stride] = line[k];
+            }
+        }
+    }
+}
+
+
 void vtkGraphCutProtected::PrintSelf(ostream& os, vtkIndent indent) {
     Superclass::PrintSelf(os, indent);
 }
@@ -42,35 +428,30 @@ void vtkGraphCutProtected::Reset() {
     if (_costFunction) {
         _costFunction = NULL;
     }
+    _imagesCostFunction->Reset();
     _connectivity = UNCONNECTED;
+    _solver = BOYKOV_KOLMOGOROV;
+    _numberOfRegions = 0;
+    _parallelGrowth = false;
+    _numberOfLevels = 1;
+    _bandWidth = 2;
     
     // Instance variables
     if (_outputImageData) {
         _outputImageData->Delete();
         _outputImageData = NULL;
     }
-    if (_sourceTree) {
-        delete _sourceTree;
-        _sourceTree = NULL;
-    }
-    if (_sinkTree) {
-        delete _sinkTree;
-        _sinkTree = NULL;
-    }
-    if (_orphans) {
-        _orphans->clear();
-        delete _orphans;
-        _orphans = NULL;
-    }
+    // The nodes and edges are kept, so that they can be used again
+    // when the next input has the same dimensions and connectivity
+    ClearSolution();
+    _inputMTime = 0;
+    _seedPointsMTime = 0;
+    _costFunctionMTime = 0;
     memset_s(_dimensions, sizeof(_dimensions), 0, sizeof(_dimensions));
-    if (_edges) {
-        delete _edges;
-        _edges = NULL;
-    }
-    if (_nodes) {
-        delete _nodes;
-        _nodes = NULL;
-    }
+    memset_s(_inputDimensions, sizeof(_inputDimensions), 0, sizeof(_inputDimensions));
+    memset_s(_graphOffset, sizeof(_graphOffset), 0, sizeof(_graphOffset));
+    std::vector<char>().swap(_coarseLabels);
+    std::vector<char>().swap(_band);
 }
 
 
@@ -79,7 +460,25 @@ vtkImageData* vtkGraphCutProtected::GetOutput() {
 }
 
 
+void vtkGraphCutProtected::SetOutput(vtkImageData* imageData) {
+    if (imageData == _outputImageData) {
+        return;
+    }
+    if (imageData) {
+        imageData->Register(this);
+    }
+    if (_outputImageData) {
+        _outputImageData->Delete();
+    }
+    _outputImageData = imageData;
+}
+
+
 void vtkGraphCutProtected::SetInput(vtkImageData* imageData) {
+    if (imageData != _inputImageData) {
+        ClearSolution();
+        _inputMTime = 0;
+    }
     _inputImageData = imageData;
 }
 
@@ -90,11 +489,94 @@ vtkImageData* vtkGraphCutProtected::GetInput() {
 
 
 void vtkGraphCutProtected::SetSeedPoints(vtkPoints* foreground, vtkPoints* background) {
+    if (foreground != _foregroundPoints || background != _backgroundPoints) {
+        ClearSolution();
+        _seedPointsMTime = 0;
+    }
     _foregroundPoints = foreground;
     _backgroundPoints = background;
 }
 
 
+void vtkGraphCutProtected::AddSeedPoints(vtkPoints* foreground, vtkPoints* background) {
+    if (!_foregroundPoints || !_backgroundPoints) {
+        vtkWarningMacro(<< "No fore- or background points were set. Skipping adding seed points.");
+        return;
+    }
+    
+    // The solution can only be changed incrementally when the seed
+    // points were not modified in some other way since the last update.
+    // With more than one level the band is found again by every update.
+    bool incremental = _sourceTree && _numberOfLevels == 1 && GetSeedPointsMTime() == _seedPointsMTime;
+    
+    vtkPoints* addedPoints[2] = {foreground, background};
+    vtkPoints* seedPoints[2] = {_foregroundPoints, _backgroundPoints};
+    for (int s = 0; s < 2; ++s) {
+        // The points of a seed point set that is added to itself are
+        // seed points already
+        if (!addedPoints[s] || addedPoints[s] == seedPoints[s]) {
+            continue;
+        }
+        // Read before inserting, because the added points may be the
+        // other set of seed points, which grows in the first pass
+        vtkIdType numberOfPoints = addedPoints[s]->GetNumberOfPoints();
+        for (vtkIdType i = 0; i < numberOfPoints; ++i) {
+            double* point = addedPoints[s]->GetPoint(i);
+            seedPoints[s]->InsertNextPoint(point[0], point[1], point[2]);
+        }
+        seedPoints[s]->Modified();
+    }
+    
+    // Otherwise the next update calculates the terminal capacities again
+    if (!incremental) {
+        return;
+    }
+    std::vector<NodeIndex> addedNodes;
+    for (int s = 0; s < 2; ++s) {
+        if (!addedPoints[s]) {
+            continue;
+        }
+        for (vtkIdType i = 0; i < addedPoints[s]->GetNumberOfPoints(); ++i) {
+            NodeIndex nodeIndex = NodeIndexForPoint(addedPoints[s]->GetPoint(i));
+            if (nodeIndex != NODE_NONE) {
+                addedNodes.push_back(nodeIndex);
+            }
+        }
+    }
+    UpdateSeedNodes(&addedNodes);
+    _seedPointsMTime = GetSeedPointsMTime();
+}
+
+
+void vtkGraphCutProtected::RemoveSeedPoints(vtkPoints* foreground, vtkPoints* background) {
+    if (!_foregroundPoints || !_backgroundPoints) {
+        vtkWarningMacro(<< "No fore- or background points were set. Skipping removing seed points.");
+        return;
+    }
+    // The points are matched by the voxels of the input that they lie in
+    if (!_inputImageData) {
+        vtkWarningMacro(<< "No image data was set. Skipping removing seed points.");
+        return;
+    }
+    
+    bool incremental = _sourceTree && _numberOfLevels == 1 && GetSeedPointsMTime() == _seedPointsMTime;
+    
+    std::vector<NodeIndex> removedNodes;
+    if (foreground) {
+        RemovePoints(_foregroundPoints, foreground, &removedNodes);
+    }
+    if (background) {
+        RemovePoints(_backgroundPoints, background, &removedNodes);
+    }
+    
+    if (!incremental) {
+        return;
+    }
+    UpdateSeedNodes(&removedNodes);
+    _seedPointsMTime = GetSeedPointsMTime();
+}
+
+
 vtkPoints* vtkGraphCutProtected::GetForegroundPoints() {
     return _foregroundPoints;
 }
@@ -106,6 +588,10 @@ vtkPoints* vtkGraphCutProtected::GetBackgroundPoints() {
 
 
 void vtkGraphCutProtected::SetCostFunction(vtkGraphCutCostFunction* costFunction) {
+    if (costFunction != _costFunction) {
+        ClearSolution();
+        _costFunctionMTime = 0;
+    }
     _costFunction = costFunction;
 }
 
@@ -115,7 +601,100 @@ vtkGraphCutCostFunction* vtkGraphCutProtected::GetCostFunction() {
 }
 
 
+void vtkGraphCutProtected::SetSourceCapacityImage(vtkImageData* imageData) {
+    _imagesCostFunction->SetSourceCapacityImage(imageData);
+}
+
+
+vtkImageData* vtkGraphCutProtected::GetSourceCapacityImage() {
+    return _imagesCostFunction->GetSourceCapacityImage();
+}
+
+
+void vtkGraphCutProtected::SetSinkCapacityImage(vtkImageData* imageData) {
+    _imagesCostFunction->SetSinkCapacityImage(imageData);
+}
+
+
+vtkImageData* vtkGraphCutProtected::GetSinkCapacityImage() {
+    return _imagesCostFunction->GetSinkCapacityImage();
+}
+
+
+void vtkGraphCutProtected::SetBoundaryImage(vtkImageData* imageData) {
+    _imagesCostFunction->SetBoundaryImage(imageData);
+}
+
+
+vtkImageData* vtkGraphCutProtected::GetBoundaryImage() {
+    return _imagesCostFunction->GetBoundaryImage();
+}
+
+
+void vtkGraphCutProtected::SetSolver(vtkSolverType solver) {
+    if (solver != _solver) {
+        ClearSolution();
+    }
+    _solver = solver;
+}
+
+
+vtkSolverType vtkGraphCutProtected::GetSolver() {
+    return _solver;
+}
+
+
+void vtkGraphCutProtected::SetParallelGrowth(bool parallelGrowth) {
+    _parallelGrowth = parallelGrowth;
+}
+
+
+bool vtkGraphCutProtected::GetParallelGrowth() {
+    return _parallelGrowth;
+}
+
+
+void vtkGraphCutProtected::SetNumberOfRegions(int numberOfRegions) {
+    _numberOfRegions = std::max(0, numberOfRegions);
+}
+
+
+int vtkGraphCutProtected::GetNumberOfRegions() {
+    return _numberOfRegions;
+}
+
+
+void vtkGraphCutProtected::SetNumberOfLevels(int numberOfLevels) {
+    numberOfLevels = std::max(1, numberOfLevels);
+    if (numberOfLevels != _numberOfLevels) {
+        // The capacities of the nodes that were fixed to coarse labels
+        // have to be calculated again
+        ClearSolution();
+        _inputMTime = 0;
+    }
+    _numberOfLevels = numberOfLevels;
+}
+
+
+int vtkGraphCutProtected::GetNumberOfLevels() {
+    return _numberOfLevels;
+}
+
+
+void vtkGraphCutProtected::SetBandWidth(int bandWidth) {
+    _bandWidth = std::max(0, bandWidth);
+}
+
+
+int vtkGraphCutProtected::GetBandWidth() {
+    return _bandWidth;
+}
+
+
 void vtkGraphCutProtected::SetConnectivity(vtkConnectivity connectivity) {
+    if (connectivity != _connectivity) {
+        ClearSolution();
+    }
     _connectivity = connectivity;
 }
 
@@ -154,14 +733,55 @@ void vtkGraphCutProtected::Update() {
     // TODO: check that fore- and background points are located in the image data
     // TODO: Verify cost function
 
-    _inputImageData->GetDimensions(_dimensions);
+    _inputImageData->GetDimensions(_inputDimensions);
+    // Edges and arcs are counted with vtkIdType, but nodes are still
+    // indexed with an int
+    vtkIdType numberOfVoxels = (vtkIdType)_inputDimensions[0] * _inputDimensions[1] * _inputDimensions[2];
+    if (numberOfVoxels > std::numeric_limits<int>::max()) {
+        vtkErrorMacro(<< "The input has more voxels than can be indexed. Skipping update.");
+        return;
+    }
+    if (_numberOfLevels > 1) {
+        // The band follows every change of the inputs, so the graph
+        // is solved from scratch
+        SolveCoarseLevel();
+        ClearSolution();
+        _inputMTime = 0;
+    } else {
+        for (int d = 0; d < 3; ++d) {
+            _dimensions[d] = _inputDimensions[d];
+            _graphOffset[d] = 0;
+        }
+        std::vector<char>().swap(_coarseLabels);
+        std::vector<char>().swap(_band);
+    }
 
+    // The graph of a previous update is kept as long as the
+    // dimensions and the connectivity stay the same. A band is
+    // found anew by every update.
+    if (_nodes) {
+        int* dimensions = _nodes->GetDimensions();
+        if (_nodes->GetConnectivity() != _connectivity
+            || _nodes->HasBand()
+            || !_band.empty()
+            || dimensions[0] != _dimensions[0]
+            || dimensions[1] != _dimensions[1]
+            || dimensions[2] != _dimensions[2]) {
+            ClearSolution();
+            ClearGraph();
+        }
+    }
     // Build nodes data if not exists yet
     if (!_nodes) {
         _nodes = new Nodes();
         _nodes->SetConnectivity(_connectivity);
         _nodes->SetDimensions(_dimensions);
+        if (!_band.empty()) {
+            _nodes->SetBand(_band);
+            std::vector<char>().swap(_band);
+        }
         _nodes->Update();
+        _inputMTime = 0;
     }
     // Build edges data if not exists yet
     if (!_edges) {
@@ -170,32 +790,97 @@ void vtkGraphCutProtected::Update() {
         _edges->Update();
     }
     
-    CalculateCapacitiesForEdges();
-
-    if (!_sinkTree) {
-        _sinkTree = new Tree(TREE_SINK, _edges);
+    // Only the capacities that depend on modified inputs are calculated
+    // again: all of them when the image or the cost function changed,
+    // only those of the terminal edges when the seed points changed
+    vtkMTimeType inputMTime = _inputImageData->GetMTime();
+    vtkMTimeType seedPointsMTime = GetSeedPointsMTime();
+    vtkMTimeType costFunctionMTime = GetCurrentCostFunction()->GetMTime();
+    bool inputChanged = inputMTime != _inputMTime || costFunctionMTime != _costFunctionMTime;
+    bool seedPointsChanged = seedPointsMTime != _seedPointsMTime;
+    if (inputChanged || seedPointsChanged) {
+        ClearSolution();
     }
+    
+    // The trees of a previous update are kept together with the flow,
+    // so that changes to the seed points can be solved incrementally
     if (!_sourceTree) {
+        _edges->ResetFlow();
+        _nodes->ClearTrees();
+    }
+    if (inputChanged || seedPointsChanged) {
+        CalculateCapacitiesForEdges(inputChanged);
+    }
+    _inputMTime = inputMTime;
+    _seedPointsMTime = seedPointsMTime;
+    _costFunctionMTime = costFunctionMTime;
+    
+    if (_solver != BOYKOV_KOLMOGOROV) {
+        // The other solvers keep no trees between updates, so every
+        // update starts from a zero flow
+        switch (_connectivity) {
+            case SIX:
+                SolveFromZeroFlow<SIX>();
+                break;
+            case EIGHTEEN:
+                SolveFromZeroFlow<EIGHTEEN>();
+                break;
+            case TWENTYSIX:
+                SolveFromZeroFlow<TWENTYSIX>();
+                break;
+            default:
+                assert(false);
+        }
+        UpdateOutput();
+        return;
+    }
+    
+    if (!_sourceTree) {
+        _sinkTree = new Tree(TREE_SINK, _edges);
         _sourceTree = new Tree(TREE_SOURCE, _edges);
+        _activeSourceNodes = new ActiveNodes(_nodes);
+        _activeSinkNodes = new ActiveNodes(_nodes);
+        _sourceTree->SetActiveNodes(_activeSourceNodes);
+        _sinkTree->SetActiveNodes(_activeSinkNodes);
+        _orphans = new std::vector<NodeIndex>();
+        
+        InitializeTrees();
     }
 
-    PriorityQueue* activeSourceNodes = new PriorityQueue();
-    PriorityQueue* activeSinkNodes = new PriorityQueue();
-
-    if (!_orphans) {
-        _orphans = new std::vector<NodeIndex>();
+    switch (_connectivity) {
+        case SIX:
+            MaxFlow<SIX>();
+            break;
+        case EIGHTEEN:
+            MaxFlow<EIGHTEEN>();
+            break;
+        case TWENTYSIX:
+            MaxFlow<TWENTYSIX>();
+            break;
+        default:
+            assert(false);
     }
     
-    activeSourceNodes->push(std::make_pair(0, NODE_SOURCE));
-    activeSinkNodes->push(std::make_pair(0, NODE_SINK));
-    
+    UpdateOutput();
+}
+
+
+// Algorithm steps
+
+/**
+ * Runs the growth, augment and adopt stages until no more
+ * augmenting paths can be found.
+ */
+template <vtkConnectivity Connectivity>
+void vtkGraphCutProtected::MaxFlow() {
     // Start algorithm
     while (true) {
         // Stage 0: Adopt phase
         // There might be orphans in the trees because the user
         // might have added/removed fore- and background points
+        // since the last update
         if (_orphans->size() > 0) {
-            Adopt(_orphans);
+            Adopt<Connectivity>(_orphans);
         }
         
         int treeSelector = 0;
@@ -217,13 +902,17 @@ void vtkGraphCutProtected::Update() {
         // priority queue of active nodes of tree for that type?
         // Returns: edge and bool
         
-        while (noActiveNodesCounter < 2) {
+        if (_parallelGrowth) {
+            edgeIndexBetweenGraphs = GrowInParallel<Connectivity>();
+        }
+        
+        while (!_parallelGrowth && noActiveNodesCounter < 2) {
             vtkTreeType tree = (treeSelector % 2 == 0) ? TREE_SOURCE : TREE_SINK;
             
-            // foundActiveNodes is set when active nodes are found, but no path was found
+            // foundActiveNodes is set when the tree still had an active node to grow from
             // If no path is found, but there was a succesful growing iteration the other tree may grow
             bool foundActiveNodes;
-            edgeIndexBetweenGraphs = Grow(tree, foundActiveNodes, tree == TREE_SOURCE ? activeSourceNodes : activeSinkNodes);
+            edgeIndexBetweenGraphs = Grow<Connectivity>(tree, foundActiveNodes);
             noActiveNodesCounter = foundActiveNodes ? 0 : noActiveNodesCounter + 1;
             
             // If a path has been found, then we can break the loop and proceed to the next part
@@ -235,8 +924,8 @@ void vtkGraphCutProtected::Update() {
         
         if (edgeIndexBetweenGraphs <= EDGE_NONE) {
             // Didn't find a path and there should be no more active nodes, so we can call it quits
-            assert(activeSourceNodes->size() == 0);
-            assert(activeSinkNodes->size() == 0);
+            assert(_activeSourceNodes->IsEmpty());
+            assert(_activeSinkNodes->IsEmpty());
             break;
         }
         
@@ -270,137 +959,163 @@ void vtkGraphCutProtected::Update() {
         // Orphans
         // Edges
         // Nodes
-        Adopt(_orphans);
+        Adopt<Connectivity>(_orphans);
     }
-    
-    delete activeSinkNodes;
-    delete activeSourceNodes;
-    
-    _outputImageData = vtkImageData::New();
-    _outputImageData->SetDimensions(_dimensions);
-    _outputImageData->AllocateScalars(VTK_CHAR, 1);
-    _outputImageData->SetSpacing(_inputImageData->GetSpacing());
-    _outputImageData->SetOrigin(_inputImageData->GetOrigin());
+}
 
-    for (int z = 0; z < _dimensions[2]; ++z) {
-        for (int y = 0; y < _dimensions[1]; ++y) {
-            for (int x = 0; x < _dimensions[0]; ++x) {
-                int coordinate[3];
-                coordinate[0] = x;
-                coordinate[1] = y;
-                coordinate[2] = z;
-                NodeIndex nodeIndex = _nodes->GetIndexForCoordinate(coordinate);
-                Node* node = _nodes->GetNode(nodeIndex);
-                double value = 0;
-                if (node->tree == TREE_SOURCE) {
-                    value = 1;
-                } else if (node->tree == TREE_SINK) {
-                    value = -1;
+
+/**
+ * Grows both trees from batches of their active nodes until they touch.
+ * The neighbours of a batch are scanned on the threads of vtkSMPTools,
+ * after which the neighbours are added to the trees one by one, in the
+ * order of the batch. When a neighbour turns out to be in the other
+ * tree, the edge to it is returned. The next call carries on from that
+ * neighbour, like Grow does with its active node. Returns EDGE_NONE
+ * when both trees have no active nodes left.
+ */
+template <vtkConnectivity Connectivity>
+EdgeIndex vtkGraphCutProtected::GrowInParallel() {
+    const int numberOfNeighbours = ConnectivityTraits<Connectivity>::NumberOfNeighbours;
+    while (true) {
+        if (_growthPosition == (int)_growthNodes.size()) {
+            // Take a new batch from the fronts of the active nodes. Nodes
+            // that moved to the other tree are handed to its list.
+            _growthNodes.clear();
+            _growthPosition = 0;
+            _growthCandidatePosition = 0;
+            for (int t = 0; t < 2; ++t) {
+                vtkTreeType tree = t == 0 ? TREE_SOURCE : TREE_SINK;
+                ActiveNodes* activeNodes = t == 0 ? _activeSourceNodes : _activeSinkNodes;
+                ActiveNodes* otherActiveNodes = t == 0 ? _activeSinkNodes : _activeSourceNodes;
+                int batchSize = 0;
+                while (batchSize < GrowthBatchSize && !activeNodes->IsEmpty()) {
+                    NodeIndex index = activeNodes->GetFront();
+                    activeNodes->Pop();
+                    vtkTreeType activeTree = _nodes->TreeForIndex(index);
+                    if (activeTree == tree) {
+                        _growthNodes.push_back(index);
+                        ++batchSize;
+                    } else if (activeTree != TREE_NONE) {
+                        otherActiveNodes->Push(index);
+                    }
+                }
+            }
+            if (_growthNodes.empty()) {
+                if (_activeSourceNodes->IsEmpty() && _activeSinkNodes->IsEmpty()) {
+                    return EDGE_NONE;
+                }
+                continue;
+            }
+            
+            int batchSize = (int)_growthNodes.size();
+            _growthTrees.resize(batchSize);
+            for (int i = 0; i < batchSize; ++i) {
+                _growthTrees[i] = _nodes->TreeForIndex(_growthNodes[i]);
+            }
+            _growthCandidates.resize(batchSize * numberOfNeighbours);
+            _growthCandidateCounts.resize(batchSize);
+            GrowthScanFunctor<Connectivity> scanFunctor;
+            scanFunctor.nodes = _nodes;
+            scanFunctor.edges = _edges;
+            scanFunctor.activeNodes = &_growthNodes[0];
+            scanFunctor.candidates = &_growthCandidates[0];
+            scanFunctor.numberOfCandidates = &_growthCandidateCounts[0];
+            vtkSMPTools::For(0, batchSize, GrowthGrainSize, scanFunctor);
+        }
+        
+        // Augmentations and adoptions since the scan may have saturated
+        // arcs and moved nodes, so every candidate is checked again
+        for (; _growthPosition < (int)_growthNodes.size(); ++_growthPosition, _growthCandidatePosition = 0) {
+            NodeIndex index = _growthNodes[_growthPosition];
+            vtkTreeType tree = _growthTrees[_growthPosition];
+            vtkTreeType currentTree = _nodes->TreeForIndex(index);
+            if (currentTree != tree) {
+                if (currentTree != TREE_NONE) {
+                    (currentTree == TREE_SOURCE ? _activeSourceNodes : _activeSinkNodes)->Push(index);
+                }
+                continue;
+            }
+            Tree* growingTree = tree == TREE_SOURCE ? _sourceTree : _sinkTree;
+            ActiveNodes* activeNodes = tree == TREE_SOURCE ? _activeSourceNodes : _activeSinkNodes;
+            const NodeIndex* candidates = &_growthCandidates[_growthPosition * numberOfNeighbours];
+            for (; _growthCandidatePosition < _growthCandidateCounts[_growthPosition]; ++_growthCandidatePosition) {
+                NodeIndex neighbour = candidates[_growthCandidatePosition];
+                vtkTreeType neighbourTree = _nodes->TreeForIndex(neighbour);
+                ArcIndex arc = tree == TREE_SOURCE
+                    ? _edges->ArcFromNodeToNode(index, neighbour)
+                    : _edges->ArcFromNodeToNode(neighbour, index);
+                if (neighbourTree == tree || _edges->ResidualCapacityForArc(arc) == 0) {
+                    continue;
+                }
+                if (neighbourTree == TREE_NONE) {
+                    growingTree->AddChildToParent(neighbour, index);
+                    activeNodes->Push(neighbour);
+                } else {
+                    return _edges->IndexForEdgeFromNodeToNode(index, neighbour);
                 }
-                _outputImageData->SetScalarComponentFromDouble(x, y, z, 0, value);
             }
         }
     }
 }
 
 
-// Algorithm steps
-
 /**
  * Returns EDGE_NONE if no edge has been found.
  */
-EdgeIndex vtkGraphCutProtected::Grow(vtkTreeType tree, bool& foundActiveNodes, PriorityQueue* activeNodes) {
+template <vtkConnectivity Connectivity>
+EdgeIndex vtkGraphCutProtected::Grow(vtkTreeType tree, bool& foundActiveNodes) {
     foundActiveNodes = false;
+    ActiveNodes* activeNodes = tree == TREE_SOURCE ? _activeSourceNodes : _activeSinkNodes;
     
-    // Get an active node from the tree
-    std::pair<int, NodeIndex> active = activeNodes->top();
-    
-    // Pop until active node is found
-    while (true) {
-        if (active.second >= 0) {
-            Node* node = _nodes->GetNode(active.second);
-            if (node->active) {
-                break;
-            }
-            
-            assert(activeNodes->size() > 0 && activeNodes->size() < 500);
-            activeNodes->pop();
-
-            // If there are no more active nodes, return EDGE_NONE
-            if (activeNodes->size() == 0) {
-                return EDGE_NONE;
-            }
-            active = activeNodes->top();
-        } else {
+    // Get an active node from the tree. Nodes that left the
+    // tree since they were activated are skipped; nodes that
+    // moved to the other tree are handed to its list. The other
+    // tree then has work to do, which counts as finding an active node.
+    NodeIndex activeNodeIndex = activeNodes->GetFront();
+    while (activeNodeIndex >= 0) {
+        vtkTreeType activeTree = _nodes->GetNode(activeNodeIndex).tree;
+        if (activeTree == tree) {
             break;
         }
+        activeNodes->Pop();
+        if (activeTree != TREE_NONE) {
+            (tree == TREE_SOURCE ? _activeSinkNodes : _activeSourceNodes)->Push(activeNodeIndex);
+            foundActiveNodes = true;
+        }
+        activeNodeIndex = activeNodes->GetFront();
     }
     
-    NodeIndex activeNodeIndex = active.second;
-    if (activeNodeIndex >= 0) {
-        std::vector<NodeIndex> neighbours = _nodes->GetIndicesForNeighbours(activeNodeIndex);
-        Edge* edgeBetweenTrees = NULL;
-        int index = 0;
-        for (std::vector<NodeIndex>::iterator i = neighbours.begin(); i != neighbours.end(); ++i) {
-            // Check to see if the edge to the node is saturated or not
-            Edge* edge = _edges->EdgeFromNodeToNode(activeNodeIndex, *i);
-            if (!edge->isSaturatedFromNode(tree == TREE_SOURCE ? activeNodeIndex : *i)) {
-                // If the other node is free, it can be added to the tree
-                Node* neighbour = _nodes->GetNode(*i);
-                if (neighbour->tree == TREE_NONE) {
-                    // Other node is added as a child to active node
-                    (tree == TREE_SOURCE) ? _sourceTree->AddChildToParent(*i, activeNodeIndex) : _sinkTree->AddChildToParent(*i, activeNodeIndex);
-                    neighbour->active = true;
-                    foundActiveNodes = true;
-                    activeNodes->push(std::make_pair(neighbour->depthInTree, *i));
-                } else if (neighbour->tree != tree) {
-                    // If the other node is from the other tree, we have found a path!
-                    edgeBetweenTrees = edge;
-                    break;
-                }
-            }
-            index += 1;
-        }
-        
-        EdgeIndex edgeIndex = EDGE_NONE;
-        // If no edge has been found, then the current node can become inactive
-        if (!edgeBetweenTrees) {
-            Node* node = _nodes->GetNode(activeNodeIndex);
-            node->active = false;
-            activeNodes->pop();
-        } else {
-            edgeIndex = (EdgeIndex)index;
-        }
-        return edgeIndex;
-    } else { // Tree node
-        int i = 0;
-        EdgeIndex edgeIndex = EDGE_NONE;
-        for (std::vector<Node*>::iterator it = _nodes->GetIterator(); it != _nodes->GetEnd(); ++it) {
+    // If there are no more active nodes, return EDGE_NONE
+    if (activeNodeIndex == NODE_NONE) {
+        return EDGE_NONE;
+    }
+    foundActiveNodes = true;
+    
+    EdgeIndex edgeIndex = EDGE_NONE;
+    for (FixedNeighbourIterator<Connectivity> it(_nodes, activeNodeIndex); !it.IsAtEnd(); it.Next()) {
+        NodeIndex i = it.GetIndex();
+        // Check to see if the edge to the node is saturated or not
+        Edge edge = _edges->EdgeFromNodeToNode(activeNodeIndex, i);
+        if (!edge.isSaturatedFromNode(tree == TREE_SOURCE ? activeNodeIndex : i)) {
             // If the other node is free, it can be added to the tree
-            Node* node = *it;
-            Edge* edge = _edges->EdgeFromNodeToNode(activeNodeIndex, (NodeIndex)i);
-            if (!edge->isSaturatedFromNode(tree == TREE_SOURCE ? (NodeIndex)tree : (NodeIndex)i)) {
-                if (node->tree == TREE_NONE) {
-                    // Other node is added as a child to active node
-                    (tree == TREE_SOURCE) ? _sourceTree->AddChildToParent((NodeIndex)i, (NodeIndex)tree) : _sinkTree->AddChildToParent((NodeIndex)i, (NodeIndex)tree);
-                    (*it)->active = true;
-                    foundActiveNodes = true;
-                    activeNodes->push(std::make_pair(node->depthInTree, (NodeIndex)i));
-                } else if (node->tree != tree) {
-                    // If the other node is from the other tree, we have found a path!
-                    edgeIndex = _edges->IndexForEdgeFromNodeToNode(activeNodeIndex, (NodeIndex)i);
-                    break;
-                }
+            Node neighbour = _nodes->GetNode(i);
+            if (neighbour.tree == TREE_NONE) {
+                // Other node is added as a child to active node
+                (tree == TREE_SOURCE) ? _sourceTree->AddChildToParent(i, activeNodeIndex) : _sinkTree->AddChildToParent(i, activeNodeIndex);
+                activeNodes->Push(i);
+            } else if (neighbour.tree != tree) {
+                // If the other node is from the other tree, we have found a path!
+                edgeIndex = _edges->IndexForEdgeFromNodeToNode(activeNodeIndex, i);
+                break;
             }
-            ++i;
         }
-        
-        if (edgeIndex < 0) {
-            assert(activeNodes->top().second == NODE_SINK || activeNodes->top().second == NODE_SOURCE);
-            activeNodes->pop();
-        }
-        return edgeIndex;
     }
+    
+    // If no edge has been found, then the current node can become inactive
+    if (edgeIndex == EDGE_NONE) {
+        activeNodes->Pop();
+    }
+    return edgeIndex;
 }
 
 
@@ -415,48 +1130,255 @@ std::vector<NodeIndex>* vtkGraphCutProtected::Augment(EdgeIndex edgeIndex) {
     // path will become an orphan node (not connected to S or T anymore).
     assert(edgeIndex >= 0);
     assert(edgeIndex < _edges->GetSize());
-    Edge* edge = _edges->GetEdge(edgeIndex);
-    assert(edge->isValid());
-    assert(edge->node1() < (int)_nodes->GetSize());
-    assert(edge->node2() < (int)_nodes->GetSize());
-    
-    // Figure out the tree type of the first node of the edge
-    int node1Tree = 0;
-    NodeIndex fromNode = NODE_NONE;
-    if (edge->isTerminal()) {
-        node1Tree = edge->rootNode();
-        fromNode = node1Tree == NODE_SOURCE ? edge->rootNode() : edge->nonRootNode();
-    } else {
-        Node* node1 = _nodes->GetNode(edge->node1());
-        assert(node1->tree == TREE_SOURCE || node1->tree == TREE_SINK);
-        node1Tree = node1->tree;
-        fromNode = node1Tree == NODE_SOURCE ? edge->node1() : edge->node2();
-    }
+    Edge edge = _edges->GetEdge(edgeIndex);
+    assert(edge.isValid());
+    assert(edge.node1() < (int)_nodes->GetSize());
+    assert(edge.node2() < (int)_nodes->GetSize());
     
-    assert(fromNode != NODE_NONE);
-    int maxPossibleFlow = edge->capacityFromNode(fromNode);
+    // Figure out which node of the edge lies in the source tree
+    NodeIndex sourceNode = edge.node1();
+    NodeIndex sinkNode = edge.node2();
+    bool node1InSourceTree = sourceNode == NODE_SOURCE
+        || (sourceNode >= 0 && _nodes->GetNode(sourceNode).tree == TREE_SOURCE);
+    if (!node1InSourceTree) {
+        std::swap(sourceNode, sinkNode);
+    }
+    assert(sourceNode == NODE_SOURCE || _nodes->GetNode(sourceNode).tree == TREE_SOURCE);
+    assert(sinkNode == NODE_SINK || _nodes->GetNode(sinkNode).tree == TREE_SINK);
     
-    std::vector<EdgeIndex> pathToSource = _sourceTree->PathToRoot(node1Tree == NODE_SOURCE ? edge->node1() : edge->node2(), &maxPossibleFlow);
-    std::vector<EdgeIndex> pathToSink = _sinkTree->PathToRoot(node1Tree == NODE_SOURCE ? edge->node2() : edge->node1(), &maxPossibleFlow);
+    int maxPossibleFlow = edge.capacityFromNode(sourceNode);
+    maxPossibleFlow = _sourceTree->MaxFlowToRoot(sourceNode, maxPossibleFlow);
+    maxPossibleFlow = _sinkTree->MaxFlowToRoot(sinkNode, maxPossibleFlow);
     
     assert(maxPossibleFlow > 0);
     
-    edge->addFlowFromNode(fromNode, maxPossibleFlow);
-
-    _sourceTree->PushFlowThroughPath(pathToSource, maxPossibleFlow, _orphans);
-    _sinkTree->PushFlowThroughPath(pathToSink, maxPossibleFlow, _orphans);
+    edge.addFlowFromNode(sourceNode, maxPossibleFlow);
+    
+    _sourceTree->PushFlowToRoot(sourceNode, maxPossibleFlow, _orphans);
+    _sinkTree->PushFlowToRoot(sinkNode, maxPossibleFlow, _orphans);
     
     return _orphans;
 }
 
 
-void vtkGraphCutProtected::Adopt(std::vector<NodeIndex>* orphans) {
-    for (std::vector<NodeIndex>::iterator orphan = orphans->begin(); orphan != orphans->end(); ++orphan) {
-        Node* node = _nodes->GetNode(*orphan);
-        assert(node->orphan);
-        node->tree == TREE_SOURCE ? _sourceTree->Adopt(*orphan) : _sinkTree->Adopt(*orphan);
-        assert(!node->orphan);
+/**
+ * Calculates the maximum flow with one of the solvers that start from
+ * a zero flow and sets the trees of the nodes to the sides of the
+ * minimum cut.
+ */
+template <vtkConnectivity Connectivity>
+void vtkGraphCutProtected::SolveFromZeroFlow() {
+    if (_solver == PUSH_RELABEL) {
+        PushRelabel pushRelabel(_edges);
+        pushRelabel.MaxFlow<Connectivity>();
+        pushRelabel.LabelNodes<Connectivity>();
+    } else if (_solver == INCREMENTAL_BREADTH_FIRST_SEARCH) {
+        IncrementalBreadthFirstSearch search(_edges);
+        search.MaxFlow<Connectivity>();
+    } else if (_solver == PARALLEL_PUSH_RELABEL) {
+        int numberOfRegions = _numberOfRegions;
+        if (numberOfRegions == 0) {
+            numberOfRegions = _dimensions[2] / 4;
+        }
+        RegionPushRelabel pushRelabel(_edges, numberOfRegions);
+        pushRelabel.MaxFlow<Connectivity>();
+        pushRelabel.LabelNodes<Connectivity>();
+    }
+}
+
+
+/**
+ * Segments the input at half the resolution, with one level less, and
+ * fits the graph to the band around the boundary of that segmentation.
+ * Sets _coarseLabels to the coarse label of every voxel, _graphOffset
+ * and _dimensions to the box around the band and _band to the voxels
+ * of the box that lie in the band, which are the only ones that get a
+ * node. Voxels without a coarse label are always part of the band.
+ */
+void vtkGraphCutProtected::SolveCoarseLevel() {
+    int* dimensions = _inputDimensions;
+    int coarseDimensions[3];
+    for (int d = 0; d < 3; ++d) {
+        coarseDimensions[d] = (dimensions[d] + 1) / 2;
+    }
+    
+    int numberOfComponents = _inputImageData->GetNumberOfScalarComponents();
+    vtkImageData* coarseInput = vtkImageData::New();
+    coarseInput->SetDimensions(coarseDimensions);
+    coarseInput->AllocateScalars(VTK_DOUBLE, numberOfComponents);
+    double* coarseScalars = static_cast<double*>(coarseInput->GetScalarPointer());
+    void* scalars = _inputImageData->GetScalarPointer();
+    switch (_inputImageData->GetScalarType()) {
+        vtkTemplateMacro(DownsampleScalars(static_cast<VTK_TT*>(scalars), dimensions, numberOfComponents, coarseScalars, coarseDimensions));
+    }
+    
+    // Seed points are voxel coordinates; points outside of the input
+    // stay outside
+    vtkPoints* seedPoints[2] = {_foregroundPoints, _backgroundPoints};
+    vtkPoints* coarsePoints[2];
+    for (int s = 0; s < 2; ++s) {
+        coarsePoints[s] = vtkPoints::New();
+        for (vtkIdType i = 0; i < seedPoints[s]->GetNumberOfPoints(); ++i) {
+            double* point = seedPoints[s]->GetPoint(i);
+            double coarsePoint[3];
+            for (int d = 0; d < 3; ++d) {
+                int coordinate = (int)point[d];
+                coarsePoint[d] = coordinate >= 0 ? coordinate / 2 : -1;
+            }
+            coarsePoints[s]->InsertNextPoint(coarsePoint[0], coarsePoint[1], coarsePoint[2]);
+        }
+    }
+    
+    // The capacity images are scaled down too, except for those that do
+    // not fit the input, which are not used at full resolution either
+    vtkImageData* images[3] = {GetSourceCapacityImage(), GetSinkCapacityImage(), GetBoundaryImage()};
+    vtkImageData* coarseImages[3] = {NULL, NULL, NULL};
+    for (int i = 0; i < 3; ++i) {
+        if (!images[i]) {
+            continue;
+        }
+        int* imageDimensions = images[i]->GetDimensions();
+        if (imageDimensions[0] != dimensions[0]
+            || imageDimensions[1] != dimensions[1]
+            || imageDimensions[2] != dimensions[2]
+            || images[i]->GetNumberOfScalarComponents() != 1) {
+            continue;
+        }
+        coarseImages[i] = vtkImageData::New();
+        coarseImages[i]->SetDimensions(coarseDimensions);
+        coarseImages[i]->AllocateScalars(VTK_DOUBLE, 1);
+        double* coarseImageScalars = static_cast<double*>(coarseImages[i]->GetScalarPointer());
+        void* imageScalars = images[i]->GetScalarPointer();
+        switch (images[i]->GetScalarType()) {
+            vtkTemplateMacro(DownsampleCapacityScalars(static_cast<VTK_TT*>(imageScalars), dimensions, coarseImageScalars, coarseDimensions, i == 2));
+        }
+    }
+    
+    vtkGraphCutProtected* coarseGraphCut = vtkGraphCutProtected::New();
+    coarseGraphCut->SetInput(coarseInput);
+    coarseGraphCut->SetSeedPoints(coarsePoints[0], coarsePoints[1]);
+    coarseGraphCut->SetCostFunction(_costFunction);
+    coarseGraphCut->SetConnectivity(_connectivity);
+    coarseGraphCut->SetSolver(_solver);
+    coarseGraphCut->SetNumberOfRegions(_numberOfRegions);
+    coarseGraphCut->SetParallelGrowth(_parallelGrowth);
+    coarseGraphCut->SetNumberOfLevels(_numberOfLevels - 1);
+    coarseGraphCut->SetBandWidth(_bandWidth);
+    coarseGraphCut->SetSourceCapacityImage(coarseImages[0]);
+    coarseGraphCut->SetSinkCapacityImage(coarseImages[1]);
+    coarseGraphCut->SetBoundaryImage(coarseImages[2]);
+    coarseGraphCut->Update();
+    
+    // The cost function that was set is shared with the coarse level,
+    // which pointed it at the coarse input and seed points
+    if (_costFunction) {
+        _costFunction->SetInput(_inputImageData);
+        _costFunction->SetSeedPoints(_foregroundPoints, _backgroundPoints);
+    }
+    
+    // Every voxel gets the label of the coarse voxel that it lies in
+    vtkIdType numberOfVoxels = (vtkIdType)dimensions[0] * dimensions[1] * dimensions[2];
+    _coarseLabels.assign(numberOfVoxels, 0);
+    vtkImageData* coarseOutput = coarseGraphCut->GetOutput();
+    if (coarseOutput) {
+        char* coarseLabels = static_cast<char*>(coarseOutput->GetScalarPointer());
+        vtkIdType index = 0;
+        for (int z = 0; z < dimensions[2]; ++z) {
+            for (int y = 0; y < dimensions[1]; ++y) {
+                char* coarseRow = coarseLabels + (vtkIdType)coarseDimensions[0]
+                    * (y / 2 + (vtkIdType)coarseDimensions[1] * (z / 2));
+                for (int x = 0; x < dimensions[0]; ++x, ++index) {
+                    _coarseLabels[index] = coarseRow[x / 2];
+                }
+            }
+        }
+    }
+    coarseGraphCut->Delete();
+    coarsePoints[0]->Delete();
+    coarsePoints[1]->Delete();
+    coarseInput->Delete();
+    for (int i = 0; i < 3; ++i) {
+        if (coarseImages[i]) {
+            coarseImages[i]->Delete();
+        }
     }
+    
+    // The band holds the voxels next to a voxel with another label and
+    // those without a label, grown by the band width
+    std::vector<char> band(numberOfVoxels, 0);
+    vtkIdType strides[3] = {1, dimensions[0], (vtkIdType)dimensions[0] * dimensions[1]};
+    vtkIdType index = 0;
+    for (int z = 0; z < dimensions[2]; ++z) {
+        for (int y = 0; y < dimensions[1]; ++y) {
+            for (int x = 0; x < dimensions[0]; ++x, ++index) {
+                char label = _coarseLabels[index];
+                if (label == 0) {
+                    band[index] = 1;
+                }
+                int coordinate[3] = {x, y, z};
+                for (int d = 0; d < 3; ++d) {
+                    if (coordinate[d] + 1 < dimensions[d] && _coarseLabels[index + strides[d]] != label) {
+                        band[index] = 1;
+                        band[index + strides[d]] = 1;
+                    }
+                }
+            }
+        }
+    }
+    if (_bandWidth > 0) {
+        for (int d = 0; d < 3; ++d) {
+            DilateAlongAxis(band, dimensions, d, _bandWidth);
+        }
+    }
+    
+    int boxBegin[3] = {dimensions[0], dimensions[1], dimensions[2]};
+    int boxEnd[3] = {0, 0, 0};
+    index = 0;
+    for (int z = 0; z < dimensions[2]; ++z) {
+        for (int y = 0; y < dimensions[1]; ++y) {
+            for (int x = 0; x < dimensions[0]; ++x, ++index) {
+                if (!band[index]) {
+                    continue;
+                }
+                int coordinate[3] = {x, y, z};
+                for (int d = 0; d < 3; ++d) {
+                    boxBegin[d] = std::min(boxBegin[d], coordinate[d]);
+                    boxEnd[d] = std::max(boxEnd[d], coordinate[d] + 1);
+                }
+            }
+        }
+    }
+    // Without a boundary a single voxel keeps the graph valid
+    bool hasBoundary = boxBegin[0] < boxEnd[0];
+    if (!hasBoundary) {
+        for (int d = 0; d < 3; ++d) {
+            boxBegin[d] = 0;
+            boxEnd[d] = 1;
+        }
+    }
+    for (int d = 0; d < 3; ++d) {
+        _graphOffset[d] = boxBegin[d];
+        _dimensions[d] = boxEnd[d] - boxBegin[d];
+    }
+    
+    _band.assign((size_t)_dimensions[0] * _dimensions[1] * _dimensions[2], 0);
+    vtkIdType boxIndex = 0;
+    for (int z = boxBegin[2]; z < boxEnd[2]; ++z) {
+        for (int y = boxBegin[1]; y < boxEnd[1]; ++y) {
+            for (int x = boxBegin[0]; x < boxEnd[0]; ++x, ++boxIndex) {
+                index = x + strides[1] * y + strides[2] * z;
+                _band[boxIndex] = band[index] || !hasBoundary;
+            }
+        }
+    }
+}
+
+
+template <vtkConnectivity Connectivity>
+void vtkGraphCutProtected::Adopt(std::vector<NodeIndex>* orphans) {
+    // Each tree adopts its own orphans in a single pass
+    _sourceTree->Adopt<Connectivity>(orphans);
+    _sinkTree->Adopt<Connectivity>(orphans);
 
     orphans->clear();
 }
@@ -474,117 +1396,431 @@ vtkGraphCutProtected::vtkGraphCutProtected() {
     _sourceTree = NULL;
     _sinkTree = NULL;
     _orphans = NULL;
+    _activeSourceNodes = NULL;
+    _activeSinkNodes = NULL;
     _costFunction = NULL;
     _dimensions[0] = 0;
     _dimensions[1] = 0;
     _dimensions[2] = 0;
     _connectivity = UNCONNECTED;
+    _solver = BOYKOV_KOLMOGOROV;
+    _numberOfRegions = 0;
+    _parallelGrowth = false;
+    _numberOfLevels = 1;
+    _bandWidth = 2;
+    _defaultCostFunction = vtkGraphCutCostFunctionSimple::New();
+    _imagesCostFunction = vtkGraphCutCostFunctionImages::New();
+    _seedCapacity = 0;
+    _inputMTime = 0;
+    _seedPointsMTime = 0;
+    _costFunctionMTime = 0;
     Reset();
 }
 
 vtkGraphCutProtected::~vtkGraphCutProtected() {
     Reset();
+    ClearGraph();
+    _defaultCostFunction->Delete();
+    _imagesCostFunction->Delete();
 }
 
 
 // Private methods
 
-void vtkGraphCutProtected::CalculateCapacitiesForEdges() {
-    //	double constantK 			= 0.0;
-    //	double lambda 				= 500.0;
+/**
+ * Frees the trees of the last update, so that the next update
+ * solves from scratch. The graph itself is kept.
+ */
+void vtkGraphCutProtected::ClearSolution() {
+    if (_sourceTree) {
+        delete _sourceTree;
+        _sourceTree = NULL;
+    }
+    if (_sinkTree) {
+        delete _sinkTree;
+        _sinkTree = NULL;
+    }
+    if (_activeSourceNodes) {
+        delete _activeSourceNodes;
+        _activeSourceNodes = NULL;
+    }
+    if (_activeSinkNodes) {
+        delete _activeSinkNodes;
+        _activeSinkNodes = NULL;
+    }
+    if (_orphans) {
+        _orphans->clear();
+        delete _orphans;
+        _orphans = NULL;
+    }
+    _growthNodes.clear();
+    _growthPosition = 0;
+    _growthCandidatePosition = 0;
+}
+
+
+/**
+ * Frees the nodes and the edges of the graph.
+ */
+void vtkGraphCutProtected::ClearGraph() {
+    if (_edges) {
+        delete _edges;
+        _edges = NULL;
+    }
+    if (_nodes) {
+        delete _nodes;
+        _nodes = NULL;
+    }
+}
+
+
+/**
+ * Returns the latest modification time of the fore- and background
+ * points.
+ */
+vtkMTimeType vtkGraphCutProtected::GetSeedPointsMTime() {
+    return std::max(_foregroundPoints->GetMTime(), _backgroundPoints->GetMTime());
+}
+
+
+/**
+ * Writes the label of every node to the output: 1 for the foreground,
+ * -1 for the background and 0 for nodes that are in neither tree. The
+ * voxels outside the graph get their coarse labels. The output is
+ * allocated again only when it does not fit the input.
+ */
+void vtkGraphCutProtected::UpdateOutput() {
+    if (!_outputImageData) {
+        _outputImageData = vtkImageData::New();
+    }
+    int* dimensions = _outputImageData->GetDimensions();
+    int scalarType = _outputImageData->GetScalarType();
+    bool fits = dimensions[0] == _inputDimensions[0]
+        && dimensions[1] == _inputDimensions[1]
+        && dimensions[2] == _inputDimensions[2]
+        && _outputImageData->GetNumberOfScalarComponents() == 1
+        && (scalarType == VTK_CHAR || scalarType == VTK_SIGNED_CHAR || scalarType == VTK_UNSIGNED_CHAR)
+        && _outputImageData->GetScalarPointer() != NULL;
+    if (!fits) {
+        _outputImageData->SetDimensions(_inputDimensions);
+        _outputImageData->AllocateScalars(VTK_CHAR, 1);
+    }
+    _outputImageData->SetSpacing(_inputImageData->GetSpacing());
+    _outputImageData->SetOrigin(_inputImageData->GetOrigin());
     
-    double minimum 				= VTK_DOUBLE_MAX;
-    double maximum 				= VTK_DOUBLE_MIN;
-    double mean 				= 0.0;
-    double variance 			= 0.0;
-    double foregroundMean 		= VTK_DOUBLE_MIN;
-    double foregroundVariance 	= 0.0;
-    double backgroundMean 		= VTK_DOUBLE_MIN;
-    double backgroundVariance 	= 0.0;
+    char* labels = static_cast<char*>(_outputImageData->GetScalarPointer());
+    std::copy(_coarseLabels.begin(), _coarseLabels.end(), labels);
     
+    LabelsFunctor labelsFunctor;
+    labelsFunctor.nodes = _nodes;
+    labelsFunctor.dimensions = _dimensions;
+    labelsFunctor.inputDimensions = _inputDimensions;
+    labelsFunctor.graphOffset = _graphOffset;
+    labelsFunctor.labels = labels;
+    vtkSMPTools::For(0, _dimensions[2], labelsFunctor);
+    _outputImageData->Modified();
+}
+
+
+/**
+ * Sets the capacities of the edges to those of the cost function.
+ * The capacities of the edges between nodes are only calculated when
+ * @p calculateRegionalCapacities is set; otherwise only those of the
+ * terminal edges are.
+ */
+void vtkGraphCutProtected::CalculateCapacitiesForEdges(bool calculateRegionalCapacities) {
+    vtkGraphCutCostFunction* costFunction = GetCurrentCostFunction();
+    costFunction->SetInput(_inputImageData);
+    costFunction->SetSeedPoints(_foregroundPoints, _backgroundPoints);
+    costFunction->Update();
+    
+    // Every edge belongs to exactly one slice: the slice of its node
+    // with the lowest index. Slices can thus be done in parallel.
+    EdgeCapacitiesFunctor capacitiesFunctor;
+    capacitiesFunctor.costFunction = costFunction;
+    capacitiesFunctor.dimensions = _dimensions;
+    capacitiesFunctor.inputDimensions = _inputDimensions;
+    capacitiesFunctor.graphOffset = _graphOffset;
+    capacitiesFunctor.coarseLabels = _coarseLabels.empty() ? NULL : &_coarseLabels[0];
+    capacitiesFunctor.maximumDistance = _connectivity == SIX ? 1 : (_connectivity == EIGHTEEN ? 2 : 3);
+    capacitiesFunctor.nodes = _nodes;
+    capacitiesFunctor.edges = _edges;
+    capacitiesFunctor.calculateRegionalCapacities = calculateRegionalCapacities;
+    std::vector<int> sliceMaximumCapacities(_dimensions[2], 0);
+    capacitiesFunctor.maximumCapacities = &sliceMaximumCapacities[0];
+    vtkSMPTools::For(0, _dimensions[2], capacitiesFunctor);
+    
+    // A terminal capacity that is larger than the sum of all the
+    // capacities around a node is never part of a minimum cut. With
+    // a band the capacities of all the edges are calculated.
+    if (calculateRegionalCapacities || _nodes->HasBand()) {
+        int maximumCapacity = *std::max_element(sliceMaximumCapacities.begin(), sliceMaximumCapacities.end());
+        _seedCapacity = 1 + (int)_connectivity * maximumCapacity;
+    }
+    PinSeedPoints(_foregroundPoints, TREE_SOURCE, _seedCapacity);
+    PinSeedPoints(_backgroundPoints, TREE_SINK, _seedCapacity);
+}
+
+
+/**
+ * Returns the cost function that was set or the default one. When
+ * capacity images are set, these are read first.
+ */
+vtkGraphCutCostFunction* vtkGraphCutProtected::GetCurrentCostFunction() {
+    vtkGraphCutCostFunction* costFunction = _costFunction ? _costFunction : _defaultCostFunction;
+    if (!_imagesCostFunction->HasImages()) {
+        return costFunction;
+    }
+    _imagesCostFunction->SetFallbackCostFunction(costFunction);
+    return _imagesCostFunction;
+}
+
+
+/**
+ * Returns the index of the node at the voxel of @p point or
+ * NODE_NONE when the point lies outside of the graph.
+ */
+NodeIndex vtkGraphCutProtected::NodeIndexForPoint(double* point) {
+    int coordinate[3];
+    for (int d = 0; d < 3; ++d) {
+        coordinate[d] = (int)point[d] - _graphOffset[d];
+        if (coordinate[d] < 0 || coordinate[d] >= _dimensions[d]) {
+            return NODE_NONE;
+        }
+    }
+    return _nodes->GetIndexForCoordinate(coordinate);
+}
+
+
+/**
+ * Returns the index of the voxel of @p point in the input or -1 when
+ * the point lies outside of it. The input has to be set.
+ */
+vtkIdType vtkGraphCutProtected::VoxelIndexForPoint(double* point) {
     int* dimensions = _inputImageData->GetDimensions();
-    for (int z = 0; z < dimensions[2]; ++z) {
-        for (int y = 0; y < dimensions[1]; ++y) {
-            for (int x = 0; x < dimensions[0]; ++x) {
-                double intensity = vtkGraphCutHelper::GetIntensityForVoxel(_inputImageData, x, y, z);
-                minimum = std::min(minimum, intensity);
-                maximum = std::max(maximum, intensity);
-                mean += intensity;
-            }
+    int coordinate[3];
+    for (int d = 0; d < 3; ++d) {
+        coordinate[d] = (int)point[d];
+        if (coordinate[d] < 0 || coordinate[d] >= dimensions[d]) {
+            return -1;
         }
     }
-    
-    if (minimum == maximum) {
-        vtkWarningMacro("Warning: all nodes have the same intensity.");
-        return;
+    return coordinate[0] + (vtkIdType)dimensions[0]
+        * (coordinate[1] + (vtkIdType)dimensions[1] * coordinate[2]);
+}
+
+
+/**
+ * Ties the nodes at the given seed @p points to the terminal of
+ * @p tree: the edge to that terminal gets @p capacity and the edge to
+ * the other terminal gets no capacity. Points that lie outside of
+ * the volume are ignored.
+ */
+void vtkGraphCutProtected::PinSeedPoints(vtkPoints* points, vtkTreeType tree, int capacity) {
+    for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i) {
+        NodeIndex nodeIndex = NodeIndexForPoint(points->GetPoint(i));
+        if (nodeIndex == NODE_NONE) {
+            continue;
+        }
+        _nodes->GetNode(nodeIndex).seedPoint = true;
+        SetTerminalCapacities(nodeIndex,
+                              tree == TREE_SOURCE ? capacity : 0,
+                              tree == TREE_SINK ? capacity : 0);
     }
+}
+
+
+/**
+ * Removes all the points from @p points that lie in the same voxel
+ * as one of the @p removedPoints. The nodes of these voxels are
+ * added to @p removedNodes.
+ */
+/**
+ * Gives the nodes whose seed points were added or removed the terminal
+ * capacities of a full update. A node is pinned to the sink when its
+ * voxel is a background point and otherwise to the source when it is a
+ * foreground point. Nodes that are no seed points anymore get the
+ * capacities of the cost function, with the statistics of the last full
+ * update.
+ */
+void vtkGraphCutProtected::UpdateSeedNodes(std::vector<NodeIndex>* nodeIndices) {
+    std::sort(nodeIndices->begin(), nodeIndices->end());
+    nodeIndices->erase(std::unique(nodeIndices->begin(), nodeIndices->end()), nodeIndices->end());
     
-    int numberOfVoxels = dimensions[0] + dimensions[1] * dimensions[2];
-    mean = mean / (double)(numberOfVoxels);
-    
-    for (int z = 0; z < dimensions[2]; ++z) {
-        for (int y = 0; y < dimensions[1]; ++y) {
-            for (int x = 0; x < dimensions[0]; ++x) {
-                double intensity = vtkGraphCutHelper::GetIntensityForVoxel(_inputImageData, x, y, z);
-                variance += pow(intensity - mean, 2);
+    // The background points are checked last, as they are pinned last
+    std::vector<vtkTreeType> trees(nodeIndices->size(), TREE_NONE);
+    vtkPoints* seedPoints[2] = {_foregroundPoints, _backgroundPoints};
+    vtkTreeType seedTrees[2] = {TREE_SOURCE, TREE_SINK};
+    for (int s = 0; s < 2; ++s) {
+        for (vtkIdType i = 0; i < seedPoints[s]->GetNumberOfPoints(); ++i) {
+            NodeIndex nodeIndex = NodeIndexForPoint(seedPoints[s]->GetPoint(i));
+            std::vector<NodeIndex>::iterator position = std::lower_bound(nodeIndices->begin(), nodeIndices->end(), nodeIndex);
+            if (position != nodeIndices->end() && *position == nodeIndex) {
+                trees[position - nodeIndices->begin()] = seedTrees[s];
             }
         }
     }
     
-    variance = sqrt(variance / (double)(numberOfVoxels - 1));
-    
-    // Reset the statistics
-    foregroundMean = 0.0;
-    backgroundMean = 0.0;
-    foregroundVariance = 0.0;
-    backgroundVariance = 0.0;
+    for (size_t i = 0; i < nodeIndices->size(); ++i) {
+        NodeIndex nodeIndex = (*nodeIndices)[i];
+        Node node = _nodes->GetNode(nodeIndex);
+        if (trees[i] != TREE_NONE) {
+            node.seedPoint = true;
+            SetTerminalCapacities(nodeIndex,
+                                  trees[i] == TREE_SOURCE ? _seedCapacity : 0,
+                                  trees[i] == TREE_SINK ? _seedCapacity : 0);
+        } else if (node.seedPoint) {
+            node.seedPoint = false;
+            int sourceCapacity = 0;
+            int sinkCapacity = 0;
+            GetCurrentCostFunction()->CalculateTerminalCapacities(nodeIndex, 1, &sourceCapacity, &sinkCapacity);
+            SetTerminalCapacities(nodeIndex, sourceCapacity, sinkCapacity);
+        }
+    }
+}
+
+
+void vtkGraphCutProtected::RemovePoints(vtkPoints* points, vtkPoints* removedPoints, std::vector<NodeIndex>* removedNodes) {
+    // Voxels are compared instead of nodes, because the graph may not
+    // cover the whole input
+    std::vector<vtkIdType> voxels;
+    std::vector<NodeIndex> nodes;
+    for (vtkIdType i = 0; i < removedPoints->GetNumberOfPoints(); ++i) {
+        double* point = removedPoints->GetPoint(i);
+        vtkIdType voxelIndex = VoxelIndexForPoint(point);
+        if (voxelIndex >= 0) {
+            voxels.push_back(voxelIndex);
+        }
+        NodeIndex nodeIndex = NodeIndexForPoint(point);
+        if (nodeIndex != NODE_NONE) {
+            nodes.push_back(nodeIndex);
+        }
+    }
+    std::sort(voxels.begin(), voxels.end());
     
-    // Calculate the mean color of the foreground nodes
-    int numberOfForegroundPoints = _foregroundPoints->GetNumberOfPoints();
-    for (int i = 0; i < numberOfForegroundPoints; ++i) {
-        double* xyz = _foregroundPoints->GetPoint(i);
-        double foregroundIntensity = vtkGraphCutHelper::GetIntensityForVoxel(_inputImageData, xyz);
-        foregroundMean += foregroundIntensity / (double)numberOfForegroundPoints;
-        foregroundVariance += (foregroundIntensity * foregroundIntensity) / (double)numberOfForegroundPoints;
+    std::vector<double> keptPoints;
+    for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i) {
+        double* point = points->GetPoint(i);
+        vtkIdType voxelIndex = VoxelIndexForPoint(point);
+        if (voxelIndex >= 0 && std::binary_search(voxels.begin(), voxels.end(), voxelIndex)) {
+            continue;
+        }
+        keptPoints.insert(keptPoints.end(), point, point + 3);
     }
     
-    // Calculate the mean color of the background nodes
-    int numberOfBackgroundPoints = _backgroundPoints->GetNumberOfPoints();
-    for (int i = 0; i < numberOfBackgroundPoints; ++i) {
-        double* xyz = _backgroundPoints->GetPoint(i);
-        double backgroundIntensity = vtkGraphCutHelper::GetIntensityForVoxel(_inputImageData, xyz);
-        backgroundMean += backgroundIntensity / (double)numberOfBackgroundPoints;
-        backgroundVariance += (backgroundIntensity * backgroundIntensity) / (double)numberOfBackgroundPoints;
+    points->Reset();
+    for (size_t i = 0; i < keptPoints.size(); i += 3) {
+        points->InsertNextPoint(keptPoints[i], keptPoints[i + 1], keptPoints[i + 2]);
     }
+    points->Modified();
+    removedNodes->insert(removedNodes->end(), nodes.begin(), nodes.end());
+}
+
+
+/**
+ * Changes the capacities of the terminal edges of a node while
+ * keeping the current flow valid. The net flow that the node gets
+ * from the terminals is kept, so the flow through the other edges of
+ * the node stays conserved. When the new capacities are too small
+ * for that, the same amount is added to both terminal edges, which
+ * adds the same cost to every cut. When the trees exist, the node is
+ * moved to the root of the tree that it is now connected to.
+ */
+void vtkGraphCutProtected::SetTerminalCapacities(NodeIndex nodeIndex, int sourceCapacity, int sinkCapacity) {
+    Edge sourceEdge = _edges->EdgeFromNodeToNode(NODE_SOURCE, nodeIndex);
+    Edge sinkEdge = _edges->EdgeFromNodeToNode(nodeIndex, NODE_SINK);
     
-    foregroundVariance -= (foregroundMean * foregroundMean);
-    foregroundVariance = sqrt(foregroundVariance);
+    int excess = sourceEdge.flowFromNode(NODE_SOURCE) - sinkEdge.flowFromNode(nodeIndex);
+    if (excess > sourceCapacity) {
+        sinkCapacity += excess - sourceCapacity;
+        sourceCapacity = excess;
+    } else if (-excess > sinkCapacity) {
+        sourceCapacity += -excess - sinkCapacity;
+        sinkCapacity = -excess;
+    }
     
-    backgroundVariance -= (backgroundMean * backgroundMean);
-    backgroundVariance = sqrt(backgroundVariance);
+    sourceEdge.setCapacity(sourceCapacity);
+    sinkEdge.setCapacity(sinkCapacity);
+    sourceEdge.addFlowFromNode(NODE_SOURCE, -sourceEdge.flowFromNode(NODE_SOURCE));
+    sinkEdge.addFlowFromNode(nodeIndex, -sinkEdge.flowFromNode(nodeIndex));
+    if (excess > 0) {
+        sourceEdge.addFlowFromNode(NODE_SOURCE, excess);
+    } else if (excess < 0) {
+        sinkEdge.addFlowFromNode(nodeIndex, -excess);
+    }
     
-    if (numberOfForegroundPoints == 1) {
-        // foregroundVariance = 0.0004;
-        foregroundVariance = variance;
+    if (!_sourceTree) {
+        return;
     }
-    if (numberOfBackgroundPoints == 1) {
-        // backgroundVariance = 0.0004;
-        backgroundVariance = variance;
+    
+    // Push the flow that can go straight through the node, like
+    // InitializeTrees does, so it has at most one terminal left
+    int sourceResidual = sourceEdge.capacityFromNode(NODE_SOURCE);
+    int sinkResidual = sinkEdge.capacityFromNode(nodeIndex);
+    int flow = std::min(sourceResidual, sinkResidual);
+    if (flow > 0) {
+        sourceEdge.addFlowFromNode(NODE_SOURCE, flow);
+        sinkEdge.addFlowFromNode(nodeIndex, flow);
+        sourceResidual -= flow;
+        sinkResidual -= flow;
     }
     
-    Nodestatistics statistics;
-    statistics.minimum = minimum;
-    statistics.maximum = maximum;
-    statistics.mean = mean;
-    statistics.variance = variance;
-    statistics.foregroundMean = foregroundMean;
-    statistics.foregroundVariance = foregroundVariance;
-    statistics.backgroundMean = backgroundMean;
-    statistics.backgroundVariance = backgroundVariance;
+    Node node = _nodes->GetNode(nodeIndex);
+    if (sourceResidual > 0) {
+        _sourceTree->AddChildToRoot(nodeIndex, _orphans);
+        _activeSourceNodes->Push(nodeIndex);
+    } else if (sinkResidual > 0) {
+        _sinkTree->AddChildToRoot(nodeIndex, _orphans);
+        _activeSinkNodes->Push(nodeIndex);
+    } else if (node.parent < 0 && node.tree != TREE_NONE && !node.orphan) {
+        // The node lost the edge to its root
+        node.orphan = true;
+        _orphans->push_back(nodeIndex);
+    }
+}
+
+
+/**
+ * Seeds both trees in a single pass over the nodes. Flow that can go
+ * straight from the source through a node to the sink is pushed
+ * right away, so that each node keeps residual capacity to at most
+ * one of the terminals. Free nodes with residual capacity left are
+ * added to the tree of that terminal and made active, so the seed
+ * points are part of their trees from the start.
+ */
+void vtkGraphCutProtected::InitializeTrees() {
+    _activeSourceNodes->Clear();
+    _activeSinkNodes->Clear();
     
-    for (std::vector<Edge*>::iterator i = _edges->GetBegin(); i != _edges->GetEnd(); ++i) {
-        double capacity = vtkGraphCutHelper::CalculateCapacity(_inputImageData, *i, statistics);
-        int cap = (int)(255.0 * capacity) + 1;
-        (*i)->setCapacity(cap);
+    int numberOfNodes = _nodes->GetSize();
+    for (int index = 0; index < numberOfNodes; ++index) {
+        NodeIndex nodeIndex = (NodeIndex)index;
+        if (_nodes->GetNode(nodeIndex).tree != TREE_NONE) {
+            continue;
+        }
+        
+        // The source edge of a node comes first, then the sink edge
+        EdgeIndex sourceEdgeIndex = _edges->FirstEdgeIndexForNode(nodeIndex);
+        ArcIndex sourceArc = (ArcIndex)(2 * sourceEdgeIndex);
+        ArcIndex sinkArc = (ArcIndex)(2 * (sourceEdgeIndex + 1));
+        int sourceResidual = _edges->ResidualCapacityForArc(sourceArc);
+        int sinkResidual = _edges->ResidualCapacityForArc(sinkArc);
+        
+        int flow = std::min(sourceResidual, sinkResidual);
+        if (flow > 0) {
+            _edges->PushFlowThroughArc(sourceArc, flow);
+            _edges->PushFlowThroughArc(sinkArc, flow);
+            sourceResidual -= flow;
+            sinkResidual -= flow;
+        }
+        
+        if (sourceResidual > 0) {
+            _sourceTree->AddChildToParent(nodeIndex, NODE_SOURCE);
+            _activeSourceNodes->Push(nodeIndex);
+        } else if (sinkResidual > 0) {
+            _sinkTree->AddChildToParent(nodeIndex, NODE_SINK);
+            _activeSinkNodes->Push(nodeIndex);
+        }
     }
+
 }
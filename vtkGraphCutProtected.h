@@ -14,20 +14,18 @@ class vtkPoints;
 class Edge;
 class Edges;
 class vtkGraphCutCostFunction;
+class vtkGraphCutCostFunctionImages;
 class Node;
 class Nodes;
 class Tree;
-class TreeDepthComparator;
+class ActiveNodes;
 
 
 #include <vtkObjectFactory.h>
 #include <vector>
-#include <queue>
 #include "vtkGraphCutDefinitions.h"
 #include "vtkGraphCutDataTypes.h"
 
-typedef std::priority_queue<std::pair<int, NodeIndex>, std::vector<std::pair<int, NodeIndex> >, TreeDepthComparator> PriorityQueue;
-
 class VTK_EXPORT vtkGraphCutProtected: public vtkObject
 {
 public:
@@ -35,25 +33,127 @@ public:
     void PrintSelf(ostream& os, vtkIndent indent);
     
     void Reset();
+    
+    /**
+     * Segments the input. The graph of the last update is used again
+     * when the dimensions and the connectivity did not change, and
+     * only the capacities that depend on modified inputs are
+     * calculated again. Call Modified() on the input or the seed
+     * points after changing their contents.
+     */
     void Update();
     
     vtkImageData* GetOutput();
+    
+    /**
+     * Sets the image that the labels are written to. The image is kept
+     * and written to again by every update, as long as it has the
+     * dimensions of the input, a single component and a char, signed
+     * char or unsigned char scalar type; otherwise it is allocated
+     * again as a char image. In an unsigned char image the background
+     * label -1 reads as 255. Without an output image one is created
+     * by the first update and reused by the next ones.
+     */
+    void SetOutput(vtkImageData*);
     void SetInput(vtkImageData *);
     vtkImageData* GetInput();
     void SetSeedPoints(vtkPoints *foreground, vtkPoints *background);
+    
+    /**
+     * Adds points to or removes points from the fore- and background
+     * seed points. Either argument may be NULL. After an update, only
+     * the terminal capacities of the affected nodes are changed, so
+     * the next update continues from the current flow and trees
+     * instead of solving from scratch.
+     */
+    void AddSeedPoints(vtkPoints *foreground, vtkPoints *background);
+    void RemoveSeedPoints(vtkPoints *foreground, vtkPoints *background);
     void SetCostFunction(vtkGraphCutCostFunction*);
     vtkGraphCutCostFunction* GetCostFunction();
+    
+    /**
+     * Optional images with precomputed capacities, which are read
+     * directly instead of being calculated by the cost function. See
+     * vtkGraphCutCostFunctionImages for their contents.
+     */
+    void SetSourceCapacityImage(vtkImageData*);
+    vtkImageData* GetSourceCapacityImage();
+    void SetSinkCapacityImage(vtkImageData*);
+    vtkImageData* GetSinkCapacityImage();
+    void SetBoundaryImage(vtkImageData*);
+    vtkImageData* GetBoundaryImage();
     void SetConnectivity(vtkConnectivity);
     vtkConnectivity GetConnectivity();
     
+    /**
+     * Sets the algorithm that finds the maximum flow. All solvers give
+     * the same segmentation. Only BOYKOV_KOLMOGOROV, the default, reuses
+     * the flow of the last update when seed points are added or removed.
+     */
+    void SetSolver(vtkSolverType);
+    vtkSolverType GetSolver();
+    
+    /**
+     * Sets the number of slabs that PARALLEL_PUSH_RELABEL splits the
+     * volume into. Half of them are solved at the same time, so there
+     * should be at least twice as many as there are threads. Slabs are
+     * at least two slices thick. 0, the default, picks a number from
+     * the size of the volume.
+     */
+    void SetNumberOfRegions(int);
+    int GetNumberOfRegions();
+    
+    /**
+     * Lets BOYKOV_KOLMOGOROV grow the source and the sink tree at the
+     * same time, on the threads of vtkSMPTools. The neighbours of
+     * batches of active nodes are scanned in parallel; adding them to
+     * the trees, augmenting and adopting are still done on one thread.
+     * Off by default.
+     */
+    void SetParallelGrowth(bool);
+    bool GetParallelGrowth();
+    
+    /**
+     * Sets the number of resolutions that the input is segmented at.
+     * With more than one level, the input and the seed points are
+     * halved in size and segmented first, with one level less. Only
+     * the voxels within the band width of the boundary of that
+     * segmentation are segmented again at full resolution; the other
+     * voxels keep its labels and get no node in the graph, so memory
+     * and time follow the size of the band. The capacity images are
+     * scaled down with the input, and every update solves from
+     * scratch. 1, the default, segments the whole input at full
+     * resolution.
+     */
+    void SetNumberOfLevels(int);
+    int GetNumberOfLevels();
+    
+    /**
+     * Sets how many voxels on either side of the boundary of the
+     * coarser segmentation are segmented again. 2 by default.
+     */
+    void SetBandWidth(int);
+    int GetBandWidth();
+    
     vtkPoints* GetForegroundPoints();
     vtkPoints* GetBackgroundPoints();
     
 protected:
     // Algorithm methods
-    EdgeIndex Grow(vtkTreeType tree, bool& foundActiveNodes, PriorityQueue* activeNodes);
+    // The kernels that visit neighbours are instantiated for each
+    // connectivity; Update dispatches to the right one.
+    template <vtkConnectivity Connectivity>
+    void MaxFlow();
+    template <vtkConnectivity Connectivity>
+    EdgeIndex Grow(vtkTreeType tree, bool& foundActiveNodes);
+    template <vtkConnectivity Connectivity>
+    EdgeIndex GrowInParallel();
     std::vector<NodeIndex>* Augment(EdgeIndex edgeIndex);
+    template <vtkConnectivity Connectivity>
     void Adopt(std::vector<NodeIndex>*);
+    template <vtkConnectivity Connectivity>
+    void SolveFromZeroFlow();
+    void SolveCoarseLevel();
     
     vtkGraphCutProtected();
     ~vtkGraphCutProtected();
@@ -66,19 +166,74 @@ protected:
 
     Tree* _sourceTree;
     Tree* _sinkTree;
+    
+    ActiveNodes* _activeSourceNodes;
+    ActiveNodes* _activeSinkNodes;
 
     std::vector<NodeIndex>* _orphans;
+    
+    // The batch of active nodes of parallel growth, with the tree that
+    // every node was in and the neighbours it could grow into when it
+    // was scanned. The positions tell where growth carries on after an
+    // augmentation.
+    std::vector<NodeIndex> _growthNodes;
+    std::vector<vtkTreeType> _growthTrees;
+    std::vector<NodeIndex> _growthCandidates;
+    std::vector<int> _growthCandidateCounts;
+    int _growthPosition;
+    int _growthCandidatePosition;
 
     vtkPoints* _foregroundPoints;
     vtkPoints* _backgroundPoints;
     
     vtkGraphCutCostFunction* _costFunction;
+    // Used when no cost function is set
+    vtkGraphCutCostFunction* _defaultCostFunction;
+    // Reads the capacity images and asks the rest from the other
+    // cost function
+    vtkGraphCutCostFunctionImages* _imagesCostFunction;
     
     int _dimensions[3];
     vtkConnectivity _connectivity;
+    vtkSolverType _solver;
+    int _numberOfRegions;
+    bool _parallelGrowth;
+    int _numberOfLevels;
+    int _bandWidth;
+    
+    // With more than one level the graph only has nodes for the band
+    // around the boundary of the coarser segmentation: _dimensions are
+    // those of the box around the band and _graphOffset is its first
+    // voxel. The coarse labels of the whole input are kept; _band marks
+    // the voxels of the box in the band until the nodes are made.
+    int _inputDimensions[3];
+    int _graphOffset[3];
+    std::vector<char> _coarseLabels;
+    std::vector<char> _band;
+    
+    // Kept to pin seed points that are added after an update
+    int _seedCapacity;
+    
+    // Modification times of the inputs at the last update, which tell
+    // what parts of the graph have to be calculated again
+    vtkMTimeType _inputMTime;
+    vtkMTimeType _seedPointsMTime;
+    vtkMTimeType _costFunctionMTime;
     
 private:
-    void CalculateCapacitiesForEdges();
+    void ClearSolution();
+    void ClearGraph();
+    vtkMTimeType GetSeedPointsMTime();
+    void CalculateCapacitiesForEdges(bool calculateRegionalCapacities);
+    void UpdateOutput();
+    vtkGraphCutCostFunction* GetCurrentCostFunction();
+    NodeIndex NodeIndexForPoint(double* point);
+    vtkIdType VoxelIndexForPoint(double* point);
+    void PinSeedPoints(vtkPoints* points, vtkTreeType tree, int capacity);
+    void UpdateSeedNodes(std::vector<NodeIndex>* nodeIndices);
+    void RemovePoints(vtkPoints* points, vtkPoints* removedPoints, std::vector<NodeIndex>* removedNodes);
+    void SetTerminalCapacities(NodeIndex nodeIndex, int sourceCapacity, int sinkCapacity);
+    void InitializeTrees();
 };
 
 #endif /* vtkGraphCutProtected_h */